@@ -39,7 +39,6 @@
 
 /* Priority definitions for most of the tasks in the demo application. */
 #define mainCHECK_TASK_PRIORITY			( tskIDLE_PRIORITY + 3 )
-#define mainQUEUE_POLL_PRIORITY			( tskIDLE_PRIORITY + 2 )
 #define mainLED_BLINK_PRIORITY			( tskIDLE_PRIORITY + 2 )
 
 /* The period between executions of the check task. */
@@ -48,6 +47,24 @@
 /* The period to toggle LED. */
 #define mainBLINK_LED_OK_HALF_PERIOD	( ( TickType_t ) 100 )
 
+/* Load generator. mainLOAD_PAIRS producer/consumer pairs are started, with
+the item size and the priorities below.  A period of 0 makes the pairs run
+flat out, blocking on their queue, otherwise they poll their queue with that
+period.  Every mainCHECK_PERIOD the check task prints one line per pair with
+the messages per second and the latency from the post to the receive in
+microseconds, then one line with the rate of the integer maths task, which
+runs at the idle priority and so shows the time that is left over.
+
+The item size is at most pollqMAX_ITEM_SIZE.  The pairs are only limited by
+the heap: each one takes about 2 * ( configMINIMAL_STACK_SIZE +
+pollqMAX_ITEM_SIZE ) bytes of stack, two TCBs and a queue of 10 items.  The Uno sized heap fits one pair, use a bigger board or
+portUSE_AUTO_HEAP for more. */
+#define mainLOAD_PAIRS					( 1 )
+#define mainLOAD_ITEM_SIZE				( 8 )
+#define mainLOAD_PERIOD					( ( TickType_t ) 0 )
+#define mainLOAD_PRODUCER_PRIORITY		( tskIDLE_PRIORITY + 1 )
+#define mainLOAD_CONSUMER_PRIORITY		( tskIDLE_PRIORITY + 2 )
+
 /* The task function for the "Check" task. */
 static void vErrorChecks( void *pvParameters );
 
@@ -68,7 +85,11 @@ void setup( void )
 
 	/* Optionally enable below tests. This port only has 2KB RAM. */
 	vStartIntegerMathTasks( tskIDLE_PRIORITY );
-	vStartPolledQueueTasks( mainQUEUE_POLL_PRIORITY );
+
+	for( UBaseType_t uxPair = 0; uxPair < mainLOAD_PAIRS; uxPair++ )
+	{
+		xStartPolledQueuePair( mainLOAD_PRODUCER_PRIORITY, mainLOAD_CONSUMER_PRIORITY, mainLOAD_ITEM_SIZE, mainLOAD_PERIOD );
+	}
 	xTaskCreate( vBlinkOnboardUserLED, "LED", 50, NULL, mainCHECK_TASK_PRIORITY, NULL );
 
 	/* Create the tasks defined within this file. */
@@ -89,6 +110,44 @@ void loop( void )
 }
 /*-----------------------------------------------------------*/
 
+static void vPrintLoad( void )
+{
+PollQStats_t xStats;
+UBaseType_t uxPair;
+uint32_t ulSeconds = mainCHECK_PERIOD * portTICK_PERIOD_MS / 1000UL;
+
+	if( ulSeconds == 0 )
+	{
+		ulSeconds = 1;
+	}
+
+	for( uxPair = 0; uxPair < uxGetPolledQueuePairs(); uxPair++ )
+	{
+		vGetPolledQueueStats( uxPair, &xStats );
+
+		Serial.print( F( "load pair=" ) );
+		Serial.print( uxPair );
+		Serial.print( F( " size=" ) );
+		Serial.print( mainLOAD_ITEM_SIZE );
+		Serial.print( F( " msgs/s=" ) );
+		Serial.print( xStats.ulMessages / ulSeconds );
+		Serial.print( F( " lat_avg_us=" ) );
+		Serial.print( ( xStats.ulMessages != 0 ) ? xStats.ulLatencySum / xStats.ulMessages : 0 );
+		Serial.print( F( " lat_max_us=" ) );
+		Serial.print( xStats.ulLatencyMax );
+		Serial.print( F( " send_fail=" ) );
+		Serial.print( xStats.ulSendFailures );
+		Serial.print( F( " errors=" ) );
+		Serial.println( xStats.ulErrors );
+	}
+
+	Serial.print( F( "load pairs=" ) );
+	Serial.print( uxGetPolledQueuePairs() );
+	Serial.print( F( " intmath/s=" ) );
+	Serial.println( ulGetIntegerMathsIterations() / ulSeconds );
+}
+/*-----------------------------------------------------------*/
+
 static void vErrorChecks( void *pvParameters )
 {
 static UBaseType_t uxErrorHasOccurred = 0;
@@ -124,6 +183,7 @@ BaseType_t xFirstTimeCheck = pdTRUE;
         else
         {
             Serial.println( uxErrorHasOccurred, BIN );
+            vPrintLoad();
         }
 
 		/* Could set break point at below line to verify uxErrorHasOccurred. */
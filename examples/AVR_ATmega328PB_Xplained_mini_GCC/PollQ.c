@@ -30,22 +30,29 @@
  * space and no display facilities.  The complete version can be found in
  * the Demo/Common/Full directory.
  *
- * Creates two tasks that communicate over a single queue.  One task acts as a
- * producer, the other a consumer.
+ * Creates pairs of tasks that communicate over a queue each.  One task acts as
+ * a producer, the other a consumer.  The priorities of both tasks, the size of
+ * the items and the period are set per pair, so the pairs can be used as a
+ * configurable load.
  *
- * The producer loops for three iteration, posting an incrementing number onto the
- * queue each cycle.  It then delays for a fixed period before doing exactly the
- * same again.
+ * With a period other than 0, the producer loops for three iteration, posting
+ * an incrementing number onto the queue each cycle.  It then delays for the
+ * period before doing exactly the same again.  The consumer loops emptying the
+ * queue, then blocks for the period.  All queue access is performed without
+ * blocking.  Under load the producer can find the queue full, which is counted
+ * as a send failure and the item is dropped.
  *
- * The consumer loops emptying the queue.  Each item removed from the queue is
- * checked to ensure it contains the expected value.  When the queue is empty it
- * blocks for a fixed period, then does the same again.
+ * With a period of 0, the producer posts as fast as it can and blocks while
+ * the queue is full, the consumer blocks while the queue is empty.  The pair
+ * then runs at the highest rate the kernel allows and consumes all the time
+ * its priority gets.
  *
- * All queue access is performed without blocking.  The consumer completely empties
- * the queue each time it runs so the producer should never find the queue full.
+ * Each item starts with the incrementing number and the micros() time it was
+ * posted at, the rest of it is padding.  The consumer counts the messages and
+ * the latency from the post to the receive of each one, which can be read with
+ * vGetPolledQueueStats().
  *
- * An error is flagged if the consumer obtains an unexpected value or the producer
- * find the queue is full.
+ * An error is flagged if the consumer obtains an unexpected value.
  */
 
 /*
@@ -56,6 +63,7 @@ Changes from V2.0.0
 */
 
 #include <stdlib.h>
+#include <string.h>
 
 /* Scheduler include files. */
 #include "FreeRTOS.h"
@@ -65,76 +73,141 @@ Changes from V2.0.0
 /* Demo program include files. */
 #include "PollQ.h"
 
+#include <Arduino.h>
+
 #define pollqSTACK_SIZE         configMINIMAL_STACK_SIZE
 #define pollqQUEUE_SIZE         ( 10 )
-#define pollqPRODUCER_DELAY     ( TickType_t ) 200 / portTICK_PERIOD_MS
-#define pollqCONSUMER_DELAY     ( TickType_t ) 200 / portTICK_PERIOD_MS
+#define pollqPERIOD             ( TickType_t ) 200 / portTICK_PERIOD_MS
 #define pollqNO_DELAY           ( ( TickType_t ) 0 )
 #define pollqVALUES_TO_PRODUCE  ( ( BaseType_t ) 3 )
 #define pollqINITIAL_VALUE      ( ( BaseType_t ) 0 )
 
-/* The task that posts the incrementing number onto the queue. */
-static portTASK_FUNCTION_PROTO( vPolledQueueProducer, pvParameters );
+/* Header at the start of each item. */
+typedef struct POLLQ_ITEM_HEADER
+{
+    uint16_t usValue;
+    uint32_t ulPostTime;
+} xPollQItemHeader;
+
+/* State of one producer/consumer pair. */
+typedef struct POLLQ_PAIR
+{
+    QueueHandle_t xQueue;
+    TickType_t xPeriod;
+    PollQStats_t xStats;
+} xPollQPair;
 
-/* The task that empties the queue. */
+static portTASK_FUNCTION_PROTO( vPolledQueueProducer, pvParameters );
 static portTASK_FUNCTION_PROTO( vPolledQueueConsumer, pvParameters );
 
 /* Variables that are used to check that the tasks are still running with no
 errors. */
 static volatile BaseType_t xPollingConsumerCount = pollqINITIAL_VALUE, xPollingProducerCount = pollqINITIAL_VALUE;
 
+/* The pairs started so far. */
+static xPollQPair *pxPairs[ pollqMAX_PAIRS ];
+static UBaseType_t uxPairCount = 0;
+
 /*-----------------------------------------------------------*/
 
 void vStartPolledQueueTasks( UBaseType_t uxPriority )
 {
-static QueueHandle_t xPolledQueue;
+    ( void ) xStartPolledQueuePair( uxPriority, uxPriority, sizeof( uint16_t ), pollqPERIOD );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStartPolledQueuePair( UBaseType_t uxProducerPriority, UBaseType_t uxConsumerPriority, UBaseType_t uxItemSize, TickType_t xPeriod )
+{
+xPollQPair *pxPair;
+
+    if( uxPairCount >= pollqMAX_PAIRS )
+    {
+        return -1;
+    }
+
+    /* Every item holds at least the header, and fits the item buffer of the
+    tasks. */
+    if( uxItemSize < sizeof( xPollQItemHeader ) )
+    {
+        uxItemSize = sizeof( xPollQItemHeader );
+    }
+
+    if( uxItemSize > pollqMAX_ITEM_SIZE )
+    {
+        return -1;
+    }
+
+    pxPair = ( xPollQPair * ) pvPortMalloc( sizeof( xPollQPair ) );
+
+    if( pxPair == NULL )
+    {
+        return -1;
+    }
+
+    memset( pxPair, 0, sizeof( xPollQPair ) );
+    pxPair->xPeriod = xPeriod;
 
     /* Create the queue used by the producer and consumer. */
-    xPolledQueue = xQueueCreate( pollqQUEUE_SIZE, ( UBaseType_t ) sizeof( uint16_t ) );
+    pxPair->xQueue = xQueueCreate( pollqQUEUE_SIZE, uxItemSize );
 
-    if( xPolledQueue != NULL )
+    if( pxPair->xQueue == NULL )
     {
-        /* vQueueAddToRegistry() adds the queue to the queue registry, if one is
-        in use.  The queue registry is provided as a means for kernel aware
-        debuggers to locate queues and has no purpose if a kernel aware debugger
-        is not being used.  The call to vQueueAddToRegistry() will be removed
-        by the pre-processor if configQUEUE_REGISTRY_SIZE is not defined or is
-        defined to be less than 1. */
-        vQueueAddToRegistry( xPolledQueue, "Poll_Test_Queue" );
-
-        /* Spawn the producer and consumer. */
-        xTaskCreate( vPolledQueueConsumer, "QConsNB", pollqSTACK_SIZE, ( void * ) &xPolledQueue, uxPriority, ( TaskHandle_t * ) NULL );
-        xTaskCreate( vPolledQueueProducer, "QProdNB", pollqSTACK_SIZE, ( void * ) &xPolledQueue, uxPriority, ( TaskHandle_t * ) NULL );
+        vPortFree( pxPair );
+        return -1;
     }
+
+    /* vQueueAddToRegistry() adds the queue to the queue registry, if one is
+    in use.  The queue registry is provided as a means for kernel aware
+    debuggers to locate queues and has no purpose if a kernel aware debugger
+    is not being used.  The call to vQueueAddToRegistry() will be removed
+    by the pre-processor if configQUEUE_REGISTRY_SIZE is not defined or is
+    defined to be less than 1. */
+    vQueueAddToRegistry( pxPair->xQueue, "Poll_Test_Queue" );
+
+    /* Spawn the producer and consumer. The item is a local variable of both. */
+    xTaskCreate( vPolledQueueConsumer, "QConsNB", pollqSTACK_SIZE + pollqMAX_ITEM_SIZE, ( void * ) pxPair, uxConsumerPriority, ( TaskHandle_t * ) NULL );
+    xTaskCreate( vPolledQueueProducer, "QProdNB", pollqSTACK_SIZE + pollqMAX_ITEM_SIZE, ( void * ) pxPair, uxProducerPriority, ( TaskHandle_t * ) NULL );
+
+    pxPairs[ uxPairCount ] = pxPair;
+
+    return ( BaseType_t ) uxPairCount++;
 }
 /*-----------------------------------------------------------*/
 
 static portTASK_FUNCTION( vPolledQueueProducer, pvParameters )
 {
+xPollQPair *pxPair = ( xPollQPair * ) pvParameters;
+uint8_t ucItem[ pollqMAX_ITEM_SIZE ];
+xPollQItemHeader xHeader;
 uint16_t usValue = ( uint16_t ) 0;
-BaseType_t xError = pdFALSE, xLoop;
+BaseType_t xLoop;
+
+    memset( ucItem, 0, sizeof( ucItem ) );
 
     for( ;; )
     {
         for( xLoop = 0; xLoop < pollqVALUES_TO_PRODUCE; xLoop++ )
         {
-            /* Send an incrementing number on the queue without blocking. */
-            if( xQueueSend( *( ( QueueHandle_t * ) pvParameters ), ( void * ) &usValue, pollqNO_DELAY ) != pdPASS )
+            xHeader.usValue = usValue;
+            xHeader.ulPostTime = micros();
+            memcpy( ucItem, &xHeader, sizeof( xHeader ) );
+
+            /* Send an incrementing number on the queue. Only the pairs without
+            a period block while the queue is full. */
+            if( xQueueSend( pxPair->xQueue, ( void * ) ucItem, ( pxPair->xPeriod == 0 ) ? portMAX_DELAY : pollqNO_DELAY ) != pdPASS )
             {
-                /* We should never find the queue full so if we get here there
-                has been an error. */
-                xError = pdTRUE;
+                /* The queue is full, the consumer does not keep up.  That is
+                the backpressure of the load rather than an error, the value
+                is posted again next time. */
+                portENTER_CRITICAL();
+                    pxPair->xStats.ulSendFailures++;
+                portEXIT_CRITICAL();
             }
             else
             {
-                if( xError == pdFALSE )
-                {
-                    /* If an error has ever been recorded we stop incrementing the
-                    check variable. */
-                    portENTER_CRITICAL();
-                        xPollingProducerCount++;
-                    portEXIT_CRITICAL();
-                }
+                portENTER_CRITICAL();
+                    xPollingProducerCount++;
+                portEXIT_CRITICAL();
 
                 /* Update the value we are going to post next time around. */
                 usValue++;
@@ -143,32 +216,59 @@ BaseType_t xError = pdFALSE, xLoop;
 
         /* Wait before we start posting again to ensure the consumer runs and
         empties the queue. */
-        vTaskDelay( pollqPRODUCER_DELAY );
+        if( pxPair->xPeriod != 0 )
+        {
+            vTaskDelay( pxPair->xPeriod );
+        }
     }
 }  /*lint !e818 Function prototype must conform to API. */
 /*-----------------------------------------------------------*/
 
 static portTASK_FUNCTION( vPolledQueueConsumer, pvParameters )
 {
-uint16_t usData, usExpectedValue = ( uint16_t ) 0;
+xPollQPair *pxPair = ( xPollQPair * ) pvParameters;
+uint8_t ucItem[ pollqMAX_ITEM_SIZE ];
+xPollQItemHeader xHeader;
+uint16_t usExpectedValue = ( uint16_t ) 0;
+uint32_t ulLatency;
 BaseType_t xError = pdFALSE;
 
     for( ;; )
     {
-        /* Loop until the queue is empty. */
-        while( uxQueueMessagesWaiting( *( ( QueueHandle_t * ) pvParameters ) ) )
+        /* Loop until the queue is empty, or block on it if there is no
+        period. */
+        while( ( pxPair->xPeriod == 0 ) || uxQueueMessagesWaiting( pxPair->xQueue ) )
         {
-            if( xQueueReceive( *( ( QueueHandle_t * ) pvParameters ), &usData, pollqNO_DELAY ) == pdPASS )
+            if( xQueueReceive( pxPair->xQueue, ucItem, ( pxPair->xPeriod == 0 ) ? portMAX_DELAY : pollqNO_DELAY ) == pdPASS )
             {
-                if( usData != usExpectedValue )
+                memcpy( &xHeader, ucItem, sizeof( xHeader ) );
+                ulLatency = micros() - xHeader.ulPostTime;
+
+                portENTER_CRITICAL();
+                {
+                    pxPair->xStats.ulMessages++;
+                    pxPair->xStats.ulLatencySum += ulLatency;
+
+                    if( ulLatency > pxPair->xStats.ulLatencyMax )
+                    {
+                        pxPair->xStats.ulLatencyMax = ulLatency;
+                    }
+                }
+                portEXIT_CRITICAL();
+
+                if( xHeader.usValue != usExpectedValue )
                 {
                     /* This is not what we expected to receive so an error has
                     occurred. */
                     xError = pdTRUE;
 
+                    portENTER_CRITICAL();
+                        pxPair->xStats.ulErrors++;
+                    portEXIT_CRITICAL();
+
                     /* Catch-up to the value we received so our next expected
                     value should again be correct. */
-                    usExpectedValue = usData;
+                    usExpectedValue = xHeader.usValue;
                 }
                 else
                 {
@@ -189,12 +289,31 @@ BaseType_t xError = pdFALSE;
 
         /* Now the queue is empty we block, allowing the producer to place more
         items in the queue. */
-        vTaskDelay( pollqCONSUMER_DELAY );
+        vTaskDelay( pxPair->xPeriod );
     }
 } /*lint !e818 Function prototype must conform to API. */
 /*-----------------------------------------------------------*/
 
-/* This is called to check that all the created tasks are still running with no errors. */
+UBaseType_t uxGetPolledQueuePairs( void )
+{
+    return uxPairCount;
+}
+/*-----------------------------------------------------------*/
+
+void vGetPolledQueueStats( UBaseType_t uxPair, PollQStats_t *pxStats )
+{
+    /* Copy the counters and start over, so each read covers the time since the
+    last one. */
+    portENTER_CRITICAL();
+    {
+        *pxStats = pxPairs[ uxPair ]->xStats;
+        memset( &( pxPairs[ uxPair ]->xStats ), 0, sizeof( PollQStats_t ) );
+    }
+    portEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+/* This is called to check that all the created tasks are still running. */
 BaseType_t xArePollingQueuesStillRunning( void )
 {
 BaseType_t xReturn;
@@ -32,7 +32,34 @@
 extern "C" {
 #endif
 
+/* Maximum number of producer/consumer pairs. */
+#ifndef pollqMAX_PAIRS
+	#define pollqMAX_PAIRS	8
+#endif
+
+/* Largest item size of a pair.  The producer and consumer keep an item of
+this size on their stack. */
+#ifndef pollqMAX_ITEM_SIZE
+	#define pollqMAX_ITEM_SIZE	16
+#endif
+
+/* Counters of one pair since the last call to vGetPolledQueueStats(). The
+latency is the time from the post to the receive of a message in micros().
+ulSendFailures counts the items a pair with a period could not post because
+the queue was full, ulErrors the messages received out of sequence. */
+typedef struct POLLQ_STATS
+{
+	uint32_t ulMessages;
+	uint32_t ulLatencySum;
+	uint32_t ulLatencyMax;
+	uint32_t ulSendFailures;
+	uint32_t ulErrors;
+} PollQStats_t;
+
 void vStartPolledQueueTasks( UBaseType_t uxPriority );
+BaseType_t xStartPolledQueuePair( UBaseType_t uxProducerPriority, UBaseType_t uxConsumerPriority, UBaseType_t uxItemSize, TickType_t xPeriod );
+UBaseType_t uxGetPolledQueuePairs( void );
+void vGetPolledQueueStats( UBaseType_t uxPair, PollQStats_t *pxStats );
 BaseType_t xArePollingQueuesStillRunning( void );
 
 #ifdef __cplusplus
@@ -64,6 +64,10 @@ false, flagging an error if the variable is still false the next time it
 is called. */
 static BaseType_t xTaskCheck[ intgNUMBER_OF_TASKS ] = { ( BaseType_t ) pdFALSE };
 
+/* Number of calculations done by all the tasks.  As they run at a low
+priority, this shows how much time the rest of the application leaves. */
+static volatile uint32_t ulIterations = 0;
+
 /*-----------------------------------------------------------*/
 
 void vStartIntegerMathTasks( UBaseType_t uxPriority )
@@ -124,6 +128,7 @@ volatile BaseType_t *pxTaskHasExecuted;
 			the check task. */
 			portENTER_CRITICAL();
 				*pxTaskHasExecuted = pdTRUE;
+				ulIterations++;
 			portEXIT_CRITICAL();
 		}
 
@@ -160,4 +165,18 @@ short sTask;
 
 	return xReturn;
 }
+/*-----------------------------------------------------------*/
+
+uint32_t ulGetIntegerMathsIterations( void )
+{
+uint32_t ulReturn;
+
+	/* Read and clear the count, so each call gives the count since the last
+	one. */
+	portENTER_CRITICAL();
+		ulReturn = ulIterations;
+		ulIterations = 0;
+	portEXIT_CRITICAL();
 
+	return ulReturn;
+}
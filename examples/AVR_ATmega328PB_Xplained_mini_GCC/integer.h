@@ -34,6 +34,7 @@ extern "C" {
 
 void vStartIntegerMathTasks( UBaseType_t uxPriority );
 BaseType_t xAreIntegerMathsTaskStillRunning( void );
+uint32_t ulGetIntegerMathsIterations( void );
 
 #ifdef __cplusplus
 }
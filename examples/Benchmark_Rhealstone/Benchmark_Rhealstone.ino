@@ -0,0 +1,684 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <semphr.h>
+
+#if ( configUSE_STREAM_BUFFERS == 1 )
+    #include <stream_buffer.h>
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Rhealstone style micro-benchmarks of the kernel. Each test measures the
+cycles of one kernel operation or one hand-off between two tasks with a free
+running 16 bit timer clocked by the CPU clock:
+
+  - ATmega328P/2560: Timer1 (portUSE_TIMER1 must be 0 on the Uno)
+  - ATmega4809:      TCB2, or TCB1 if TCB2 generates the tick
+  - POSIX host:      the time stamp counter of x86
+
+Every result is printed as one line of key=value pairs, e.g.
+
+  bench=semaphore_handoff size=0 n=256 min=412 avg=418 max=1020 unit=cycles
+
+The cost of reading the timer is measured first and subtracted. A tick that
+falls into a measurement shows up in max, min is the undisturbed value. The
+last line is "bench=done". extras/simavr/run_simavr.py runs the sketch in
+simavr and collects the lines. */
+#define benchITERATIONS         256
+#define benchTICK_ITERATIONS    32
+
+/* The controller task runs the tests. Helper tasks are created for one test
+and deleted again, to keep the heap usage low enough for the Uno. */
+#define benchCONTROLLER_PRIORITY    1
+#define benchHELPER_PRIORITY        2
+
+/* Largest queue item, smaller on the Uno to fit into the heap. */
+#if defined( RAMEND ) && ( RAMEND < 0x1000 )
+    #define benchMAX_ITEM_SIZE      32
+#else
+    #define benchMAX_ITEM_SIZE      64
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if defined( __AVR__ )
+
+    typedef uint16_t benchCount_t;
+
+    #if defined( TCB0 )
+
+        #if ( configUSE_TIMER_INSTANCE == 2 )
+            #define benchTIMER      TCB1
+        #else
+            #define benchTIMER      TCB2
+        #endif
+
+        #define benchTIMER_INIT()                                               \
+            {                                                                   \
+                benchTIMER.CTRLA = 0;                                           \
+                benchTIMER.CTRLB = TCB_CNTMODE_INT_gc;                          \
+                benchTIMER.CCMP = 0xFFFF;                                       \
+                benchTIMER.CNT = 0;                                             \
+                benchTIMER.CTRLA = TCB_CLKSEL_CLKDIV1_gc | TCB_ENABLE_bm;       \
+            }
+        #define benchNOW()          ( ( benchCount_t ) benchTIMER.CNT )
+
+    #else
+
+        #if ( portUSE_TIMER1 == 1 )
+            #error Timer1 generates the tick, set portUSE_TIMER1 to 0 in FreeRTOSConfig.h
+        #endif
+
+        #define benchTIMER_INIT()                                               \
+            {                                                                   \
+                TCCR1A = 0;                                                     \
+                TCCR1B = _BV( CS10 );                                           \
+                TCNT1 = 0;                                                      \
+            }
+        #define benchNOW()          ( ( benchCount_t ) TCNT1 )
+
+    #endif /* if defined( TCB0 ) */
+
+    #if defined( __AVR_DEVICE_NAME__ )
+        #define benchSTRINGIFY( x )     #x
+        #define benchMCU( x )           benchSTRINGIFY( x )
+        #define benchMCU_NAME           benchMCU( __AVR_DEVICE_NAME__ )
+    #else
+        #define benchMCU_NAME           "avr"
+    #endif
+
+#elif defined( __x86_64__ ) || defined( __i386__ )
+
+    #include <x86intrin.h>
+
+    typedef uint32_t benchCount_t;
+
+    #define benchTIMER_INIT()
+    #define benchNOW()              ( ( benchCount_t ) __rdtsc() )
+    #define benchMCU_NAME           "host"
+
+#else
+    #error No cycle counter for this target
+#endif
+
+/* The interrupt latency test toggles the LED pin and takes the pin change
+interrupt. Not available on the other boards. */
+#if defined( __AVR_ATmega328P__ ) || defined( __AVR_ATmega2560__ )
+
+    #if defined( __AVR_ATmega328P__ )
+        #define benchIRQ_BIT        _BV( PB5 )  /* D13, PCINT5 */
+    #else
+        #define benchIRQ_BIT        _BV( PB7 )  /* D13, PCINT7 */
+    #endif
+
+    #define benchIRQ_VECTOR         PCINT0_vect
+    #define benchIRQ_INIT()                                                     \
+        {                                                                       \
+            DDRB |= benchIRQ_BIT;                                               \
+            PCMSK0 |= benchIRQ_BIT;                                             \
+            PCIFR = _BV( PCIF0 );                                               \
+            PCICR |= _BV( PCIE0 );                                              \
+        }
+    #define benchIRQ_TRIGGER()      ( PINB = benchIRQ_BIT )
+    #define benchIRQ_CLEAR()
+
+#elif defined( ARDUINO_AVR_NANO_EVERY ) || defined( ARDUINO_AVR_UNO_WIFI_REV2 )
+
+    #if defined( ARDUINO_AVR_NANO_EVERY )
+        #define benchIRQ_PORT       PORTE       /* D13 */
+        #define benchIRQ_PIN        2
+        #define benchIRQ_VECTOR     PORTE_PORT_vect
+    #else
+        #define benchIRQ_PORT       PORTD       /* D13 */
+        #define benchIRQ_PIN        6
+        #define benchIRQ_VECTOR     PORTD_PORT_vect
+    #endif
+
+    #define benchIRQ_INIT()                                                     \
+        {                                                                       \
+            benchIRQ_PORT.DIRSET = _BV( benchIRQ_PIN );                         \
+            ( &benchIRQ_PORT.PIN0CTRL )[ benchIRQ_PIN ] = PORT_ISC_BOTHEDGES_gc; \
+            benchIRQ_PORT.INTFLAGS = _BV( benchIRQ_PIN );                       \
+        }
+    #define benchIRQ_TRIGGER()      ( benchIRQ_PORT.OUTTGL = _BV( benchIRQ_PIN ) )
+    #define benchIRQ_CLEAR()        ( benchIRQ_PORT.INTFLAGS = _BV( benchIRQ_PIN ) )
+
+#endif
+
+/*-----------------------------------------------------------*/
+
+typedef struct BenchResult
+{
+    uint32_t ulSum;
+    benchCount_t xMin;
+    benchCount_t xMax;
+    uint16_t usCount;
+} BenchResult_t;
+
+void vTaskController( void * pvParameters );
+
+static void prvReset( BenchResult_t * pxResult );
+static void prvRecord( BenchResult_t * pxResult, benchCount_t xElapsed );
+static void prvPrint( const __FlashStringHelper * pcName, uint16_t usSize, BenchResult_t * pxResult );
+static void prvRunHelper( TaskFunction_t pxHelper, UBaseType_t uxPriority );
+static void prvStopHelper( void );
+
+/* Time stamp taken by the task that starts a hand-off. */
+static volatile benchCount_t xStamp;
+
+/* Cost of reading the timer twice, subtracted from every result. */
+static benchCount_t xOverhead = 0;
+
+/* Result written by the helper task or the ISR of the running test. */
+static BenchResult_t xHelperResult;
+
+#if defined( benchIRQ_VECTOR )
+    static BenchResult_t xISRResult;
+#endif
+
+static TaskHandle_t xHelper = NULL;
+static SemaphoreHandle_t xSemaphore = NULL;
+static QueueHandle_t xQueue = NULL;
+static uint16_t usItemSize;
+static uint8_t ucSendItem[ benchMAX_ITEM_SIZE ];
+static uint8_t ucReceiveItem[ benchMAX_ITEM_SIZE ];
+
+#if ( configUSE_STREAM_BUFFERS == 1 )
+    static StreamBufferHandle_t xStreamBuffer = NULL;
+#endif
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    /* Initialize the serial port. */
+    Serial.begin( 115200 );
+
+    benchTIMER_INIT();
+
+    xTaskCreate( vTaskController, "Bench", configMINIMAL_STACK_SIZE + 64, NULL, benchCONTROLLER_PRIORITY, NULL );
+
+    /* Start the kernel sheduler. */
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+    /* The Arduino loop function is used as the idle hook. In FreeRTOSConfig.h
+    configUSE_IDLE_HOOK must be set because there are (serial) events that were
+    processed in the backround of the Arduino core implementation of loop(). */
+}
+/*-----------------------------------------------------------*/
+
+static void prvReset( BenchResult_t * pxResult )
+{
+    pxResult->ulSum = 0;
+    pxResult->xMin = ( benchCount_t ) ~0U;
+    pxResult->xMax = 0;
+    pxResult->usCount = 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecord( BenchResult_t * pxResult, benchCount_t xElapsed )
+{
+    xElapsed = ( xElapsed > xOverhead ) ? ( benchCount_t ) ( xElapsed - xOverhead ) : 0;
+
+    pxResult->ulSum += xElapsed;
+    pxResult->usCount++;
+
+    if( xElapsed < pxResult->xMin )
+    {
+        pxResult->xMin = xElapsed;
+    }
+
+    if( xElapsed > pxResult->xMax )
+    {
+        pxResult->xMax = xElapsed;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrint( const __FlashStringHelper * pcName, uint16_t usSize, BenchResult_t * pxResult )
+{
+    Serial.print( F( "bench=" ) );
+    Serial.print( pcName );
+    Serial.print( F( " size=" ) );
+    Serial.print( usSize );
+    Serial.print( F( " n=" ) );
+    Serial.print( pxResult->usCount );
+
+    if( pxResult->usCount > 0 )
+    {
+        Serial.print( F( " min=" ) );
+        Serial.print( ( uint32_t ) pxResult->xMin );
+        Serial.print( F( " avg=" ) );
+        Serial.print( pxResult->ulSum / pxResult->usCount );
+        Serial.print( F( " max=" ) );
+        Serial.print( ( uint32_t ) pxResult->xMax );
+    }
+
+    Serial.println( F( " unit=cycles" ) );
+    Serial.flush();
+}
+/*-----------------------------------------------------------*/
+
+/* Creates the helper task of a test. With a higher priority it runs up to its
+first blocking call straight away. */
+static void prvRunHelper( TaskFunction_t pxHelper, UBaseType_t uxPriority )
+{
+    prvReset( &xHelperResult );
+    xTaskCreate( pxHelper, "Helper", configMINIMAL_STACK_SIZE, NULL, uxPriority, &xHelper );
+}
+/*-----------------------------------------------------------*/
+
+static void prvStopHelper( void )
+{
+    vTaskDelete( xHelper );
+    xHelper = NULL;
+}
+/*-----------------------------------------------------------*/
+
+/* Task switch: two tasks of the same priority yield to each other. Each one
+stamps before the yield and records when it runs again, so every switch is
+recorded once, by the task switched to. */
+static void prvYieldHelper( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        prvRecord( &xHelperResult, ( benchCount_t ) ( benchNOW() - xStamp ) );
+        xStamp = benchNOW();
+        taskYIELD();
+    }
+}
+
+static void prvTestTaskSwitch( void )
+{
+    uint16_t usCount;
+
+    prvRunHelper( prvYieldHelper, benchCONTROLLER_PRIORITY );
+
+    /* Let the helper run once, its first record is not a switch. */
+    taskYIELD();
+    prvReset( &xHelperResult );
+
+    for( usCount = 0; usCount < benchITERATIONS; usCount++ )
+    {
+        xStamp = benchNOW();
+        taskYIELD();
+        prvRecord( &xHelperResult, ( benchCount_t ) ( benchNOW() - xStamp ) );
+    }
+
+    prvStopHelper();
+    prvPrint( F( "task_switch" ), 0, &xHelperResult );
+}
+/*-----------------------------------------------------------*/
+
+/* Preemption: a higher priority task is woken by the tick and preempts the
+controller, which stamps in a loop. Includes the tick interrupt. The virtual
+clock of the POSIX host port never ticks while the controller computes. */
+#if defined( portHOST_VIRTUAL_CLOCK ) && ( portHOST_VIRTUAL_CLOCK == 1 )
+    #define benchTEST_PREEMPTION    0
+#else
+    #define benchTEST_PREEMPTION    1
+#endif
+
+#if ( benchTEST_PREEMPTION == 1 )
+static void prvDelayHelper( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    vTaskDelay( 1 );
+    prvReset( &xHelperResult );
+
+    for( ;; )
+    {
+        vTaskDelay( 1 );
+        prvRecord( &xHelperResult, ( benchCount_t ) ( benchNOW() - xStamp ) );
+    }
+}
+
+static void prvTestPreemption( void )
+{
+    prvRunHelper( prvDelayHelper, benchHELPER_PRIORITY );
+
+    while( xHelperResult.usCount < benchTICK_ITERATIONS )
+    {
+        xStamp = benchNOW();
+    }
+
+    prvStopHelper();
+    prvPrint( F( "preemption" ), 0, &xHelperResult );
+}
+#endif /* benchTEST_PREEMPTION */
+/*-----------------------------------------------------------*/
+
+/* Semaphore hand-off: the give of the controller unblocks the helper waiting
+in the take, which preempts the controller. */
+static void prvSemaphoreHelper( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        ( void ) xSemaphoreTake( xSemaphore, portMAX_DELAY );
+        prvRecord( &xHelperResult, ( benchCount_t ) ( benchNOW() - xStamp ) );
+    }
+}
+
+static void prvTestSemaphore( void )
+{
+    uint16_t usCount;
+
+    xSemaphore = xSemaphoreCreateBinary();
+    prvRunHelper( prvSemaphoreHelper, benchHELPER_PRIORITY );
+
+    for( usCount = 0; usCount < benchITERATIONS; usCount++ )
+    {
+        xStamp = benchNOW();
+        ( void ) xSemaphoreGive( xSemaphore );
+    }
+
+    prvStopHelper();
+    vSemaphoreDelete( xSemaphore );
+    prvPrint( F( "semaphore_handoff" ), 0, &xHelperResult );
+}
+/*-----------------------------------------------------------*/
+
+/* Mutex: lock and unlock without contention, then the hand-off to a higher
+priority task blocked on the mutex, which includes the priority inheritance
+and the disinheritance. */
+static void prvMutexHelper( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+        ( void ) xSemaphoreTake( xSemaphore, portMAX_DELAY );
+        prvRecord( &xHelperResult, ( benchCount_t ) ( benchNOW() - xStamp ) );
+        ( void ) xSemaphoreGive( xSemaphore );
+    }
+}
+
+static void prvTestMutex( void )
+{
+    BenchResult_t xLock, xUnlock;
+    benchCount_t xStart;
+    uint16_t usCount;
+
+    xSemaphore = xSemaphoreCreateMutex();
+    prvReset( &xLock );
+    prvReset( &xUnlock );
+
+    for( usCount = 0; usCount < benchITERATIONS; usCount++ )
+    {
+        xStart = benchNOW();
+        ( void ) xSemaphoreTake( xSemaphore, 0 );
+        prvRecord( &xLock, ( benchCount_t ) ( benchNOW() - xStart ) );
+
+        xStart = benchNOW();
+        ( void ) xSemaphoreGive( xSemaphore );
+        prvRecord( &xUnlock, ( benchCount_t ) ( benchNOW() - xStart ) );
+    }
+
+    prvPrint( F( "mutex_lock" ), 0, &xLock );
+    prvPrint( F( "mutex_unlock" ), 0, &xUnlock );
+
+    prvRunHelper( prvMutexHelper, benchHELPER_PRIORITY );
+
+    for( usCount = 0; usCount < benchITERATIONS; usCount++ )
+    {
+        ( void ) xSemaphoreTake( xSemaphore, 0 );
+
+        /* The helper blocks on the mutex and lends its priority. */
+        xTaskNotifyGive( xHelper );
+
+        xStamp = benchNOW();
+        ( void ) xSemaphoreGive( xSemaphore );
+    }
+
+    prvStopHelper();
+    vSemaphoreDelete( xSemaphore );
+    prvPrint( F( "mutex_handoff" ), 0, &xHelperResult );
+}
+/*-----------------------------------------------------------*/
+
+/* Queue: send and receive without blocking, then the hand-off to a higher
+priority task blocked in the receive, for a range of item sizes. */
+static void prvQueueHelper( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        ( void ) xQueueReceive( xQueue, ucReceiveItem, portMAX_DELAY );
+        prvRecord( &xHelperResult, ( benchCount_t ) ( benchNOW() - xStamp ) );
+    }
+}
+
+static void prvTestQueue( uint16_t usSize )
+{
+    BenchResult_t xSend, xReceive;
+    benchCount_t xStart;
+    uint16_t usCount;
+
+    usItemSize = usSize;
+    xQueue = xQueueCreate( 1, usSize );
+    prvReset( &xSend );
+    prvReset( &xReceive );
+
+    for( usCount = 0; usCount < benchITERATIONS; usCount++ )
+    {
+        xStart = benchNOW();
+        ( void ) xQueueSend( xQueue, ucSendItem, 0 );
+        prvRecord( &xSend, ( benchCount_t ) ( benchNOW() - xStart ) );
+
+        xStart = benchNOW();
+        ( void ) xQueueReceive( xQueue, ucReceiveItem, 0 );
+        prvRecord( &xReceive, ( benchCount_t ) ( benchNOW() - xStart ) );
+    }
+
+    prvPrint( F( "queue_send" ), usSize, &xSend );
+    prvPrint( F( "queue_receive" ), usSize, &xReceive );
+
+    prvRunHelper( prvQueueHelper, benchHELPER_PRIORITY );
+
+    for( usCount = 0; usCount < benchITERATIONS; usCount++ )
+    {
+        xStamp = benchNOW();
+        ( void ) xQueueSend( xQueue, ucSendItem, 0 );
+    }
+
+    prvStopHelper();
+    vQueueDelete( xQueue );
+    prvPrint( F( "queue_handoff" ), usSize, &xHelperResult );
+}
+/*-----------------------------------------------------------*/
+
+/* Direct to task notification hand-off. */
+static void prvNotifyHelper( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+        prvRecord( &xHelperResult, ( benchCount_t ) ( benchNOW() - xStamp ) );
+    }
+}
+
+static void prvTestNotify( void )
+{
+    uint16_t usCount;
+
+    prvRunHelper( prvNotifyHelper, benchHELPER_PRIORITY );
+
+    for( usCount = 0; usCount < benchITERATIONS; usCount++ )
+    {
+        xStamp = benchNOW();
+        xTaskNotifyGive( xHelper );
+    }
+
+    prvStopHelper();
+    prvPrint( F( "notify_handoff" ), 0, &xHelperResult );
+}
+/*-----------------------------------------------------------*/
+
+/* Stream buffer: cycles to pass a block of bytes to a task blocked in the
+receive. The throughput in bytes per cycle is size / avg. */
+#if ( configUSE_STREAM_BUFFERS == 1 )
+
+    static void prvStreamBufferHelper( void * pvParameters )
+    {
+        ( void ) pvParameters;
+
+        for( ;; )
+        {
+            ( void ) xStreamBufferReceive( xStreamBuffer, ucReceiveItem, usItemSize, portMAX_DELAY );
+            prvRecord( &xHelperResult, ( benchCount_t ) ( benchNOW() - xStamp ) );
+        }
+    }
+
+    static void prvTestStreamBuffer( uint16_t usSize )
+    {
+        uint16_t usCount;
+
+        usItemSize = usSize;
+        xStreamBuffer = xStreamBufferCreate( usSize, usSize );
+        prvRunHelper( prvStreamBufferHelper, benchHELPER_PRIORITY );
+
+        for( usCount = 0; usCount < benchITERATIONS; usCount++ )
+        {
+            xStamp = benchNOW();
+            ( void ) xStreamBufferSend( xStreamBuffer, ucSendItem, usSize, 0 );
+        }
+
+        prvStopHelper();
+        vStreamBufferDelete( xStreamBuffer );
+        prvPrint( F( "stream_buffer" ), usSize, &xHelperResult );
+    }
+
+#endif /* configUSE_STREAM_BUFFERS */
+/*-----------------------------------------------------------*/
+
+/* Interrupt to task latency: the controller toggles a pin, the pin change ISR
+notifies the helper. Records the ISR entry and the start of the task. */
+#if defined( benchIRQ_VECTOR )
+
+    ISR( benchIRQ_VECTOR )
+    {
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+        prvRecord( &xISRResult, ( benchCount_t ) ( benchNOW() - xStamp ) );
+        benchIRQ_CLEAR();
+
+        if( xHelper != NULL )
+        {
+            vTaskNotifyGiveFromISR( xHelper, &xHigherPriorityTaskWoken );
+        }
+
+        if( xHigherPriorityTaskWoken != pdFALSE )
+        {
+            portYIELD_FROM_ISR();
+        }
+    }
+
+    static void prvTestInterrupt( void )
+    {
+        uint16_t usCount;
+
+        prvReset( &xISRResult );
+        prvRunHelper( prvNotifyHelper, benchHELPER_PRIORITY );
+        benchIRQ_INIT();
+
+        for( usCount = 0; usCount < benchITERATIONS; usCount++ )
+        {
+            xStamp = benchNOW();
+            benchIRQ_TRIGGER();
+        }
+
+        prvStopHelper();
+        prvPrint( F( "interrupt_entry" ), 0, &xISRResult );
+        prvPrint( F( "interrupt_to_task" ), 0, &xHelperResult );
+    }
+
+#endif /* benchIRQ_VECTOR */
+/*-----------------------------------------------------------*/
+
+void vTaskController( void * pvParameters )
+{
+    static const uint16_t usSizes[] = { 1, 4, 16, benchMAX_ITEM_SIZE };
+    BenchResult_t xEmpty;
+    benchCount_t xStart;
+    uint16_t usCount;
+    uint8_t ucSize;
+
+    /* Keep the compiler happy because pvParameters is not used here. */
+    ( void ) pvParameters;
+
+    /* Cost of the time stamps themselves. */
+    prvReset( &xEmpty );
+
+    for( usCount = 0; usCount < benchITERATIONS; usCount++ )
+    {
+        xStart = benchNOW();
+        prvRecord( &xEmpty, ( benchCount_t ) ( benchNOW() - xStart ) );
+    }
+
+    xOverhead = xEmpty.xMin;
+
+    Serial.print( F( "bench=config mcu=" ) );
+    Serial.print( F( benchMCU_NAME ) );
+    Serial.print( F( " f_cpu=" ) );
+    Serial.print( ( uint32_t ) F_CPU );
+    Serial.print( F( " tick_hz=" ) );
+    Serial.print( ( uint32_t ) configTICK_RATE_HZ );
+    Serial.print( F( " priorities=" ) );
+    Serial.print( configMAX_PRIORITIES );
+    Serial.print( F( " optimised=" ) );
+    Serial.print( configUSE_PORT_OPTIMISED_TASK_SELECTION );
+    Serial.print( F( " overhead=" ) );
+    Serial.println( ( uint32_t ) xOverhead );
+
+    prvTestTaskSwitch();
+
+    #if ( benchTEST_PREEMPTION == 1 )
+        prvTestPreemption();
+    #else
+        Serial.println( F( "bench=preemption skipped=virtual_clock" ) );
+    #endif
+
+    prvTestSemaphore();
+    prvTestMutex();
+
+    for( ucSize = 0; ucSize < sizeof( usSizes ) / sizeof( usSizes[ 0 ] ); ucSize++ )
+    {
+        prvTestQueue( usSizes[ ucSize ] );
+    }
+
+    prvTestNotify();
+
+    #if ( configUSE_STREAM_BUFFERS == 1 )
+        for( ucSize = 0; ucSize < sizeof( usSizes ) / sizeof( usSizes[ 0 ] ); ucSize++ )
+        {
+            prvTestStreamBuffer( usSizes[ ucSize ] );
+        }
+    #else
+        Serial.println( F( "bench=stream_buffer skipped=configUSE_STREAM_BUFFERS" ) );
+    #endif
+
+    #if defined( benchIRQ_VECTOR )
+        prvTestInterrupt();
+    #else
+        Serial.println( F( "bench=interrupt_to_task skipped=board" ) );
+    #endif
+
+    Serial.println( F( "bench=done" ) );
+    Serial.flush();
+
+    vTaskSuspend( NULL );
+}
@@ -0,0 +1,102 @@
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*-----------------------------------------------------------*/
+
+/* Number of notify/block round trips per measurement. Each round trip is two
+context switches. Running the sketch with configGENERATE_RUN_TIME_STATS set to
+0 and to 1 shows the cost of reading the run time counter: half of the
+difference of the cycles per round trip is the overhead per context switch. */
+#define benchROUND_TRIPS        1000UL
+
+/* The high priority task is placed just below the timer task, so the generic
+task selection has to walk down all the empty priorities in between, every
+time the high priority task blocks again. */
+#define benchHIGH_PRIORITY      ( configMAX_PRIORITIES - 2 )
+#define benchLOW_PRIORITY       1
+
+/*-----------------------------------------------------------*/
+
+void vTaskHigh( void * pvParameters );
+void vTaskLow( void * pvParameters );
+
+static TaskHandle_t xTaskHigh = NULL;
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    /* Initialize the serial port. */
+    Serial.begin( 9600 );
+
+    xTaskCreate( vTaskHigh, "High", configMINIMAL_STACK_SIZE, NULL, benchHIGH_PRIORITY, &xTaskHigh );
+    xTaskCreate( vTaskLow, "Low", configMINIMAL_STACK_SIZE, NULL, benchLOW_PRIORITY, NULL );
+
+    /* Start the kernel sheduler. */
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+    /* The Arduino loop function is used as the idle hook. In FreeRTOSConfig.h
+    configUSE_IDLE_HOOK must be set because there are (serial) events that were
+    processed in the backround of the Arduino core implementation of loop(). */
+}
+/*-----------------------------------------------------------*/
+
+void vTaskHigh( void * pvParameters )
+{
+    /* Keep the compiler happy because pvParameters is not used here. */
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        /* Block straight away again, which makes the scheduler select the
+        highest priority ready task. */
+        ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskLow( void * pvParameters )
+{
+    uint32_t ulStart, ulElapsed;
+    uint32_t ulCount;
+
+    /* Keep the compiler happy because pvParameters is not used here. */
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        ulStart = micros();
+
+        for( ulCount = 0; ulCount < benchROUND_TRIPS; ulCount++ )
+        {
+            /* Wakes the high priority task, which preempts this one and
+            blocks again. */
+            xTaskNotifyGive( xTaskHigh );
+        }
+
+        ulElapsed = micros() - ulStart;
+
+        /* Print the configuration and the cycles per round trip. */
+        Serial.print( F( "optimised=" ) );
+        Serial.print( configUSE_PORT_OPTIMISED_TASK_SELECTION );
+        Serial.print( F( " priorities=" ) );
+        Serial.print( configMAX_PRIORITIES );
+        Serial.print( F( " runtimestats=" ) );
+        Serial.print( configGENERATE_RUN_TIME_STATS );
+        Serial.print( F( " cycles/round-trip=" ) );
+        Serial.println( ( ulElapsed * ( F_CPU / 1000000UL ) ) / benchROUND_TRIPS );
+
+        #if ( configGENERATE_RUN_TIME_STATS == 1 )
+            /* CPU share of the high priority task since the start. */
+            Serial.print( F( "high=" ) );
+            Serial.print( ( uint32_t ) ulTaskGetRunTimePercent( xTaskHigh ) );
+            Serial.println( F( "%" ) );
+        #endif
+
+        vTaskDelay( 1000 / portTICK_PERIOD_MS );
+    }
+}
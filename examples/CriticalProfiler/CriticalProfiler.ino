@@ -0,0 +1,161 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+/*
+ * Prints the call sites with the longest critical sections and scheduler
+ * suspensions every mainREPORT_PERIOD. Set portUSE_CRITICAL_PROFILER to 1 in
+ * FreeRTOSConfig.h.
+ *
+ * Next to the queue traffic of two tasks, one task holds a critical section
+ * for mainLONG_CRITICAL_US and one suspends the scheduler for
+ * mainLONG_SUSPEND_US, which should come out on top. One line per site:
+ *
+ *   crit kind=critical site=0x1a2c max_ns=412000 avg_ns=409000 count=50
+ *
+ * Look the sites up in the ELF file of the sketch (Sketch > Export Compiled
+ * Binary in the Arduino IDE):
+ *
+ *   avr-addr2line -f -e CriticalProfiler.ino.elf 0x1a2c
+ */
+
+#if ( portUSE_CRITICAL_PROFILER != 1 )
+    #error "Set portUSE_CRITICAL_PROFILER to 1 in FreeRTOSConfig.h."
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define mainREPORT_PERIOD       pdMS_TO_TICKS( 5000 )
+#define mainLONG_PERIOD         pdMS_TO_TICKS( 100 )
+
+#define mainLONG_CRITICAL_US    400
+#define mainLONG_SUSPEND_US     2000
+
+/* Number of sites printed per kind. */
+#define mainTOP_SITES           5
+
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters );
+void vTaskLong( void * pvParameters );
+void vTaskProducer( void * pvParameters );
+void vTaskConsumer( void * pvParameters );
+
+static QueueHandle_t xQueue = NULL;
+
+static const char * const pcKindNames[ profKINDS ] =
+{
+    "critical", "suspended"
+};
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xQueue = xQueueCreate( 4, sizeof( uint16_t ) );
+
+    xTaskCreate( vTaskReport, "Report", configMINIMAL_STACK_SIZE + 128, NULL, 3, NULL );
+    xTaskCreate( vTaskLong, "Long", configMINIMAL_STACK_SIZE, NULL, 2, NULL );
+    xTaskCreate( vTaskProducer, "Producer", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+    xTaskCreate( vTaskConsumer, "Consumer", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters )
+{
+    CriticalProfileSite_t xSites[ mainTOP_SITES ];
+    const uint32_t ulCountNs = ulCriticalProfileGetCountNs();
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainREPORT_PERIOD );
+
+        for( uint8_t ucKind = 0; ucKind < profKINDS; ucKind++ )
+        {
+            size_t xCount = xCriticalProfileGetTop( ucKind, xSites, mainTOP_SITES, pdTRUE );
+
+            for( size_t x = 0; x < xCount; x++ )
+            {
+                Serial.print( "crit kind=" );
+                Serial.print( pcKindNames[ ucKind ] );
+                Serial.print( " site=0x" );
+                Serial.print( ( unsigned long ) xSites[ x ].ulSite, HEX );
+                Serial.print( " max_ns=" );
+                Serial.print( ( unsigned long ) ( xSites[ x ].ulMax * ulCountNs ) );
+                Serial.print( " avg_ns=" );
+                Serial.print( ( unsigned long ) ( ( xSites[ x ].ulTotal / xSites[ x ].ulCount ) * ulCountNs ) );
+                Serial.print( " count=" );
+                Serial.println( ( unsigned long ) xSites[ x ].ulCount );
+            }
+        }
+
+        /* The producer and consumer leave no idle time. */
+        Serial.flush();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskLong( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelay( mainLONG_PERIOD );
+
+        /* A driver that masks the interrupts for too long. */
+        taskENTER_CRITICAL();
+        {
+            delayMicroseconds( mainLONG_CRITICAL_US );
+        }
+        taskEXIT_CRITICAL();
+
+        vTaskDelay( mainLONG_PERIOD );
+
+        /* A library that suspends the scheduler for too long. */
+        vTaskSuspendAll();
+        {
+            delayMicroseconds( mainLONG_SUSPEND_US );
+        }
+        ( void ) xTaskResumeAll();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskProducer( void * pvParameters )
+{
+    uint16_t usValue = 0;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        xQueueSend( xQueue, &usValue, portMAX_DELAY );
+        usValue++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskConsumer( void * pvParameters )
+{
+    uint16_t usValue;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        xQueueReceive( xQueue, &usValue, portMAX_DELAY );
+    }
+}
@@ -0,0 +1,136 @@
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*
+ * Grows a buffer line by line with pvPortRealloc(), as a task does that
+ * collects a message of unknown length, and shrinks it to the first line once
+ * it is full. A second buffer is allocated and freed in between, so the buffer
+ * sometimes has a free block behind it, sometimes in front of it and sometimes
+ * none. Every mainREPORT_PERIOD the Report task prints:
+ *
+ *   resizes=1200 same=1010 moved=190 failed=0 heap_free=412 min_free=268
+ *
+ * "same" counts the resizes that kept the address, "moved" the others, which
+ * either absorbed the free block in front or copied the data.
+ */
+
+/*-----------------------------------------------------------*/
+
+#define mainREPORT_PERIOD       pdMS_TO_TICKS( 5000 )
+#define mainSTEP_PERIOD         pdMS_TO_TICKS( 20 )
+
+#define mainLINE_SIZE           16
+#define mainMAX_SIZE            ( 8 * mainLINE_SIZE )
+
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters );
+void vTaskCollect( void * pvParameters );
+
+static volatile uint32_t ulSame = 0;
+static volatile uint32_t ulMoved = 0;
+static volatile uint32_t ulFailed = 0;
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xTaskCreate( vTaskReport, "Report", configMINIMAL_STACK_SIZE + 128, NULL, 2, NULL );
+    xTaskCreate( vTaskCollect, "Collect", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainREPORT_PERIOD );
+
+        Serial.print( "resizes=" );
+        Serial.print( ( unsigned long ) ( ulSame + ulMoved + ulFailed ) );
+        Serial.print( " same=" );
+        Serial.print( ( unsigned long ) ulSame );
+        Serial.print( " moved=" );
+        Serial.print( ( unsigned long ) ulMoved );
+        Serial.print( " failed=" );
+        Serial.print( ( unsigned long ) ulFailed );
+        Serial.print( " heap_free=" );
+        Serial.print( ( unsigned long ) xPortGetFreeHeapSize() );
+        Serial.print( " min_free=" );
+        Serial.println( ( unsigned long ) xPortGetMinimumEverFreeHeapSize() );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskCollect( void * pvParameters )
+{
+    uint8_t * pucBuffer = NULL;
+    uint8_t * pucNew;
+    void * pvOther = NULL;
+    size_t xSize = 0;
+    uint8_t ucStep = 0;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelay( mainSTEP_PERIOD );
+
+        /* Append a line, or keep only the first one once the buffer is full. */
+        size_t xNewSize = ( xSize < mainMAX_SIZE ) ? ( xSize + mainLINE_SIZE ) : mainLINE_SIZE;
+
+        pucNew = ( uint8_t * ) pvPortRealloc( pucBuffer, xNewSize );
+
+        if( pucNew == NULL )
+        {
+            /* The old buffer is still valid. */
+            ulFailed++;
+            continue;
+        }
+
+        if( pucNew == pucBuffer )
+        {
+            ulSame++;
+        }
+        else if( pucBuffer != NULL )
+        {
+            ulMoved++;
+        }
+
+        pucBuffer = pucNew;
+
+        for( size_t x = xSize; x < xNewSize; x++ )
+        {
+            pucBuffer[ x ] = ( uint8_t ) ( x / mainLINE_SIZE );
+        }
+
+        xSize = xNewSize;
+
+        /* Change what lies around the buffer. */
+        if( ( ++ucStep % 3 ) == 0 )
+        {
+            if( pvOther == NULL )
+            {
+                pvOther = pvPortMalloc( mainLINE_SIZE );
+            }
+            else
+            {
+                vPortFree( pvOther );
+                pvOther = NULL;
+            }
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+/*
+ * Spreads the heap over the internal SRAM and the external RAM of an Arduino
+ * Mega with an XMEM shield, and prints the use of each region every
+ * mainREPORT_PERIOD. Set portUSE_HEAP_REGIONS and portUSE_XMEM to 1 in
+ * FreeRTOSConfig.h.
+ *
+ * A sampler task sends records to a logger task through a queue of
+ * mainRECORDS records, whose storage is large enough to go to external memory,
+ * while the stacks and the TCBs of the tasks stay in internal memory. One line per region:
+ *
+ *   region ext=0 size=2032 free=1264 min=1264 blocks=1 largest=1264 allocs=4 frees=0
+ *   region ext=1 size=56827 free=55459 min=55459 blocks=1 largest=55459 allocs=1 frees=0
+ *
+ * A board without external RAM only shows ucHeap, and the queue storage then
+ * goes to internal memory.
+ */
+
+#if ( portUSE_HEAP_REGIONS != 1 )
+    #error "Set portUSE_HEAP_REGIONS to 1 in FreeRTOSConfig.h."
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define mainREPORT_PERIOD       pdMS_TO_TICKS( 5000 )
+#define mainSAMPLE_PERIOD       pdMS_TO_TICKS( 10 )
+#define mainDRAIN_PERIOD        pdMS_TO_TICKS( 100 )
+
+/* Number of records the queue holds. */
+#define mainRECORDS             64
+
+/* Number of regions printed. */
+#define mainMAX_REGIONS         4
+
+/*-----------------------------------------------------------*/
+
+typedef struct Record
+{
+    TickType_t xTime;
+    uint16_t usValue;
+    uint16_t usChannel;
+} Record_t;
+
+void vTaskReport( void * pvParameters );
+void vTaskSampler( void * pvParameters );
+void vTaskLogger( void * pvParameters );
+
+static QueueHandle_t xRecords = NULL;
+static HeapRegionStats_t xRegionStats[ mainMAX_REGIONS ];
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xRecords = xQueueCreate( mainRECORDS, sizeof( Record_t ) );
+
+    xTaskCreate( vTaskReport, "Report", configMINIMAL_STACK_SIZE + 64, NULL, 2, NULL );
+    xTaskCreate( vTaskSampler, "Sampler", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+    xTaskCreate( vTaskLogger, "Logger", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainREPORT_PERIOD );
+
+        UBaseType_t uxCount = uxPortGetHeapRegionStats( xRegionStats, mainMAX_REGIONS );
+
+        for( UBaseType_t x = 0; x < uxCount; x++ )
+        {
+            Serial.print( "region ext=" );
+            Serial.print( ( int ) xRegionStats[ x ].xExternal );
+            Serial.print( " size=" );
+            Serial.print( ( unsigned long ) xRegionStats[ x ].xSizeInBytes );
+            Serial.print( " free=" );
+            Serial.print( ( unsigned long ) xRegionStats[ x ].xAvailableHeapSpaceInBytes );
+            Serial.print( " min=" );
+            Serial.print( ( unsigned long ) xRegionStats[ x ].xMinimumEverFreeBytesRemaining );
+            Serial.print( " blocks=" );
+            Serial.print( ( unsigned long ) xRegionStats[ x ].xNumberOfFreeBlocks );
+            Serial.print( " largest=" );
+            Serial.print( ( unsigned long ) xRegionStats[ x ].xSizeOfLargestFreeBlockInBytes );
+            Serial.print( " allocs=" );
+            Serial.print( ( unsigned long ) xRegionStats[ x ].xNumberOfSuccessfulAllocations );
+            Serial.print( " frees=" );
+            Serial.println( ( unsigned long ) xRegionStats[ x ].xNumberOfSuccessfulFrees );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSampler( void * pvParameters )
+{
+    Record_t xRecord;
+
+    ( void ) pvParameters;
+
+    xRecord.usChannel = 0;
+
+    for( ;; )
+    {
+        vTaskDelay( mainSAMPLE_PERIOD );
+
+        xRecord.xTime = xTaskGetTickCount();
+        xRecord.usValue = ( uint16_t ) analogRead( xRecord.usChannel );
+        ( void ) xQueueSend( xRecords, &xRecord, 0 );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskLogger( void * pvParameters )
+{
+    Record_t xRecord;
+    uint32_t ulSum = 0;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        /* Drains the queue in bursts, so it fills up in between. */
+        vTaskDelay( mainDRAIN_PERIOD );
+
+        while( xQueueReceive( xRecords, &xRecord, 0 ) == pdPASS )
+        {
+            ulSum += xRecord.usValue;
+        }
+    }
+}
@@ -0,0 +1,168 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <semphr.h>
+#include <message_buffer.h>
+#include <timersFreeRTOS.h>
+
+/*
+ * Creates and deletes semaphores, timers, queues and small message buffers all
+ * the time, as a gateway does with short lived connections, and prints the
+ * pools of the slab layer and the heap every mainREPORT_PERIOD. Set
+ * portUSE_HEAP_SLABS to 1 in FreeRTOSConfig.h, and configUSE_STREAM_BUFFERS to
+ * 1 for the message buffers.
+ *
+ * The semaphores, timers and message buffers come from their pools, the queues
+ * (which are larger than a StaticQueue_t because of their storage) from the
+ * heap or a larger pool. One line per pool and one for the heap:
+ *
+ *   slab size=40 objects=4 free=3 min_free=1 allocs=1520 fallbacks=0
+ *   heap free=412 blocks=2 largest=380
+ *
+ * With portUSE_HEAP_SLABS set to 0 the same churn goes to the heap only, to
+ * compare the number of free blocks.
+ */
+
+#if ( portUSE_HEAP_SLABS != 1 )
+    #error "Set portUSE_HEAP_SLABS to 1 in FreeRTOSConfig.h."
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define mainREPORT_PERIOD       pdMS_TO_TICKS( 5000 )
+#define mainCHURN_PERIOD        pdMS_TO_TICKS( 10 )
+
+/* Number of objects of each kind alive at the same time. */
+#define mainALIVE               2
+
+/* Storage of the message buffers, within the stream buffer class. */
+#define mainMESSAGE_BUFFER_SIZE    24
+
+/* Number of pools printed. */
+#define mainMAX_SLABS           8
+
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters );
+void vTaskChurn( void * pvParameters );
+
+static SlabStats_t xSlabStats[ mainMAX_SLABS ];
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xTaskCreate( vTaskReport, "Report", configMINIMAL_STACK_SIZE + 128, NULL, 2, NULL );
+    xTaskCreate( vTaskChurn, "Churn", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+    HeapStats_t xHeapStats;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainREPORT_PERIOD );
+
+        UBaseType_t uxCount = uxPortGetSlabStats( xSlabStats, mainMAX_SLABS );
+
+        for( UBaseType_t x = 0; x < uxCount; x++ )
+        {
+            Serial.print( "slab size=" );
+            Serial.print( ( unsigned long ) xSlabStats[ x ].xObjectSize );
+            Serial.print( " objects=" );
+            Serial.print( ( unsigned long ) xSlabStats[ x ].xNumberOfObjects );
+            Serial.print( " free=" );
+            Serial.print( ( unsigned long ) xSlabStats[ x ].xNumberOfFreeObjects );
+            Serial.print( " min_free=" );
+            Serial.print( ( unsigned long ) xSlabStats[ x ].xMinimumEverFreeObjects );
+            Serial.print( " allocs=" );
+            Serial.print( ( unsigned long ) xSlabStats[ x ].xNumberOfSuccessfulAllocations );
+            Serial.print( " fallbacks=" );
+            Serial.println( ( unsigned long ) xSlabStats[ x ].xNumberOfFallbacks );
+        }
+
+        vPortGetHeapStats( &xHeapStats );
+
+        Serial.print( "heap free=" );
+        Serial.print( ( unsigned long ) xHeapStats.xAvailableHeapSpaceInBytes );
+        Serial.print( " blocks=" );
+        Serial.print( ( unsigned long ) xHeapStats.xNumberOfFreeBlocks );
+        Serial.print( " largest=" );
+        Serial.println( ( unsigned long ) xHeapStats.xSizeOfLargestFreeBlockInBytes );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTimerCallback( TimerHandle_t xTimer )
+{
+    ( void ) xTimer;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskChurn( void * pvParameters )
+{
+    SemaphoreHandle_t xSemaphores[ mainALIVE ] = { NULL };
+    TimerHandle_t xTimers[ mainALIVE ] = { NULL };
+    QueueHandle_t xQueues[ mainALIVE ] = { NULL };
+    #if ( configUSE_STREAM_BUFFERS == 1 )
+        MessageBufferHandle_t xMessageBuffers[ mainALIVE ] = { NULL };
+    #endif
+    uint8_t ucNext = 0;
+    uint8_t ucLength = 1;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelay( mainCHURN_PERIOD );
+
+        /* Replace the oldest object of each kind, so objects of different
+         * ages and sizes are mixed in the heap. */
+        if( xSemaphores[ ucNext ] != NULL )
+        {
+            vSemaphoreDelete( xSemaphores[ ucNext ] );
+        }
+
+        if( xTimers[ ucNext ] != NULL )
+        {
+            xTimerDelete( xTimers[ ucNext ], portMAX_DELAY );
+        }
+
+        if( xQueues[ ucNext ] != NULL )
+        {
+            vQueueDelete( xQueues[ ucNext ] );
+        }
+
+        #if ( configUSE_STREAM_BUFFERS == 1 )
+            if( xMessageBuffers[ ucNext ] != NULL )
+            {
+                vMessageBufferDelete( xMessageBuffers[ ucNext ] );
+            }
+        #endif
+
+        xSemaphores[ ucNext ] = xSemaphoreCreateBinary();
+        xTimers[ ucNext ] = xTimerCreate( "Churn", pdMS_TO_TICKS( 100 ), pdFALSE, NULL, prvTimerCallback );
+        xQueues[ ucNext ] = xQueueCreate( ucLength, sizeof( uint16_t ) );
+
+        #if ( configUSE_STREAM_BUFFERS == 1 )
+            xMessageBuffers[ ucNext ] = xMessageBufferCreate( mainMESSAGE_BUFFER_SIZE );
+        #endif
+
+        ucNext = ( uint8_t ) ( ( ucNext + 1 ) % mainALIVE );
+        ucLength = ( uint8_t ) ( ( ucLength % 8 ) + 1 );
+    }
+}
@@ -0,0 +1,143 @@
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*
+ * Times pvPortMalloc() and vPortFree() on a fragmented heap, for heap_4.c
+ * (portUSE_HEAP_TLSF set to 0) and heap_tlsf.c (set to 1).
+ *
+ * The heap is fragmented by allocating mainBLOCKS small blocks and freeing
+ * every other one, which leaves mainBLOCKS / 2 holes that are too small for
+ * the timed allocation. heap_4.c walks over all the holes on each allocation,
+ * heap_tlsf.c finds a large enough block with two bit scans. One line per
+ * round, with the times in microseconds:
+ *
+ *   heap=tlsf holes=32 malloc_max=12 malloc_avg=9 free_max=8 free_avg=7
+ */
+
+/*-----------------------------------------------------------*/
+
+#define mainREPORT_PERIOD       pdMS_TO_TICKS( 2000 )
+
+/* Number of small blocks, and the size of the small and of the timed blocks. */
+#define mainBLOCKS              64
+#define mainSMALL_SIZE          8
+#define mainLARGE_SIZE          48
+
+/* Number of timed allocations per round. */
+#define mainSAMPLES             32
+
+/*-----------------------------------------------------------*/
+
+void vTaskTiming( void * pvParameters );
+
+static void * pvBlocks[ mainBLOCKS ];
+static void * pvSamples[ mainSAMPLES ];
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xTaskCreate( vTaskTiming, "Timing", configMINIMAL_STACK_SIZE + 64, NULL, 1, NULL );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vTaskTiming( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+    unsigned long ulStart, ulTime;
+    unsigned long ulMallocMax, ulMallocSum, ulFreeMax, ulFreeSum;
+    UBaseType_t uxHoles;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainREPORT_PERIOD );
+
+        /* Small blocks of slightly different sizes, every other one freed. */
+        for( UBaseType_t x = 0; x < mainBLOCKS; x++ )
+        {
+            pvBlocks[ x ] = pvPortMalloc( mainSMALL_SIZE + ( x % 4 ) );
+        }
+
+        uxHoles = 0;
+
+        for( UBaseType_t x = 0; x < mainBLOCKS; x += 2 )
+        {
+            if( pvBlocks[ x ] != NULL )
+            {
+                vPortFree( pvBlocks[ x ] );
+                pvBlocks[ x ] = NULL;
+                uxHoles++;
+            }
+        }
+
+        ulMallocMax = 0;
+        ulMallocSum = 0;
+        ulFreeMax = 0;
+        ulFreeSum = 0;
+
+        /* The timing is not disturbed by the tick, only by interrupts. */
+        vTaskSuspendAll();
+        {
+            for( UBaseType_t x = 0; x < mainSAMPLES; x++ )
+            {
+                ulStart = micros();
+                pvSamples[ x ] = pvPortMalloc( mainLARGE_SIZE );
+                ulTime = micros() - ulStart;
+
+                ulMallocSum += ulTime;
+
+                if( ulTime > ulMallocMax )
+                {
+                    ulMallocMax = ulTime;
+                }
+            }
+
+            for( UBaseType_t x = 0; x < mainSAMPLES; x++ )
+            {
+                ulStart = micros();
+                vPortFree( pvSamples[ x ] );
+                ulTime = micros() - ulStart;
+
+                ulFreeSum += ulTime;
+
+                if( ulTime > ulFreeMax )
+                {
+                    ulFreeMax = ulTime;
+                }
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        for( UBaseType_t x = 1; x < mainBLOCKS; x += 2 )
+        {
+            vPortFree( pvBlocks[ x ] );
+            pvBlocks[ x ] = NULL;
+        }
+
+        #if ( portUSE_HEAP_TLSF == 1 )
+            Serial.print( "heap=tlsf holes=" );
+        #else
+            Serial.print( "heap=heap_4 holes=" );
+        #endif
+        Serial.print( ( unsigned long ) uxHoles );
+        Serial.print( " malloc_max=" );
+        Serial.print( ulMallocMax );
+        Serial.print( " malloc_avg=" );
+        Serial.print( ulMallocSum / mainSAMPLES );
+        Serial.print( " free_max=" );
+        Serial.print( ulFreeMax );
+        Serial.print( " free_avg=" );
+        Serial.println( ulFreeSum / mainSAMPLES );
+    }
+}
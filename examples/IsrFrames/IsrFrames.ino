@@ -0,0 +1,177 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+/*
+ * Allocates and frees memory in an ISR, as a driver does that receives frames
+ * of variable length. Set portUSE_HEAP_ISR and configUSE_TICK_HOOK to 1 in
+ * FreeRTOSConfig.h.
+ *
+ * Every mainFRAME_TICKS ticks the tick hook takes a frame from the reserve with
+ * pvPortMallocFromISR(), fills it and sends it to the Consumer task, which
+ * checks and frees it with vPortFree(). The Consumer also sends buffers from
+ * the heap to the tick hook, which frees them with vPortFreeFromISR(). Every
+ * mainREPORT_PERIOD the Report task prints:
+ *
+ *   frames=980 dropped=0 bad=0 isr_free=3 isr_min_free=2 heap_free=1320
+ */
+
+#if ( portUSE_HEAP_ISR != 1 )
+    #error "Set portUSE_HEAP_ISR to 1 in FreeRTOSConfig.h."
+#endif
+
+#if ( configUSE_TICK_HOOK != 1 )
+    #error "Set configUSE_TICK_HOOK to 1 in FreeRTOSConfig.h."
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define mainREPORT_PERIOD       pdMS_TO_TICKS( 5000 )
+#define mainFRAME_TICKS         3
+#define mainQUEUE_LENGTH        4
+
+/* Size of the buffers the tick hook frees. */
+#define mainBUFFER_SIZE         24
+
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters );
+void vTaskConsumer( void * pvParameters );
+
+static QueueHandle_t xFrameQueue = NULL;
+static QueueHandle_t xReleaseQueue = NULL;
+
+static volatile uint32_t ulFrames = 0;
+static volatile uint32_t ulDropped = 0;
+static volatile uint32_t ulBad = 0;
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xFrameQueue = xQueueCreate( mainQUEUE_LENGTH, sizeof( uint8_t * ) );
+    xReleaseQueue = xQueueCreate( mainQUEUE_LENGTH, sizeof( void * ) );
+
+    xTaskCreate( vTaskReport, "Report", configMINIMAL_STACK_SIZE + 128, NULL, 1, NULL );
+    xTaskCreate( vTaskConsumer, "Consumer", configMINIMAL_STACK_SIZE, NULL, 2, NULL );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationTickHook( void )
+{
+    static uint8_t ucTicks = 0;
+    static uint8_t ucSequence = 0;
+    uint8_t * pucFrame;
+    void * pvBuffer;
+    uint8_t ucLength;
+
+    /* Free a buffer the Consumer has handed over. */
+    if( xQueueReceiveFromISR( xReleaseQueue, &pvBuffer, NULL ) == pdPASS )
+    {
+        vPortFreeFromISR( pvBuffer );
+    }
+
+    if( ++ucTicks < mainFRAME_TICKS )
+    {
+        return;
+    }
+
+    ucTicks = 0;
+
+    /* Frames of 2 to portHEAP_ISR_BLOCK_SIZE bytes: the length, then the
+     * sequence number repeated. */
+    ucLength = ( uint8_t ) ( 2 + ( ucSequence % ( portHEAP_ISR_BLOCK_SIZE - 1 ) ) );
+    pucFrame = ( uint8_t * ) pvPortMallocFromISR( ucLength );
+
+    if( pucFrame == NULL )
+    {
+        ulDropped++;
+        return;
+    }
+
+    pucFrame[ 0 ] = ucLength;
+
+    for( uint8_t x = 1; x < ucLength; x++ )
+    {
+        pucFrame[ x ] = ucSequence;
+    }
+
+    ucSequence++;
+
+    if( xQueueSendFromISR( xFrameQueue, &pucFrame, NULL ) != pdPASS )
+    {
+        vPortFreeFromISR( pucFrame );
+        ulDropped++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskConsumer( void * pvParameters )
+{
+    uint8_t * pucFrame;
+    void * pvBuffer;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        xQueueReceive( xFrameQueue, &pucFrame, portMAX_DELAY );
+
+        for( uint8_t x = 2; x < pucFrame[ 0 ]; x++ )
+        {
+            if( pucFrame[ x ] != pucFrame[ 1 ] )
+            {
+                ulBad++;
+                break;
+            }
+        }
+
+        ulFrames++;
+
+        /* Frames go back to the reserve. */
+        vPortFree( pucFrame );
+
+        /* Hand a heap buffer to the tick hook to free. */
+        pvBuffer = pvPortMalloc( mainBUFFER_SIZE );
+
+        if( ( pvBuffer != NULL ) && ( xQueueSend( xReleaseQueue, &pvBuffer, 0 ) != pdPASS ) )
+        {
+            vPortFree( pvBuffer );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainREPORT_PERIOD );
+
+        Serial.print( "frames=" );
+        Serial.print( ( unsigned long ) ulFrames );
+        Serial.print( " dropped=" );
+        Serial.print( ( unsigned long ) ulDropped );
+        Serial.print( " bad=" );
+        Serial.print( ( unsigned long ) ulBad );
+        Serial.print( " isr_free=" );
+        Serial.print( ( unsigned long ) uxPortGetIsrPoolFreeBlocks() );
+        Serial.print( " isr_min_free=" );
+        Serial.print( ( unsigned long ) uxPortGetIsrPoolMinimumEverFreeBlocks() );
+        Serial.print( " heap_free=" );
+        Serial.println( ( unsigned long ) xPortGetFreeHeapSize() );
+    }
+}
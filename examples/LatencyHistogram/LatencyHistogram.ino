@@ -0,0 +1,208 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <semphr.h>
+
+/*
+ * Prints the latency histograms of the kernel every mainREPORT_PERIOD. Set
+ * configUSE_LATENCY_HISTOGRAMS to 1 in FreeRTOSConfig.h.
+ *
+ * A high priority task waits for a semaphore given by the interrupt of pin 2,
+ * which a low priority task toggles (pin 2 is an output, the external
+ * interrupt fires all the same), for the ISR wake-up latency. A periodic task
+ * and two tasks passing a queue back and forth add tick wake-ups and context
+ * switches. The host port has no pin interrupts, so the ISR histogram stays
+ * empty there.
+ *
+ * One line per histogram:
+ *
+ *   lat hist=isr_wake n=500 max_ns=41000 p50_ns=15000 p99_ns=31000 buckets=0,0,...
+ *
+ * The percentiles are the upper bounds of the log2 buckets, so they are
+ * rounded up to the next power of two counts of the timestamp.
+ */
+
+#if ( configUSE_LATENCY_HISTOGRAMS != 1 )
+    #error "Set configUSE_LATENCY_HISTOGRAMS to 1 in FreeRTOSConfig.h."
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define mainREPORT_PERIOD       pdMS_TO_TICKS( 5000 )
+#define mainTOGGLE_PERIOD       pdMS_TO_TICKS( 10 )
+#define mainPERIODIC_PERIOD     pdMS_TO_TICKS( 3 )
+
+#define mainINTERRUPT_PIN       2
+
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters );
+void vTaskIsrWaiter( void * pvParameters );
+void vTaskToggle( void * pvParameters );
+void vTaskPeriodic( void * pvParameters );
+void vTaskPing( void * pvParameters );
+
+static SemaphoreHandle_t xIsrSemaphore = NULL;
+static QueueHandle_t xPingQueue = NULL;
+static QueueHandle_t xPongQueue = NULL;
+
+static const char * const pcHistogramNames[ tskLATENCY_HISTOGRAMS ] =
+{
+    "isr_wake", "tick_wake", "tick_isr", "switch"
+};
+
+/*-----------------------------------------------------------*/
+
+#ifndef FREERTOS_HOST_POSIX
+
+    static void prvPinISR( void )
+    {
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+        xSemaphoreGiveFromISR( xIsrSemaphore, &xHigherPriorityTaskWoken );
+        portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+    }
+
+#endif
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xIsrSemaphore = xSemaphoreCreateBinary();
+    xPingQueue = xQueueCreate( 1, sizeof( uint16_t ) );
+    xPongQueue = xQueueCreate( 1, sizeof( uint16_t ) );
+
+    #ifndef FREERTOS_HOST_POSIX
+    {
+        pinMode( mainINTERRUPT_PIN, OUTPUT );
+        attachInterrupt( digitalPinToInterrupt( mainINTERRUPT_PIN ), prvPinISR, RISING );
+    }
+    #endif
+
+    xTaskCreate( vTaskIsrWaiter, "IsrWait", configMINIMAL_STACK_SIZE, NULL, 4, NULL );
+    xTaskCreate( vTaskReport, "Report", configMINIMAL_STACK_SIZE + 128, NULL, 3, NULL );
+    xTaskCreate( vTaskPeriodic, "Periodic", configMINIMAL_STACK_SIZE, NULL, 2, NULL );
+    xTaskCreate( vTaskPing, "Ping", configMINIMAL_STACK_SIZE, ( void * ) 1, 1, NULL );
+    xTaskCreate( vTaskPing, "Pong", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+    xTaskCreate( vTaskToggle, "Toggle", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters )
+{
+    LatencyHistogram_t xHistogram;
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainREPORT_PERIOD );
+
+        for( UBaseType_t x = 0; x < tskLATENCY_HISTOGRAMS; x++ )
+        {
+            vTaskGetLatencyHistogram( ( eLatencyHistogram ) x, &xHistogram, pdTRUE );
+
+            Serial.print( "lat hist=" );
+            Serial.print( pcHistogramNames[ x ] );
+            Serial.print( " n=" );
+            Serial.print( ( unsigned long ) xHistogram.ulSamples );
+            Serial.print( " max_ns=" );
+            Serial.print( ( unsigned long ) ( xHistogram.ulMax * xHistogram.ulCountNs ) );
+            Serial.print( " p50_ns=" );
+            Serial.print( ( unsigned long ) ( ulTaskGetLatencyPercentile( &xHistogram, 50 ) * xHistogram.ulCountNs ) );
+            Serial.print( " p99_ns=" );
+            Serial.print( ( unsigned long ) ( ulTaskGetLatencyPercentile( &xHistogram, 99 ) * xHistogram.ulCountNs ) );
+            Serial.print( " buckets=" );
+
+            for( UBaseType_t y = 0; y < configLATENCY_HISTOGRAM_BUCKETS; y++ )
+            {
+                if( y != 0 )
+                {
+                    Serial.print( ',' );
+                }
+
+                Serial.print( ( unsigned int ) xHistogram.usBuckets[ y ] );
+            }
+
+            Serial.println();
+        }
+
+        /* The ping pong tasks leave no idle time. */
+        Serial.flush();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskIsrWaiter( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        xSemaphoreTake( xIsrSemaphore, portMAX_DELAY );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskToggle( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelay( mainTOGGLE_PERIOD );
+
+        #ifndef FREERTOS_HOST_POSIX
+        {
+            /* The rising edge runs prvPinISR(). */
+            digitalWrite( mainINTERRUPT_PIN, HIGH );
+            digitalWrite( mainINTERRUPT_PIN, LOW );
+        }
+        #endif
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskPeriodic( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainPERIODIC_PERIOD );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskPing( void * pvParameters )
+{
+    /* The ping task starts the exchange, the pong task answers. */
+    const BaseType_t xIsPing = ( pvParameters != NULL ) ? pdTRUE : pdFALSE;
+    QueueHandle_t xReceiveQueue = ( xIsPing != pdFALSE ) ? xPongQueue : xPingQueue;
+    QueueHandle_t xSendQueue = ( xIsPing != pdFALSE ) ? xPingQueue : xPongQueue;
+    uint16_t usValue = 0;
+
+    if( xIsPing != pdFALSE )
+    {
+        xQueueSend( xSendQueue, &usValue, portMAX_DELAY );
+    }
+
+    for( ;; )
+    {
+        xQueueReceive( xReceiveQueue, &usValue, portMAX_DELAY );
+        usValue++;
+        xQueueSend( xSendQueue, &usValue, portMAX_DELAY );
+    }
+}
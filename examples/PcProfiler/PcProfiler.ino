@@ -0,0 +1,170 @@
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*
+ * Prints the samples of the PC profiler every mainREPORT_PERIOD. Set
+ * portUSE_PC_PROFILER to 1 in FreeRTOSConfig.h.
+ *
+ * Two tasks spend their time in a function each, the checksum task several
+ * times as long as the square root task, and the rest is idle time. The
+ * output is
+ *
+ *   pc shift=4 dropped=0
+ *   pc task=Checksum addr=0x1a20 count=532
+ *   ...
+ *   pc end
+ *
+ * Capture it and map the addresses to the functions of the ELF file of the
+ * sketch (Sketch > Export Compiled Binary in the Arduino IDE):
+ *
+ *   extras/profiler/pcprof.py --port /dev/ttyACM0 --seconds 12 \
+ *       --elf PcProfiler.ino.elf --nm avr-nm
+ */
+
+#if ( portUSE_PC_PROFILER != 1 )
+    #error "Set portUSE_PC_PROFILER to 1 in FreeRTOSConfig.h."
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define mainREPORT_PERIOD       pdMS_TO_TICKS( 5000 )
+#define mainWORK_PERIOD         pdMS_TO_TICKS( 40 )
+
+/* Rounds of work per period, the host needs a lot more for the same time. */
+#ifdef FREERTOS_HOST_POSIX
+    #define mainWORK_ROUNDS     2000
+#else
+    #define mainWORK_ROUNDS     1
+#endif
+
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters );
+void vTaskChecksum( void * pvParameters );
+void vTaskSquareRoot( void * pvParameters );
+
+static PcProfileBucket_t xBuckets[ portPC_PROFILER_SLOTS ];
+
+/* Keeps the results, so the work is not optimised away. */
+static volatile uint32_t ulResult;
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xTaskCreate( vTaskReport, "Report", configMINIMAL_STACK_SIZE + 128, NULL, 3, NULL );
+    xTaskCreate( vTaskChecksum, "Checksum", configMINIMAL_STACK_SIZE, NULL, 2, NULL );
+    xTaskCreate( vTaskSquareRoot, "SquareRoot", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainREPORT_PERIOD );
+
+        /* Read the dropped count first, it is cleared together with the
+         * table. */
+        uint32_t ulDropped = ulPcProfileGetDropped();
+        size_t xCount = xPcProfileRead( xBuckets, portPC_PROFILER_SLOTS, pdTRUE );
+
+        Serial.print( "pc shift=" );
+        Serial.print( portPC_PROFILER_SHIFT );
+        Serial.print( " dropped=" );
+        Serial.println( ( unsigned long ) ulDropped );
+
+        for( size_t x = 0; x < xCount; x++ )
+        {
+            Serial.print( "pc task=" );
+            Serial.print( pcTaskGetName( ( TaskHandle_t ) xBuckets[ x ].pvTask ) );
+            Serial.print( " addr=0x" );
+            Serial.print( ( unsigned long ) xBuckets[ x ].ulAddress, HEX );
+            Serial.print( " count=" );
+            Serial.println( ( unsigned long ) xBuckets[ x ].ulCount );
+        }
+
+        Serial.println( "pc end" );
+        Serial.flush();
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t __attribute__( ( noinline ) ) prvChecksum( uint32_t ulSum,
+                                                           uint16_t usLength )
+{
+    for( uint16_t x = 0; x < usLength; x++ )
+    {
+        ulSum = ( ulSum << 1 ) ^ ( ulSum >> 31 ) ^ x;
+    }
+
+    return ulSum;
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t __attribute__( ( noinline ) ) prvSquareRoot( uint32_t ulValue )
+{
+    uint16_t usRoot = 0;
+
+    for( uint16_t usBit = 0x8000; usBit != 0; usBit >>= 1 )
+    {
+        uint16_t usTry = usRoot | usBit;
+
+        if( ( uint32_t ) usTry * usTry <= ulValue )
+        {
+            usRoot = usTry;
+        }
+    }
+
+    return usRoot;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskChecksum( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        for( uint16_t x = 0; x < mainWORK_ROUNDS; x++ )
+        {
+            ulResult = prvChecksum( ulResult, 3000 );
+        }
+
+        vTaskDelay( mainWORK_PERIOD );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSquareRoot( void * pvParameters )
+{
+    uint32_t ulValue = 0;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        for( uint16_t x = 0; x < mainWORK_ROUNDS; x++ )
+        {
+            for( uint8_t y = 0; y < 30; y++ )
+            {
+                ulResult = prvSquareRoot( ulValue++ );
+            }
+        }
+
+        vTaskDelay( mainWORK_PERIOD );
+    }
+}
@@ -0,0 +1,159 @@
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*
+ * Polls the stack high water marks of all tasks every mainREPORT_PERIOD. Set
+ * configUSE_IDLE_STACK_SCAN to 1 in FreeRTOSConfig.h, the idle task then keeps
+ * the marks up to date and uxTaskGetStackHighWaterMark() only returns them, so
+ * the poll takes the same short time no matter how large the stacks are. Set
+ * configSTACK_HEADROOM_THRESHOLD to e.g. 40 for the headroom alarm.
+ *
+ * A task calls itself one level deeper every mainGROW_PERIOD, so its mark goes
+ * down step by step until it falls below the threshold. One line per report:
+ *
+ *   stack Monitor=212 Grower=97 IDLE=104 poll_us=24
+ *
+ * and one line when vApplicationStackHeadroomHook() reported a task:
+ *
+ *   headroom task=Grower mark=38
+ *
+ * On the host port the tasks run on stacks of the host, so the marks stay at
+ * the size of the stacks there.
+ */
+
+#if ( configUSE_IDLE_STACK_SCAN != 1 )
+    #error "Set configUSE_IDLE_STACK_SCAN to 1 in FreeRTOSConfig.h."
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define mainREPORT_PERIOD       pdMS_TO_TICKS( 1000 )
+#define mainGROW_PERIOD         pdMS_TO_TICKS( 500 )
+
+/* Deepest call of the grower, each level takes about mainFRAME_BYTES bytes. */
+#define mainMAX_DEPTH           8
+#define mainFRAME_BYTES         16
+
+/*-----------------------------------------------------------*/
+
+void vTaskMonitor( void * pvParameters );
+void vTaskGrower( void * pvParameters );
+
+static TaskHandle_t xMonitorTask = NULL;
+static TaskHandle_t xGrowerTask = NULL;
+
+/* Set by the headroom hook, printed by the monitor. */
+static volatile TaskHandle_t xHeadroomTask = NULL;
+static volatile configSTACK_DEPTH_TYPE uxHeadroomMark = 0;
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xTaskCreate( vTaskMonitor, "Monitor", configMINIMAL_STACK_SIZE + 64, NULL, 2, &xMonitorTask );
+    xTaskCreate( vTaskGrower, "Grower", configMINIMAL_STACK_SIZE + mainMAX_DEPTH * mainFRAME_BYTES, NULL, 1, &xGrowerTask );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+#if ( configSTACK_HEADROOM_THRESHOLD > 0 )
+
+void vApplicationStackHeadroomHook( TaskHandle_t xTask,
+                                    char * pcTaskName,
+                                    configSTACK_DEPTH_TYPE uxHighWaterMark )
+{
+    ( void ) pcTaskName;
+
+    /* Called by the idle task with the scheduler suspended, so only note it. */
+    xHeadroomTask = xTask;
+    uxHeadroomMark = uxHighWaterMark;
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
+void vTaskMonitor( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+    UBaseType_t uxMarks[ 3 ];
+    unsigned long ulStart;
+    unsigned long ulTime;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainREPORT_PERIOD );
+
+        ulStart = micros();
+        uxMarks[ 0 ] = uxTaskGetStackHighWaterMark( xMonitorTask );
+        uxMarks[ 1 ] = uxTaskGetStackHighWaterMark( xGrowerTask );
+        uxMarks[ 2 ] = uxTaskGetStackHighWaterMark( xTaskGetIdleTaskHandle() );
+        ulTime = micros() - ulStart;
+
+        Serial.print( "stack Monitor=" );
+        Serial.print( ( unsigned long ) uxMarks[ 0 ] );
+        Serial.print( " Grower=" );
+        Serial.print( ( unsigned long ) uxMarks[ 1 ] );
+        Serial.print( " IDLE=" );
+        Serial.print( ( unsigned long ) uxMarks[ 2 ] );
+        Serial.print( " poll_us=" );
+        Serial.println( ulTime );
+
+        if( xHeadroomTask != NULL )
+        {
+            Serial.print( "headroom task=" );
+            Serial.print( pcTaskGetName( xHeadroomTask ) );
+            Serial.print( " mark=" );
+            Serial.println( ( unsigned long ) uxHeadroomMark );
+            xHeadroomTask = NULL;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvGrow( uint8_t ucDepth )
+{
+    volatile uint8_t ucFrame[ mainFRAME_BYTES ];
+
+    /* Writes the whole frame, so the stack is used down to here. */
+    for( uint8_t x = 0; x < mainFRAME_BYTES; x++ )
+    {
+        ucFrame[ x ] = ucDepth;
+    }
+
+    if( ucDepth > 1 )
+    {
+        return ( uint8_t ) ( ucFrame[ 0 ] + prvGrow( ucDepth - 1 ) );
+    }
+
+    return ucFrame[ mainFRAME_BYTES - 1 ];
+}
+/*-----------------------------------------------------------*/
+
+void vTaskGrower( void * pvParameters )
+{
+    uint8_t ucDepth = 1;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelay( mainGROW_PERIOD );
+
+        ( void ) prvGrow( ucDepth );
+
+        if( ucDepth < mainMAX_DEPTH )
+        {
+            ucDepth++;
+        }
+    }
+}
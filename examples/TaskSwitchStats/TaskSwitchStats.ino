@@ -0,0 +1,159 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+/*
+ * Prints the switch statistics of all tasks every mainREPORT_PERIOD. Set
+ * configUSE_TASK_SWITCH_STATS, configUSE_TRACE_FACILITY and (for the ready
+ * wait time) configGENERATE_RUN_TIME_STATS to 1 in FreeRTOSConfig.h.
+ *
+ * A periodic task is woken by the tick, a consumer by the queue of a producer,
+ * and two tasks of the same priority yield to each other, so each column
+ * shows up. One line per task:
+ *
+ *   sw task=Consumer block=250 preempt=0 yield=0 isr_wake=0 tick_wake=0 task_wake=249 ready_wait=163
+ *
+ * The ready wait is in run time counter units (see portGET_RUN_TIME_COUNTER_VALUE()
+ * of the port), 0 without configGENERATE_RUN_TIME_STATS.
+ */
+
+#if ( configUSE_TASK_SWITCH_STATS != 1 ) || ( configUSE_TRACE_FACILITY != 1 )
+    #error "Set configUSE_TASK_SWITCH_STATS and configUSE_TRACE_FACILITY to 1 in FreeRTOSConfig.h."
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define mainREPORT_PERIOD       pdMS_TO_TICKS( 5000 )
+#define mainPERIODIC_PERIOD     pdMS_TO_TICKS( 10 )
+#define mainPRODUCER_PERIOD     pdMS_TO_TICKS( 20 )
+
+/* Number of tasks printed. */
+#define mainMAX_TASKS           10
+
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters );
+void vTaskPeriodic( void * pvParameters );
+void vTaskProducer( void * pvParameters );
+void vTaskConsumer( void * pvParameters );
+void vTaskYielder( void * pvParameters );
+
+static QueueHandle_t xQueue = NULL;
+
+static TaskStatus_t xTaskStatus[ mainMAX_TASKS ];
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xQueue = xQueueCreate( 4, sizeof( uint16_t ) );
+
+    xTaskCreate( vTaskReport, "Report", configMINIMAL_STACK_SIZE + 128, NULL, 4, NULL );
+    xTaskCreate( vTaskPeriodic, "Periodic", configMINIMAL_STACK_SIZE, NULL, 3, NULL );
+    xTaskCreate( vTaskConsumer, "Consumer", configMINIMAL_STACK_SIZE, NULL, 2, NULL );
+    xTaskCreate( vTaskProducer, "Producer", configMINIMAL_STACK_SIZE, NULL, 2, NULL );
+    xTaskCreate( vTaskYielder, "YieldA", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+    xTaskCreate( vTaskYielder, "YieldB", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vTaskReport( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainREPORT_PERIOD );
+
+        UBaseType_t uxCount = uxTaskGetSystemState( xTaskStatus, mainMAX_TASKS, NULL );
+
+        for( UBaseType_t x = 0; x < uxCount; x++ )
+        {
+            Serial.print( "sw task=" );
+            Serial.print( xTaskStatus[ x ].pcTaskName );
+            Serial.print( " block=" );
+            Serial.print( ( unsigned long ) xTaskStatus[ x ].ulBlockCount );
+            Serial.print( " preempt=" );
+            Serial.print( ( unsigned long ) xTaskStatus[ x ].ulPreemptCount );
+            Serial.print( " yield=" );
+            Serial.print( ( unsigned long ) xTaskStatus[ x ].ulYieldCount );
+            Serial.print( " isr_wake=" );
+            Serial.print( ( unsigned long ) xTaskStatus[ x ].ulISRWakeCount );
+            Serial.print( " tick_wake=" );
+            Serial.print( ( unsigned long ) xTaskStatus[ x ].ulTickWakeCount );
+            Serial.print( " task_wake=" );
+            Serial.print( ( unsigned long ) xTaskStatus[ x ].ulTaskWakeCount );
+            Serial.print( " ready_wait=" );
+            Serial.println( ( unsigned long ) xTaskStatus[ x ].ulReadyWaitTime );
+        }
+
+        /* The yielding tasks leave no idle time. */
+        Serial.flush();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskPeriodic( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainPERIODIC_PERIOD );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskProducer( void * pvParameters )
+{
+    uint16_t usValue = 0;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelay( mainPRODUCER_PERIOD );
+
+        xQueueSend( xQueue, &usValue, portMAX_DELAY );
+        usValue++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskConsumer( void * pvParameters )
+{
+    uint16_t usValue;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        xQueueReceive( xQueue, &usValue, portMAX_DELAY );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskYielder( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        /* Some work, then give the other task of this priority its turn. */
+        delayMicroseconds( 200 );
+        taskYIELD();
+    }
+}
@@ -0,0 +1,116 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+/*
+ * Sends telemetry frames with the tasks, the heap and a queue over Serial
+ * every portTELEMETRY_PERIOD_MS. Set portUSE_TELEMETRY and
+ * configUSE_TRACE_FACILITY to 1 in FreeRTOSConfig.h, and
+ * configGENERATE_RUN_TIME_STATS for the CPU share.
+ *
+ * The output is binary. Watch it on the host with:
+ *
+ *   extras/telemetry/frtop.py --port /dev/ttyACM0
+ *
+ * A producer fills the queue in bursts, which a slower consumer drains, and a
+ * worker computes now and then, so the columns change from frame to frame.
+ */
+
+#if ( portUSE_TELEMETRY != 1 ) || ( configUSE_TRACE_FACILITY != 1 )
+    #error "Set portUSE_TELEMETRY and configUSE_TRACE_FACILITY to 1 in FreeRTOSConfig.h."
+#endif
+
+/*-----------------------------------------------------------*/
+
+#define mainBURST_PERIOD        pdMS_TO_TICKS( 3000 )
+#define mainBURST_LENGTH        6
+#define mainCONSUMER_PERIOD     pdMS_TO_TICKS( 400 )
+#define mainWORKER_PERIOD       pdMS_TO_TICKS( 100 )
+
+/*-----------------------------------------------------------*/
+
+void vTaskProducer( void * pvParameters );
+void vTaskConsumer( void * pvParameters );
+void vTaskWorker( void * pvParameters );
+
+static QueueHandle_t xQueue = NULL;
+
+/*-----------------------------------------------------------*/
+
+static void prvWrite( const uint8_t * pucData,
+                      size_t xLength )
+{
+    Serial.write( pucData, xLength );
+}
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    xQueue = xQueueCreate( 8, sizeof( uint16_t ) );
+    xTelemetryAddQueue( xQueue, "Queue" );
+
+    xTaskCreate( vTaskProducer, "Producer", configMINIMAL_STACK_SIZE, NULL, 3, NULL );
+    xTaskCreate( vTaskConsumer, "Consumer", configMINIMAL_STACK_SIZE, NULL, 2, NULL );
+    xTaskCreate( vTaskWorker, "Worker", configMINIMAL_STACK_SIZE, NULL, 2, NULL );
+
+    xTelemetryStart( prvWrite );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void vTaskProducer( void * pvParameters )
+{
+    uint16_t usValue = 0;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelay( mainBURST_PERIOD );
+
+        for( uint8_t x = 0; x < mainBURST_LENGTH; x++ )
+        {
+            xQueueSend( xQueue, &usValue, portMAX_DELAY );
+            usValue++;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskConsumer( void * pvParameters )
+{
+    uint16_t usValue;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        xQueueReceive( xQueue, &usValue, portMAX_DELAY );
+        vTaskDelay( mainCONSUMER_PERIOD );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskWorker( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        /* Busy for 20 ms of each period. */
+        for( uint8_t x = 0; x < 20; x++ )
+        {
+            delayMicroseconds( 1000 );
+        }
+
+        vTaskDelay( mainWORKER_PERIOD );
+    }
+}
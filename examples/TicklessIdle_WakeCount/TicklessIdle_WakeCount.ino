@@ -0,0 +1,87 @@
+#include <FreeRTOS.h>
+#include <task.h>
+
+/*-----------------------------------------------------------*/
+
+/* Long idle test for the tickless idle of the megaAVR 0-series port (Arduino
+Nano Every, Uno WiFi Rev2). The only task blocks for sampleIDLE_TICKS at a
+time, so the MCU sleeps in standby mode for almost all of the time. Every
+sampleREPORT_PERIODS periods it prints how often the MCU woke up and the rate
+scaled to one hour.
+
+In FreeRTOSConfig.h set configUSE_TICKLESS_IDLE to 1 and configUSE_TIMER_INSTANCE
+to a TCB (0 to 3), as the RTC times the sleep.
+
+Calculated wake-ups per hour for 1 kHz ticks and one minute idle periods, not
+yet measured on a board:
+  - 16 bit RTC window with an overflow interrupt every 2 s (before): ~1860
+    (30 overflows and one compare per minute)
+  - prescaler selected per sleep, one compare per idle period (now):    60
+The second figure is what the host check in extras/tickless gets when it
+replays the prescaler selection and the chaining of compare windows of the
+port for a simulated hour. Idle periods of more than about 18 hours are split
+into several windows, so the count per hour stays below one. */
+#define sampleIDLE_TICKS        pdMS_TO_TICKS( 60000UL )
+#define sampleREPORT_PERIODS    10
+
+#if ( configUSE_TICKLESS_IDLE == 0 )
+    #error Set configUSE_TICKLESS_IDLE to 1 in FreeRTOSConfig.h
+#endif
+
+/*-----------------------------------------------------------*/
+
+void vTaskSample( void * pvParameters );
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    /* Initialize the serial port. */
+    Serial.begin( 9600 );
+
+    xTaskCreate( vTaskSample, "Sample", configMINIMAL_STACK_SIZE + 64, NULL, 1, NULL );
+
+    /* Start the kernel sheduler. */
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+    /* The Arduino loop function is used as the idle hook. In FreeRTOSConfig.h
+    configUSE_IDLE_HOOK must be set because there are (serial) events that were
+    processed in the backround of the Arduino core implementation of loop(). */
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSample( void * pvParameters )
+{
+    uint32_t ulWakeupsBefore, ulWakeups;
+    uint32_t ulPeriodsPerHour = ( 3600000UL / portTICK_PERIOD_MS ) / sampleIDLE_TICKS;
+    uint8_t ucPeriod;
+
+    /* Keep the compiler happy because pvParameters is not used here. */
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        ulWakeupsBefore = ulPortGetSleepWakeups();
+
+        for( ucPeriod = 0; ucPeriod < sampleREPORT_PERIODS; ucPeriod++ )
+        {
+            vTaskDelay( sampleIDLE_TICKS );
+        }
+
+        ulWakeups = ulPortGetSleepWakeups() - ulWakeupsBefore;
+
+        Serial.print( "wakeups=" );
+        Serial.print( ulWakeups );
+        Serial.print( " periods=" );
+        Serial.print( sampleREPORT_PERIODS );
+        Serial.print( " wakeups/hour=" );
+        Serial.println( ( ulWakeups * ulPeriodsPerHour ) / sampleREPORT_PERIODS );
+
+        /* Let the transmission end before the next sleep. */
+        Serial.flush();
+    }
+}
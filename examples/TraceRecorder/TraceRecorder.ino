@@ -0,0 +1,149 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <semphr.h>
+
+/*
+ * Records a timeline of the task switches, the blocking and the queue and
+ * mutex operations of three tasks with the trace recorder, and sends it over
+ * Serial. Set portUSE_TRACE_RECORDER to 1 in FreeRTOSConfig.h.
+ *
+ * In stream mode the idle task (loop()) sends the records as they come, the
+ * output is binary. Capture and convert it on the host with:
+ *
+ *   extras/trace/trace2perfetto.py --port /dev/ttyACM0 --seconds 10 -o trace.json
+ *
+ * and open trace.json in https://ui.perfetto.dev. In snapshot mode the last
+ * portTRACE_BUFFER_SIZE / 4 records before mainSNAPSHOT_TIME are sent once.
+ */
+
+#if ( portUSE_TRACE_RECORDER != 1 )
+    #error "Set portUSE_TRACE_RECORDER to 1 in FreeRTOSConfig.h."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* trcMODE_STREAM or trcMODE_SNAPSHOT. */
+#define mainTRACE_MODE          trcMODE_STREAM
+
+/* Time after which the snapshot is taken. */
+#define mainSNAPSHOT_TIME       pdMS_TO_TICKS( 2000 )
+
+#define mainPRODUCER_PERIOD     pdMS_TO_TICKS( 20 )
+#define mainWORKER_PERIOD       pdMS_TO_TICKS( 50 )
+
+/*-----------------------------------------------------------*/
+
+void vTaskProducer( void * pvParameters );
+void vTaskConsumer( void * pvParameters );
+void vTaskWorker( void * pvParameters );
+
+static QueueHandle_t xQueue = NULL;
+static SemaphoreHandle_t xMutex = NULL;
+
+/*-----------------------------------------------------------*/
+
+void setup( void )
+{
+    Serial.begin( 115200 );
+
+    /* Start before anything is created, so the names are recorded. */
+    vTraceStart( mainTRACE_MODE );
+
+    xQueue = xQueueCreate( 4, sizeof( uint16_t ) );
+    vTraceName( xQueue, "Queue" );
+
+    xMutex = xSemaphoreCreateMutex();
+    vTraceName( xMutex, "Mutex" );
+
+    /* The consumer has the highest priority, so each item is received as soon
+    as it is sent. The low priority worker holds the mutex the producer also
+    takes, which shows up as priority inheritance. */
+    xTaskCreate( vTaskConsumer, "Consumer", configMINIMAL_STACK_SIZE, NULL, 3, NULL );
+    xTaskCreate( vTaskProducer, "Producer", configMINIMAL_STACK_SIZE, NULL, 2, NULL );
+    xTaskCreate( vTaskWorker, "Worker", configMINIMAL_STACK_SIZE, NULL, 1, NULL );
+
+    vTaskStartScheduler();
+}
+/*-----------------------------------------------------------*/
+
+void loop( void )
+{
+    static uint8_t ucBuffer[ 32 ];
+    size_t xLength;
+
+    #if ( mainTRACE_MODE == trcMODE_SNAPSHOT )
+    {
+        static BaseType_t xSent = pdFALSE;
+
+        if( ( xSent != pdFALSE ) || ( xTaskGetTickCount() < mainSNAPSHOT_TIME ) )
+        {
+            return;
+        }
+
+        vTraceStop();
+        xSent = pdTRUE;
+    }
+    #endif
+
+    /* Sent from the idle task, so the records are only dropped when there is
+    no idle time left for the serial port. */
+    while( ( xLength = xTraceRead( ucBuffer, sizeof( ucBuffer ) ) ) != 0 )
+    {
+        Serial.write( ucBuffer, xLength );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskProducer( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+    uint16_t usValue = 0;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, mainPRODUCER_PERIOD );
+
+        xSemaphoreTake( xMutex, portMAX_DELAY );
+        xQueueSend( xQueue, &usValue, portMAX_DELAY );
+        xSemaphoreGive( xMutex );
+
+        usValue++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskConsumer( void * pvParameters )
+{
+    uint16_t usValue;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        xQueueReceive( xQueue, &usValue, portMAX_DELAY );
+
+        /* Marks the value in the timeline, instead of toggling a pin. */
+        vTraceUserEvent( 0, usValue );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskWorker( void * pvParameters )
+{
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        xSemaphoreTake( xMutex, portMAX_DELAY );
+
+        /* Some work while holding the mutex. */
+        delay( 5 );
+
+        xSemaphoreGive( xMutex );
+
+        vTaskDelay( mainWORKER_PERIOD );
+    }
+}
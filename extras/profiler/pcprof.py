@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""Maps the samples of the PC profiler to the functions of an ELF file.
+
+The profiler (src/pc_profiler.h, portUSE_PC_PROFILER) counts the code address
+interrupted by each tick, per task, in buckets of 2^shift bytes. A sketch
+prints the table as text lines:
+
+  pc shift=4 dropped=0
+  pc task=Checksum addr=0x1a20 count=532
+  pc end
+
+This script reads those lines (anything else is skipped, so the whole serial
+output can be fed in), sums up all reports, looks the buckets up in the
+symbol table of the ELF file and prints the functions with the most samples,
+overall and per task.
+
+  ./pcprof.py capture.txt --elf sketch.ino.elf --nm avr-nm
+  ./pcprof.py --port /dev/ttyACM0 --seconds 30 --elf sketch.ino.elf --nm avr-nm
+  ../posix/build/signal/sketch | ./pcprof.py - --elf ../posix/build/signal/sketch
+
+With --lines the buckets of the top functions are also resolved to source
+lines with addr2line (use --addr2line avr-addr2line for the AVR).
+
+A bucket is counted for the function its first byte belongs to, so a bucket
+that spans the end of a function counts for that function only. Addresses
+outside the ELF file (the C library of the host port) show up as ??. Address
+0 is a tick that interrupted an interrupt (Renesas boards) or a tick of the
+virtual clock (host port).
+"""
+
+import argparse
+import bisect
+import collections
+import re
+import subprocess
+import sys
+import time
+
+LINE = re.compile(r"^pc task=(?P<task>.*) addr=0x(?P<addr>[0-9A-Fa-f]+) count=(?P<count>\d+)\s*$")
+HEADER = re.compile(r"^pc shift=(?P<shift>\d+) dropped=(?P<dropped>\d+)\s*$")
+
+
+class Symbols:
+    """Function symbols of an ELF file, from nm."""
+
+    def __init__(self, elf, nm):
+        output = subprocess.run([nm, "--demangle", "--defined-only", "--numeric-sort", "--print-size", elf],
+                                check=True, capture_output=True, text=True).stdout
+        self.starts = []
+        self.entries = []
+        for line in output.splitlines():
+            fields = line.split(None, 3)
+            if len(fields) != 4 or fields[2] not in "tTwW":
+                continue
+            start, size = int(fields[0], 16), int(fields[1], 16)
+            self.starts.append(start)
+            self.entries.append((start, size, fields[3]))
+
+    def lookup(self, address):
+        index = bisect.bisect_right(self.starts, address) - 1
+        if index >= 0:
+            start, size, name = self.entries[index]
+            if address < start + size:
+                return name
+        return "?? 0x%x" % address
+
+
+def addr2line(tool, elf, addresses):
+    if not addresses:
+        return {}
+    output = subprocess.run([tool, "-e", elf] + ["0x%x" % a for a in addresses],
+                            check=True, capture_output=True, text=True).stdout
+    return dict(zip(addresses, output.splitlines()))
+
+
+def read_port(port, baud, seconds):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("--port needs pyserial (pip install pyserial)")
+    data = bytearray()
+    with serial.Serial(port, baud, timeout=0.2) as link:
+        end = time.monotonic() + seconds
+        while time.monotonic() < end:
+            data += link.read(4096)
+    return bytes(data)
+
+
+def parse(text):
+    """Returns the sample counts per (task, bucket address), the bucket size
+    and the number of dropped samples."""
+    samples = collections.Counter()
+    shift, dropped = None, 0
+    for line in text.splitlines():
+        match = LINE.match(line)
+        if match:
+            samples[(match["task"], int(match["addr"], 16))] += int(match["count"])
+            continue
+        match = HEADER.match(line)
+        if match:
+            shift = int(match["shift"])
+            dropped += int(match["dropped"])
+    return samples, shift, dropped
+
+
+def print_table(title, counts, total, limit):
+    print(title)
+    for name, count in counts.most_common(limit):
+        print("  %7d %5.1f%%  %s" % (count, 100.0 * count / total, name))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", help="captured output ('-' for stdin)")
+    parser.add_argument("--port", help="read from a serial port instead")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--seconds", type=float, default=30.0, help="time to read from --port")
+    parser.add_argument("--elf", help="ELF file of the sketch, without it the buckets are printed")
+    parser.add_argument("--nm", default="nm", help="nm of the toolchain, e.g. avr-nm")
+    parser.add_argument("--lines", action="store_true", help="resolve the buckets of the top functions")
+    parser.add_argument("--addr2line", default="addr2line", help="addr2line of the toolchain")
+    parser.add_argument("--top", type=int, default=20, help="functions printed per table")
+    args = parser.parse_args()
+
+    if args.port:
+        data = read_port(args.port, args.baud, args.seconds)
+    elif args.input == "-":
+        data = sys.stdin.buffer.read()
+    elif args.input:
+        with open(args.input, "rb") as stream:
+            data = stream.read()
+    else:
+        parser.error("an input file or --port is needed")
+
+    samples, shift, dropped = parse(data.decode("ascii", "replace"))
+    total = sum(samples.values())
+    if total == 0:
+        sys.exit("no samples found")
+
+    symbols = Symbols(args.elf, args.nm) if args.elf else None
+
+    def name(address):
+        if address == 0:
+            return "(interrupt or virtual clock)"
+        if symbols is None:
+            return "0x%x" % address
+        return symbols.lookup(address)
+
+    functions = collections.Counter()
+    tasks = collections.defaultdict(collections.Counter)
+    buckets = collections.defaultdict(collections.Counter)
+    for (task, address), count in samples.items():
+        function = name(address)
+        functions[function] += count
+        tasks[task][function] += count
+        buckets[function][address] += count
+
+    print("%d samples, %d dropped, buckets of %s bytes\n"
+          % (total, dropped, "?" if shift is None else 1 << shift))
+    print_table("all tasks", functions, total, args.top)
+
+    for task, counts in sorted(tasks.items(), key=lambda item: -sum(item[1].values())):
+        task_total = sum(counts.values())
+        print()
+        print_table("task %s (%.1f%% of the samples)" % (task, 100.0 * task_total / total),
+                    counts, task_total, args.top)
+
+    if args.lines and args.elf:
+        top = [function for function, _ in functions.most_common(args.top)]
+        addresses = sorted({a for f in top for a in buckets[f] if a != 0})
+        lines = addr2line(args.addr2line, args.elf, addresses)
+        for function in top:
+            print("\n%s" % function)
+            for address, count in buckets[function].most_common():
+                print("  %7d  0x%-8x %s" % (count, address, lines.get(address, "")))
+
+
+if __name__ == "__main__":
+    main()
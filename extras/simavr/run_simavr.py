@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Runs the Benchmark_Rhealstone example in simavr and collects the results.
+
+The sketch prints one line of key=value pairs per result and "bench=done" at
+the end. This script builds the sketch with arduino-cli (or takes an ELF file),
+runs it in simavr until "bench=done" and prints the results as JSON or CSV.
+
+  ./run_simavr.py --board uno
+  ./run_simavr.py --board mega --format csv > atmega2560.csv
+  ./run_simavr.py --elf Benchmark_Rhealstone.ino.elf --mcu atmega328p
+  ./run_simavr.py --log capture.txt      # output of a board or the host port
+
+simavr has no core for the megaAVR 0-series. For the ATmega4809 build the
+sketch for the board (--board nanoevery --build-only), capture the serial
+output of the board and parse it with --log.
+"""
+
+import argparse
+import csv
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import threading
+
+BOARDS = {
+    "uno": ("arduino:avr:uno", "atmega328p"),
+    "mega": ("arduino:avr:mega:cpu=atmega2560", "atmega2560"),
+    "nanoevery": ("arduino:megaavr:nona4809", "atmega4809"),
+}
+
+SKETCH = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                      "..", "..", "examples", "Benchmark_Rhealstone")
+
+# simavr prints the UART output in color and replaces control characters.
+ESCAPE = re.compile(r"\x1b\[[0-9;]*m")
+PAIR = re.compile(r"(\w+)=(\S+)")
+
+
+def build(fqbn, sketch, output_dir):
+    subprocess.run(["arduino-cli", "compile", "--fqbn", fqbn,
+                    "--output-dir", output_dir, sketch], check=True)
+    name = os.path.basename(os.path.normpath(sketch))
+    return os.path.join(output_dir, name + ".ino.elf")
+
+
+def parse_line(line):
+    """Returns the key=value pairs of a result line, or None."""
+    line = ESCAPE.sub("", line).rstrip(".\r\n")
+    start = line.find("bench=")
+    if start < 0:
+        return None
+    result = {}
+    for key, value in PAIR.findall(line[start:]):
+        result[key] = int(value) if value.isdigit() else value
+    # Throughput of the stream buffer in bytes per 1000 cycles.
+    if result.get("bench") == "stream_buffer" and result.get("avg"):
+        result["bytes_per_kcycle"] = round(result["size"] * 1000.0 / result["avg"], 1)
+    return result
+
+
+def collect(lines):
+    results = []
+    mcu = None
+    for line in lines:
+        result = parse_line(line)
+        if result is None:
+            continue
+        if result["bench"] == "done":
+            break
+        if result["bench"] == "config":
+            mcu = result.get("mcu")
+        elif mcu is not None:
+            result = dict(mcu=mcu, **result)
+        results.append(result)
+    return results
+
+
+def run_simavr(elf, mcu, freq, timeout):
+    process = subprocess.Popen(["simavr", "-m", mcu, "-f", str(freq), elf],
+                               stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                               text=True, errors="replace")
+    timer = threading.Timer(timeout, process.kill)
+    timer.start()
+    lines = []
+    try:
+        for line in process.stdout:
+            lines.append(line)
+            if "bench=done" in line:
+                break
+        else:
+            sys.exit("simavr: no bench=done within %d s" % timeout)
+    finally:
+        timer.cancel()
+        process.kill()
+        process.wait()
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--board", choices=sorted(BOARDS), help="build and run for a board")
+    source.add_argument("--elf", help="run a prebuilt ELF file")
+    source.add_argument("--log", help="parse captured output instead ('-' for stdin)")
+    parser.add_argument("--mcu", help="simavr MCU name, taken from --board by default")
+    parser.add_argument("--freq", type=int, default=16000000, help="CPU clock in Hz")
+    parser.add_argument("--sketch", default=SKETCH, help="sketch folder to build")
+    parser.add_argument("--build-only", action="store_true", help="only build, print the ELF path")
+    parser.add_argument("--timeout", type=int, default=120, help="seconds to wait for bench=done")
+    parser.add_argument("--format", choices=("json", "csv"), default="json")
+    args = parser.parse_args()
+
+    if args.log:
+        stream = sys.stdin if args.log == "-" else open(args.log, errors="replace")
+        results = collect(stream)
+    else:
+        mcu = args.mcu
+        elf = args.elf
+        with tempfile.TemporaryDirectory() as output_dir:
+            if args.board:
+                fqbn, mcu = BOARDS[args.board][0], mcu or BOARDS[args.board][1]
+                elf = build(fqbn, args.sketch, output_dir)
+                if args.build_only:
+                    kept = os.path.join(os.getcwd(), os.path.basename(elf))
+                    os.replace(elf, kept)
+                    print(kept)
+                    return
+            if not mcu:
+                sys.exit("--mcu is needed with --elf")
+            if mcu == "atmega4809":
+                sys.exit("simavr can not run the ATmega4809, use --build-only and --log")
+            results = collect(run_simavr(elf, mcu, args.freq, args.timeout))
+
+    if args.format == "json":
+        json.dump(results, sys.stdout, indent=1)
+        sys.stdout.write("\n")
+    else:
+        keys = []
+        for result in results:
+            keys += [key for key in result if key not in keys]
+        writer = csv.DictWriter(sys.stdout, fieldnames=keys)
+        writer.writeheader()
+        writer.writerows(results)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+"""Shows the telemetry frames of one or more boards like top.
+
+The telemetry task (src/telemetry.h, portUSE_TELEMETRY) sends a binary frame
+with the tasks, the heap and the queues every portTELEMETRY_PERIOD_MS. This
+script finds the frames in the byte stream (anything else, e.g. text printed
+by the sketch, is skipped), checks them and redraws a table per board:
+the state, priority, CPU share since the previous frame, run time and stack
+high water mark of each task, the free heap and the fill of the queues.
+
+  ./frtop.py --port /dev/ttyACM0
+  ./frtop.py --port /dev/ttyACM0 --port /dev/ttyUSB0      several boards
+  ../posix/build/signal/sketch | ./frtop.py -              the host port
+  ./frtop.py capture.bin --plain                            one table per frame
+
+The CPU share needs configGENERATE_RUN_TIME_STATS on the board.
+"""
+
+import argparse
+import struct
+import sys
+import threading
+import time
+
+MAGIC = b"FRTM"
+FORMAT_VERSION = 1
+HEADER = struct.Struct("<4sBH")
+
+STATES = ["running", "ready", "blocked", "suspended", "deleted", "invalid"]
+
+
+def fletcher16(data):
+    sum1 = sum2 = 0
+    for byte in data:
+        sum1 = (sum1 + byte) % 255
+        sum2 = (sum2 + sum1) % 255
+    return sum1 | (sum2 << 8)
+
+
+class Reader:
+    """Reads the payload of one frame at a time from the payload bytes."""
+
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def take(self, fmt):
+        values = struct.unpack_from("<" + fmt, self.data, self.offset)
+        self.offset += struct.calcsize("<" + fmt)
+        return values
+
+    def name(self):
+        (length,) = self.take("B")
+        text = self.data[self.offset:self.offset + length].decode("ascii", "replace")
+        self.offset += length
+        return text
+
+
+def decode(payload):
+    reader = Reader(payload)
+    ticks, tick_rate, run_time, heap_free, heap_min = reader.take("IHIII")
+    frame = {"ticks": ticks, "tick_rate": tick_rate, "run_time": run_time,
+             "heap_free": heap_free, "heap_min": heap_min, "tasks": [], "queues": []}
+    (count,) = reader.take("B")
+    for _ in range(count):
+        number, state, priority, base, stack, task_run_time = reader.take("HBBBII")
+        frame["tasks"].append({"number": number, "state": state, "priority": priority,
+                               "base": base, "stack": stack, "run_time": task_run_time,
+                               "name": reader.name()})
+    (count,) = reader.take("B")
+    for _ in range(count):
+        waiting, spaces = reader.take("HH")
+        frame["queues"].append({"waiting": waiting, "spaces": spaces, "name": reader.name()})
+    return frame
+
+
+class Parser:
+    """Splits a byte stream into frames."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.errors = 0
+
+    def feed(self, data):
+        self.buffer += data
+        frames = []
+        while True:
+            start = self.buffer.find(MAGIC)
+            if start < 0:
+                # Keep a partial magic at the end.
+                del self.buffer[:max(0, len(self.buffer) - len(MAGIC) + 1)]
+                return frames
+            del self.buffer[:start]
+            if len(self.buffer) < HEADER.size:
+                return frames
+            _, version, length = HEADER.unpack_from(self.buffer)
+            end = HEADER.size + length + 2
+            if len(self.buffer) < end:
+                return frames
+            payload = bytes(self.buffer[HEADER.size:HEADER.size + length])
+            (checksum,) = struct.unpack_from("<H", self.buffer, HEADER.size + length)
+            if version != FORMAT_VERSION or checksum != fletcher16(payload):
+                # Not a frame, or a damaged one: search again behind the magic.
+                self.errors += 1
+                del self.buffer[:1]
+                continue
+            del self.buffer[:end]
+            try:
+                frames.append(decode(payload))
+            except struct.error:
+                self.errors += 1
+
+
+class Board:
+    """Last two frames of a board, for the CPU share."""
+
+    def __init__(self, name):
+        self.name = name
+        self.parser = Parser()
+        self.frame = None
+        self.previous = None
+        self.updated = None
+
+    def feed(self, data):
+        for frame in self.parser.feed(data):
+            self.previous, self.frame = self.frame, frame
+            self.updated = time.monotonic()
+
+    def render(self):
+        lines = ["%s: no frame yet" % self.name] if self.frame is None else self.table()
+        if self.parser.errors:
+            lines.append("  (%d damaged frames)" % self.parser.errors)
+        return lines
+
+    def table(self):
+        frame, previous = self.frame, self.previous
+        uptime = frame["ticks"] / float(frame["tick_rate"] or 1)
+        lines = ["%s  up %.1f s  heap free %d  min %d  tasks %d"
+                 % (self.name, uptime, frame["heap_free"], frame["heap_min"], len(frame["tasks"]))]
+        if not frame["tasks"]:
+            lines.append("  no tasks: more tasks than portTELEMETRY_MAX_TASKS")
+
+        before = {}
+        total = 0
+        if previous is not None:
+            before = {task["number"]: task["run_time"] for task in previous["tasks"]}
+            total = (frame["run_time"] - previous["run_time"]) & 0xFFFFFFFF
+
+        def cpu(task):
+            if total == 0 or task["number"] not in before:
+                return None
+            return 100.0 * ((task["run_time"] - before[task["number"]]) & 0xFFFFFFFF) / total
+
+        lines.append("  %4s  %-16s %-9s %4s %6s %12s %8s" % ("NUM", "NAME", "STATE", "PRIO", "CPU%", "RUNTIME", "STACK"))
+        for task in sorted(frame["tasks"], key=lambda t: (-(cpu(t) or 0.0), t["number"])):
+            share = cpu(task)
+            priority = str(task["priority"])
+            if task["base"] != task["priority"]:
+                priority += "*"
+            lines.append("  %4d  %-16s %-9s %4s %6s %12d %8d"
+                         % (task["number"], task["name"], STATES[min(task["state"], 5)], priority,
+                            "-" if share is None else "%.1f" % share, task["run_time"], task["stack"]))
+
+        if frame["queues"]:
+            lines.append("  %-22s %8s %8s" % ("QUEUE", "WAITING", "LENGTH"))
+            for queue in frame["queues"]:
+                lines.append("  %-22s %8d %8d" % (queue["name"], queue["waiting"],
+                                                  queue["waiting"] + queue["spaces"]))
+        return lines
+
+
+def read_port(board, port, baud):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("--port needs pyserial (pip install pyserial)")
+    with serial.Serial(port, baud, timeout=0.2) as link:
+        while True:
+            board.feed(link.read(4096))
+
+
+def read_stream(board, stream):
+    while True:
+        data = stream.read1(4096) if hasattr(stream, "read1") else stream.read(4096)
+        if not data:
+            return
+        board.feed(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", help="captured bytes ('-' for stdin)")
+    parser.add_argument("--port", action="append", default=[], help="serial port of a board, repeatable")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--plain", action="store_true", help="print each frame instead of redrawing")
+    args = parser.parse_args()
+
+    if args.input and args.plain:
+        # Offline: one table per frame.
+        board = Board(args.input)
+        source = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+        for frame in board.parser.feed(source.read()):
+            board.previous, board.frame = board.frame, frame
+            print("\n".join(board.render()) + "\n")
+        return
+
+    boards = []
+    threads = []
+    for port in args.port:
+        board = Board(port)
+        boards.append(board)
+        threads.append(threading.Thread(target=read_port, args=(board, port, args.baud), daemon=True))
+    if args.input:
+        board = Board("stdin" if args.input == "-" else args.input)
+        boards.append(board)
+        source = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+        threads.append(threading.Thread(target=read_stream, args=(board, source), daemon=True))
+    if not boards:
+        parser.error("an input or --port is needed")
+
+    for thread in threads:
+        thread.start()
+
+    shown = None
+    try:
+        while any(thread.is_alive() for thread in threads):
+            state = [board.updated for board in boards]
+            if state != shown:
+                shown = state
+                lines = []
+                for board in boards:
+                    lines += board.render() + [""]
+                if args.plain:
+                    print("\n".join(lines))
+                else:
+                    sys.stdout.write("\x1b[H\x1b[2J" + "\n".join(lines) + "\n")
+                sys.stdout.flush()
+            time.sleep(0.1)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
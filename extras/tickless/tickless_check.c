@@ -0,0 +1,199 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        tickless_check.c
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Host check of the tickless idle arithmetic of the megaAVR
+ *              0-series port (src/AVR_Mega0/porttickless.h).
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Checks the prescaler selection and the tick/count conversions against 64 bit
+ * reference values, replays the chaining of compare windows of
+ * vPortSuppressTicksAndSleep() for sleeps ended by the RTC and by another
+ * interrupt, and counts the wake-ups of a simulated hour of one minute idle
+ * periods. Built and run by the Makefile for several tick rates and both tick
+ * type widths. Prints one summary line, or the first failure and exits with 1.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef configTICK_RATE_HZ
+    #define configTICK_RATE_HZ    1000
+#endif
+
+#ifndef TICK_TYPE_BITS
+    #define TICK_TYPE_BITS        16
+#endif
+
+#if ( TICK_TYPE_BITS == 16 )
+    typedef uint16_t TickType_t;
+    #define tickMAX_DELAY         ( ( TickType_t ) 0xFFFF )
+#else
+    typedef uint32_t TickType_t;
+    #define tickMAX_DELAY         ( ( TickType_t ) 0xFFFFFFFFUL )
+#endif
+
+#define RTC_CLOCK_SHIFT           ( 15 )
+
+#include "porttickless.h"
+
+/*-----------------------------------------------------------*/
+
+static unsigned long ulChecks = 0;
+
+#define CHECK( x, xTicks )                                                       \
+    do {                                                                         \
+        ulChecks++;                                                              \
+        if( !( x ) )                                                             \
+        {                                                                        \
+            printf( "FAIL rate=%u bits=%u ticks=%lu: %s\n", configTICK_RATE_HZ, \
+                    TICK_TYPE_BITS, ( unsigned long ) ( xTicks ), #x );          \
+            exit( 1 );                                                           \
+        }                                                                        \
+    } while( 0 )
+
+/*-----------------------------------------------------------*/
+
+/* Counts of xTicks at a prescaler of 2^ucShift, rounded down. */
+static uint64_t ullReferenceCounts( TickType_t xTicks,
+                                    uint8_t ucShift )
+{
+    return ( ( uint64_t ) xTicks << ( RTC_CLOCK_SHIFT - ucShift ) ) / configTICK_RATE_HZ;
+}
+/*-----------------------------------------------------------*/
+
+/* Replays the window loop of vPortSuppressTicksAndSleep(). ulInterruptAt is
+ * the RTC count at which another interrupt aborts the sleep, or UINT32_MAX.
+ * Returns the number of wake-ups and the elapsed counts. */
+static uint32_t ulSimulateSleep( uint32_t ulTargetCounts,
+                                 uint32_t ulInterruptAt,
+                                 uint32_t * pulElapsedCounts )
+{
+    uint16_t usWindowStart = 0, usWindow;
+    uint32_t ulElapsedCounts = 0, ulWakeups = 0;
+
+    usWindow = usNextWindow( ulTargetCounts, 0 );
+
+    for( ;; )
+    {
+        ulWakeups++;
+
+        if( ulInterruptAt < ( ulElapsedCounts + usWindow ) )
+        {
+            /* The RTC counter wraps, the port reads it relative to the start
+             * of the window. */
+            uint16_t usRTC = ( uint16_t ) ( usWindowStart + ( ulInterruptAt - ulElapsedCounts ) );
+            ulElapsedCounts += ( uint16_t ) ( usRTC - usWindowStart );
+            break;
+        }
+
+        ulElapsedCounts += usWindow;
+        usWindowStart += usWindow;
+
+        if( ulElapsedCounts >= ulTargetCounts )
+        {
+            break;
+        }
+
+        usWindow = usNextWindow( ulTargetCounts, ulElapsedCounts );
+    }
+
+    *pulElapsedCounts = ulElapsedCounts;
+
+    return ulWakeups;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckIdleTime( TickType_t xTicks )
+{
+    uint8_t ucShift = ucSelectPrescaler( xTicks );
+    uint32_t ulTarget = ulTicksToCounts( xTicks, ucShift );
+    uint32_t ulElapsed, ulWakeups, ulCountTicks;
+    TickType_t xComplete;
+
+    CHECK( ucShift <= RTC_CLOCK_SHIFT, xTicks );
+    CHECK( ulTarget == ullReferenceCounts( xTicks, ucShift ), xTicks );
+
+    /* The smallest prescaler with one window, the largest one otherwise. */
+    if( ucShift < RTC_CLOCK_SHIFT )
+    {
+        CHECK( ulTarget <= 0xFFFF, xTicks );
+    }
+
+    if( ucShift > 0 )
+    {
+        CHECK( ullReferenceCounts( xTicks, ucShift - 1 ) > 0xFFFF, xTicks );
+    }
+
+    /* Back to ticks: never more than slept, and less than one count short. */
+    xComplete = xCountsToTicks( ulTarget, ucShift );
+    ulCountTicks = ( ( uint32_t ) configTICK_RATE_HZ >> ( RTC_CLOCK_SHIFT - ucShift ) ) + 1U;
+    CHECK( xComplete <= xTicks, xTicks );
+    CHECK( ( uint32_t ) ( xTicks - xComplete ) <= ulCountTicks, xTicks );
+
+    /* Ended by the RTC: one wake-up per window, and all counts slept. */
+    ulWakeups = ulSimulateSleep( ulTarget, UINT32_MAX, &ulElapsed );
+
+    if( ulTarget != 0 )
+    {
+        CHECK( ulElapsed == ulTarget, xTicks );
+        CHECK( ulWakeups == ( ulTarget + 0xFFFEU ) / 0xFFFFU, xTicks );
+    }
+
+    /* Ended by another interrupt in the middle of the last window. */
+    if( ulTarget > 1 )
+    {
+        uint32_t ulStart = ( ( ulTarget - 1 ) / 0xFFFFU ) * 0xFFFFU;
+        uint32_t ulAt = ulStart + ( ( ulTarget - ulStart ) / 2U );
+
+        ( void ) ulSimulateSleep( ulTarget, ulAt, &ulElapsed );
+        CHECK( ulElapsed == ulAt, xTicks );
+        CHECK( xCountsToTicks( ulElapsed, ucShift ) <= xTicks, xTicks );
+    }
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    uint64_t ullTicks;
+    uint64_t ullMinute = 60ULL * configTICK_RATE_HZ;
+    uint32_t ulElapsed, ulWakeupsPerHour = 0;
+    TickType_t xMinute = ( TickType_t ) ullMinute;
+    unsigned int x;
+
+    /* All idle times up to 2^20 ticks, then in growing steps. */
+    for( ullTicks = 1; ullTicks <= tickMAX_DELAY; ullTicks += ( ullTicks < ( 1UL << 20 ) ) ? 1U : ( ullTicks >> 12 ) )
+    {
+        prvCheckIdleTime( ( TickType_t ) ullTicks );
+    }
+
+    prvCheckIdleTime( tickMAX_DELAY );
+
+    /* One hour of one minute idle periods, ended by the RTC. */
+    if( ullMinute <= tickMAX_DELAY )
+    {
+        for( x = 0; x < 60U; x++ )
+        {
+            uint8_t ucShift = ucSelectPrescaler( xMinute );
+
+            ulWakeupsPerHour += ulSimulateSleep( ulTicksToCounts( xMinute, ucShift ), UINT32_MAX, &ulElapsed );
+        }
+    }
+
+    printf( "ok rate=%u bits=%u checks=%lu minute_shift=%u wakeups_per_hour=%lu\n",
+            configTICK_RATE_HZ, TICK_TYPE_BITS, ulChecks,
+            ( unsigned int ) ucSelectPrescaler( xMinute ), ( unsigned long ) ulWakeupsPerHour );
+
+    return 0;
+}
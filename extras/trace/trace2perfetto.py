@@ -0,0 +1,289 @@
+#!/usr/bin/env python3
+"""Converts the output of the trace recorder into the Chrome trace JSON format.
+
+The recorder (src/trace_recorder.h, portUSE_TRACE_RECORDER) writes records of
+4 bytes after a header starting with "FRTR". This script reads the raw bytes,
+e.g. captured from the serial port, skips anything before the header and
+writes a JSON file that https://ui.perfetto.dev or chrome://tracing show as a
+timeline: one track per task with the times it ran and the times it was
+blocked (and on what), plus the queue operations and the events of the
+application as instants.
+
+  ./trace2perfetto.py capture.bin -o trace.json
+  ./trace2perfetto.py --port /dev/ttyACM0 --baud 115200 --seconds 10 -o trace.json
+  ../posix/build/signal/sketch | ./trace2perfetto.py - -o trace.json
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+MAGIC = b"FRTR"
+FORMAT_VERSION = 1
+
+TIME, DROPPED, NAME = 0x01, 0x02, 0x03
+
+TASK_EVENTS = {
+    0x10: "switched_in",
+    0x11: "ready",
+    0x12: "create",
+    0x13: "delete",
+    0x14: "delay",
+    0x15: "delay_until",
+    0x16: "suspend",
+    0x17: "resume",
+    0x18: "resume_from_isr",
+    0x19: "priority_inherit",
+    0x1A: "priority_disinherit",
+    0x1B: "notify",
+    0x1C: "notify_from_isr",
+    0x1D: "notify_take_block",
+    0x1E: "notify_wait_block",
+}
+
+QUEUE_TYPES = ["queue", "mutex", "counting_semaphore", "binary_semaphore", "recursive_mutex"]
+
+QUEUE_EVENTS = {
+    0x28: "delete",
+    0x29: "send",
+    0x2A: "send_failed",
+    0x2B: "receive",
+    0x2C: "receive_failed",
+    0x2D: "peek",
+    0x2E: "send_from_isr",
+    0x2F: "receive_from_isr",
+    0x30: "block_send",
+    0x31: "block_receive",
+    0x32: "block_peek",
+    0x38: "block_stream_send",
+    0x39: "block_stream_receive",
+}
+
+# State of a task between blocking and becoming ready again.
+BLOCKING = {
+    0x14: "delayed",
+    0x15: "delayed",
+    0x1D: "waiting for notification",
+    0x1E: "waiting for notification",
+    0x30: "blocked on send",
+    0x31: "blocked on receive",
+    0x32: "blocked on peek",
+    0x38: "blocked on send",
+    0x39: "blocked on receive",
+}
+
+LOW_POWER_IDLE_BEGIN, LOW_POWER_IDLE_END = 0x40, 0x41
+USER = 0xC0
+
+PID = 1
+ISR_TID = 0
+
+
+def records(data):
+    """Yields (unit_ns, event, delta, obj) for each record after a header."""
+    start = data.find(MAGIC)
+    if start < 0:
+        sys.exit("no trace header (FRTR) found in the input")
+    pos = start
+    unit_ns = None
+    while pos + 4 <= len(data):
+        if data[pos:pos + 4] == MAGIC:
+            if pos + 8 > len(data):
+                break
+            version, _mode, unit_ns = struct.unpack_from("<BBH", data, pos + 4)
+            if version != FORMAT_VERSION:
+                sys.exit("unsupported trace format version %d" % version)
+            yield unit_ns, None, 0, 0
+            pos += 8
+            continue
+        event, delta, obj = struct.unpack_from("<BBH", data, pos)
+        yield unit_ns, event, delta, obj
+        pos += 4
+
+
+class Converter:
+    def __init__(self):
+        self.events = []
+        self.names = {}
+        self.pending_name = {}
+        self.tasks = set()
+        self.queues = {}
+        self.ticks = 0
+        self.ticks_high = 0
+        self.unit_ns = 1000
+        self.running = None
+        self.running_since = 0
+        self.running_args = None
+        self.sleep_since = 0
+        self.ready_since = {}
+        self.blocked = {}
+        self.dropped = 0
+        self.count = 0
+
+    def us(self, ticks=None):
+        return (self.ticks if ticks is None else ticks) * self.unit_ns / 1000.0
+
+    def name(self, obj):
+        if obj in self.names:
+            return self.names[obj]
+        kind = self.queues.get(obj, "task" if obj in self.tasks else "object")
+        return "%s_0x%04x" % (kind, obj)
+
+    def instant(self, name, tid, args=None, scope="t"):
+        event = {"name": name, "ph": "i", "s": scope, "pid": PID, "tid": tid, "ts": self.us()}
+        if args:
+            event["args"] = args
+        self.events.append(event)
+
+    def slice(self, name, tid, start, end, args=None):
+        event = {"name": name, "ph": "X", "pid": PID, "tid": tid,
+                 "ts": self.us(start), "dur": self.us(end - start)}
+        if args:
+            event["args"] = args
+        self.events.append(event)
+
+    def current(self):
+        return self.running if self.running is not None else ISR_TID
+
+    def switched_in(self, task):
+        if self.running is not None:
+            self.slice("running", self.running, self.running_since, self.ticks, self.running_args)
+            state = self.blocked.get(self.running)
+            if state is not None and state[1] is None:
+                self.blocked[self.running] = (state[0], self.ticks)
+        args = None
+        if task in self.ready_since:
+            args = {"ready_wait_us": self.us(self.ticks - self.ready_since.pop(task))}
+        self.running = task
+        self.running_since = self.ticks
+        self.running_args = args
+        self.tasks.add(task)
+
+    def ready(self, task):
+        self.tasks.add(task)
+        state = self.blocked.pop(task, None)
+        if state is not None and state[1] is not None:
+            self.slice(state[0], task, state[1], self.ticks)
+        if task != self.running:
+            self.ready_since.setdefault(task, self.ticks)
+
+    def feed(self, unit_ns, event, delta, obj):
+        if event is None:
+            # New header, e.g. after vTraceStart() was called again.
+            self.unit_ns = unit_ns
+            return
+        self.count += 1
+        if event == NAME:
+            if delta == 0:
+                self.names[obj] = self.pending_name.pop(obj, "")
+            else:
+                self.pending_name[obj] = self.pending_name.get(obj, "") + chr(delta)
+            return
+        if event == TIME:
+            self.ticks_high = (delta << 24) | (obj << 8)
+            return
+        self.ticks += self.ticks_high + delta
+        self.ticks_high = 0
+
+        if event == DROPPED:
+            self.dropped += obj
+            self.instant("dropped %d records" % obj, ISR_TID, scope="g")
+        elif event == 0x10:
+            self.switched_in(obj)
+        elif event == 0x11:
+            self.ready(obj)
+        elif event in TASK_EVENTS:
+            self.tasks.add(obj)
+            name = TASK_EVENTS[event]
+            if event in BLOCKING:
+                self.blocked[obj] = (BLOCKING[event], None)
+            elif event == 0x16 and obj == self.running:
+                self.blocked[obj] = ("suspended", None)
+            tid = ISR_TID if name.endswith("from_isr") else self.current()
+            self.instant(name, tid, {"task": self.name(obj)})
+        elif 0x20 <= event < 0x28:
+            kind = event - 0x20
+            self.queues[obj] = QUEUE_TYPES[kind] if kind < len(QUEUE_TYPES) else "queue"
+            self.instant("create " + self.queues[obj], self.current(), {"object": self.name(obj)})
+        elif event in QUEUE_EVENTS:
+            name = QUEUE_EVENTS[event]
+            if self.queues.get(obj, "queue") != "queue":
+                name = name.replace("send", "give").replace("receive", "take")
+            if event in BLOCKING and self.running is not None:
+                self.blocked[self.running] = ("%s %s" % (BLOCKING[event], self.name(obj)), None)
+            tid = ISR_TID if name.endswith("from_isr") else self.current()
+            self.instant("%s %s" % (name, self.name(obj)), tid)
+        elif event == LOW_POWER_IDLE_BEGIN:
+            self.sleep_since = self.ticks
+        elif event == LOW_POWER_IDLE_END:
+            self.slice("tickless idle", self.current(), self.sleep_since, self.ticks)
+        elif event >= USER:
+            self.instant("user %d" % (event - USER), self.current(), {"value": obj})
+        else:
+            self.instant("unknown 0x%02x" % event, ISR_TID, {"object": obj})
+
+    def finish(self):
+        if self.running is not None:
+            self.slice("running", self.running, self.running_since, self.ticks, self.running_args)
+        meta = [{"name": "process_name", "ph": "M", "pid": PID, "args": {"name": "FreeRTOS"}},
+                {"name": "thread_name", "ph": "M", "pid": PID, "tid": ISR_TID,
+                 "args": {"name": "Interrupts"}}]
+        for task in sorted(self.tasks):
+            meta.append({"name": "thread_name", "ph": "M", "pid": PID, "tid": task,
+                         "args": {"name": self.name(task)}})
+        return {"traceEvents": meta + self.events, "displayTimeUnit": "ns"}
+
+
+def read_port(port, baud, seconds):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("--port needs pyserial (pip install pyserial)")
+    data = bytearray()
+    with serial.Serial(port, baud, timeout=0.2) as link:
+        end = time.monotonic() + seconds
+        while time.monotonic() < end:
+            data += link.read(4096)
+    return bytes(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", help="captured bytes ('-' for stdin)")
+    parser.add_argument("--port", help="read from a serial port instead")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--seconds", type=float, default=10.0, help="time to read from --port")
+    parser.add_argument("-o", "--output", default="-", help="JSON file ('-' for stdout)")
+    args = parser.parse_args()
+
+    if args.port:
+        data = read_port(args.port, args.baud, args.seconds)
+    elif args.input == "-":
+        data = sys.stdin.buffer.read()
+    elif args.input:
+        with open(args.input, "rb") as stream:
+            data = stream.read()
+    else:
+        parser.error("an input file or --port is needed")
+
+    converter = Converter()
+    for record in records(data):
+        converter.feed(*record)
+    trace = converter.finish()
+
+    if args.output == "-":
+        json.dump(trace, sys.stdout)
+        sys.stdout.write("\n")
+    else:
+        with open(args.output, "w") as stream:
+            json.dump(trace, stream)
+    sys.stderr.write("%d records, %d tasks, %d dropped, %.3f ms\n"
+                     % (converter.count, len(converter.tasks), converter.dropped,
+                        converter.us() / 1000.0))
+
+
+if __name__ == "__main__":
+    main()
@@ -64,11 +64,36 @@
     #define portTCCRb                               TCCR0B
     #define portTIMSK                               TIMSK0
     #define portTIFR                                TIFR0
-
-#elif defined( portUSE_TIMER5 )
+    #define portRUN_TIME_TCNT                       TCNT0
+    #define portRUN_TIME_PENDING                    ( TIFR0 & _BV( OCF0A ) )
+    #define portRUN_TIME_COUNTS_PER_TICK            ( ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) / portCLOCK_PRESCALER )
+
+#elif( portUSE_TIMER1 == 1 )
+/* Hardware constants for Timer1. */
+    #warning "Timer1 used for scheduler."
+    #define portSCHEDULER_ISR           TIMER1_COMPA_vect
+    #define portRUN_TIME_TCNT           TCNT1
+    #define portRUN_TIME_PENDING        ( TIFR1 & _BV( OCF1A ) )
+    #define portRUN_TIME_COUNTS_PER_TICK    ( configCPU_CLOCK_HZ / ( 64 * configTICK_RATE_HZ ) )
+
+#elif( portUSE_TIMER5 == 1 )
 /* Hardware constants for Timer5. */
     #warning "Timer5 used for scheduler."
     #define portSCHEDULER_ISR           TIMER5_COMPA_vect
+    #define portRUN_TIME_TCNT           TCNT5
+    #define portRUN_TIME_PENDING        ( TIFR5 & _BV( OCF5A ) )
+    #define portRUN_TIME_COUNTS_PER_TICK    ( configCPU_CLOCK_HZ / ( 64 * configTICK_RATE_HZ ) )
+
+#elif( portUSE_TIMER2_ASYNC == 1 )
+/* Hardware constants for Timer2, clocked by a 32.768 kHz watch crystal on
+ * TOSC1/TOSC2. The counter runs freely at 256 Hz and the compare match A is
+ * advanced by one tick period on every tick. */
+    #warning "Asynchronous Timer2 used for scheduler."
+    #define portSCHEDULER_ISR               TIMER2_COMPA_vect
+    #define portTIMER2_PRESCALE_128         ( ( uint8_t ) ( _BV( CS22 ) | _BV( CS20 ) ) )
+    #define portTIMER2_COUNTER_HZ           ( ( uint32_t ) 32768 / 128 )
+    #define portTIMER2_COUNTS_PER_TICK      ( ( uint8_t ) ( portTIMER2_COUNTER_HZ / configTICK_RATE_HZ ) )
+    #define portTIMER2_UPDATE_BUSY          ( ( uint8_t ) ( _BV( TCN2UB ) | _BV( OCR2AUB ) | _BV( OCR2BUB ) | _BV( TCR2AUB ) | _BV( TCR2BUB ) ) )
 
 #else /* if defined( portUSE_WDTO ) */
     #error "No Timer defined for scheduler"
@@ -83,6 +108,144 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
 
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+
+/* Lookup tables for portRECORD_READY_PRIORITY(), portRESET_READY_PRIORITY()
+ * and portGET_HIGHEST_PRIORITY(), see portmacro.h. */
+    const uint8_t ucPortPriorityBitMask[ 8 ] PROGMEM =
+    {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+    };
+
+    const uint8_t ucPortHighestBitInNibble[ 16 ] PROGMEM =
+    {
+        0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3
+    };
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_AUTO_HEAP == 1 )
+
+/* Linker symbol of avr-libc marking the end of .bss and .noinit, and the
+ * current end of the memory used by malloc() (NULL until first used). */
+    extern uint8_t __heap_start;
+    extern char * __brkval;
+
+/* Start and size of the heap, fixed by the first call to prvAutoHeapInit(). */
+    static uint8_t * pucAutoHeapStart = NULL;
+    static size_t xAutoHeapSize = 0;
+
+/* Lowest address the stack of main() may use before the scheduler starts. */
+    #define portMAIN_STACK_END    ( ( uint8_t * ) RAMEND + 1 - portMAIN_STACK_MARGIN )
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_RUN_TIME_COUNTER == 1 ) && defined( portRUN_TIME_TCNT )
+
+/* Timer counts of all the completed tick periods. The run time counter adds
+ * the count of the tick timer in the current period. */
+    static volatile uint32_t ulRunTimeBase = 0;
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( configUSE_LATENCY_HISTOGRAMS == 1 )
+
+/* Start of the tick interrupt for the eLatencyTickISR histogram, static as
+ * vPortYieldFromTick() is naked and has no stack frame for locals. */
+    static uint32_t ulLatencyTickStart;
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_PC_PROFILER == 1 )
+
+/* Size of the frame of portSAVE_CONTEXT() including the frame tag, and of a
+ * return address on the stack. */
+    #if defined( __AVR_3_BYTE_PC__ ) && defined( __AVR_HAVE_RAMPZ__ )
+        #define portCONTEXT_FRAME_SIZE      ( 36U )
+    #elif defined( __AVR_HAVE_RAMPZ__ )
+        #define portCONTEXT_FRAME_SIZE      ( 35U )
+    #else
+        #define portCONTEXT_FRAME_SIZE      ( 34U )
+    #endif
+
+    #if defined( __AVR_3_BYTE_PC__ )
+        #define portRETURN_ADDRESS_SIZE     ( 3U )
+    #else
+        #define portRETURN_ADDRESS_SIZE     ( 2U )
+    #endif
+
+/*
+ * Samples the code interrupted by the tick for the PC profiler. Above the
+ * frame saved by vPortYieldFromTick() is the return address into the tick ISR
+ * and above that the one pushed by the interrupt, high byte first. Not inlined,
+ * as vPortYieldFromTick() is naked and has no stack frame for locals.
+ */
+    static void prvProfileTick( void ) __attribute__( ( noinline ) );
+    static void prvProfileTick( void )
+    {
+        /* The stack pointer saved into the TCB points below the frame. */
+        const uint8_t * pucPC = *( uint8_t * const * ) pxCurrentTCB;
+        uint32_t ulAddress = 0;
+
+        pucPC += 1U + portCONTEXT_FRAME_SIZE + portRETURN_ADDRESS_SIZE;
+
+        for( uint8_t x = 0; x < portRETURN_ADDRESS_SIZE; x++ )
+        {
+            ulAddress = ( ulAddress << 8 ) | pucPC[ x ];
+        }
+
+        /* Word address to byte address. */
+        vPcProfileSample( ulAddress << 1, ( void * ) pxCurrentTCB );
+    }
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portRECLAIM_MAIN_STACK == 1 )
+
+/* Lowest address of the main() stack still in use when the first task was
+ * started. The memory from here up to RAMEND is dead once the scheduler runs. */
+    static uint8_t * pucMainStackLow = NULL;
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_INTERRUPT_STACK == 1 )
+
+/* Stack shared by the kernel and by the ISRs declared with
+ * portINTERRUPT_STACK_ISR(), see portmacro.h. */
+    uint8_t ucPortInterruptStack[ portINTERRUPT_STACK_SIZE ];
+
+/* Number of portINTERRUPT_STACK_ISR() ISRs running, and whether one of them
+ * requested a context switch. */
+    volatile uint8_t ucPortInterruptNesting = 0;
+    volatile uint8_t ucPortYieldPending = pdFALSE;
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_TIMER2_ASYNC == 1 )
+
+/* Compare value of the next tick. Kept in RAM, because the asynchronous
+ * OCR2A may not yet hold the last written value when it is read back. */
+    static uint8_t ucNextTickCompare = portTIMER2_COUNTS_PER_TICK;
+
+#endif
+
+#if( configUSE_TICKLESS_IDLE == 1 ) && defined( portUSE_WDTO )
+
+/* Set by the tick interrupt, so a wake-up by the Watchdog Timer can be told
+ * apart from a wake-up by any other interrupt. */
+    static volatile uint8_t ucTickInterruptFired = 0;
+
+#endif
+
+/*-----------------------------------------------------------*/
+
 /**
  *  Enable the watchdog timer, configuring it for expire after
  *  (value) timeout (which is a combination of the WDP0
@@ -233,6 +396,10 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
  * #define __EIND__ 0x3C
  * #endif
  *
+ * The last byte pushed is the frame tag. A full frame is tagged with 0x00 (the
+ * freshly cleared __zero_reg__), a yield frame from portSAVE_YIELD_CONTEXT()
+ * is tagged with 0x01, so portRESTORE_CONTEXT() knows which shape to pop.
+ *
  * The interrupts will have been disabled during the call to portSAVE_CONTEXT()
  * so we need not worry about reading/writing to the stack pointer.
  */
@@ -279,6 +446,7 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
                            "push   r29                                     \n\t" \
                            "push   r30                                     \n\t" \
                            "push   r31                                     \n\t" \
+                           "push   __zero_reg__                            \n\t" \
                            "lds    r26, pxCurrentTCB                       \n\t" \
                            "lds    r27, pxCurrentTCB + 1                   \n\t" \
                            "in     __tmp_reg__, __SP_L__                   \n\t" \
@@ -327,6 +495,7 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
                            "push   r29                                     \n\t" \
                            "push   r30                                     \n\t" \
                            "push   r31                                     \n\t" \
+                           "push   __zero_reg__                            \n\t" \
                            "lds    r26, pxCurrentTCB                       \n\t" \
                            "lds    r27, pxCurrentTCB + 1                   \n\t" \
                            "in     __tmp_reg__, __SP_L__                   \n\t" \
@@ -373,6 +542,7 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
                            "push   r29                                     \n\t" \
                            "push   r30                                     \n\t" \
                            "push   r31                                     \n\t" \
+                           "push   __zero_reg__                            \n\t" \
                            "lds    r26, pxCurrentTCB                       \n\t" \
                            "lds    r27, pxCurrentTCB + 1                   \n\t" \
                            "in     __tmp_reg__, __SP_L__                   \n\t" \
@@ -383,8 +553,59 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
 #endif /* if defined( __AVR_3_BYTE_PC__ ) && defined( __AVR_HAVE_RAMPZ__ ) */
 
 /*
- * Opposite to portSAVE_CONTEXT().  Interrupts will have been disabled during
- * the context save so we can write to the stack pointer.
+ * Macro to save the context of a task that gives up the processor voluntarily
+ * through vPortYield().
+ *
+ * vPortYield() is entered by an ordinary call, so the avr-gcc ABI already lets
+ * it clobber r0, r18 - r27, r30 and r31, and guarantees r1 to be zero. RAMPZ is
+ * set up by the compiler before every use and EIND never changes at run time.
+ * Only SREG and the call-saved registers r2 - r17, r28 and r29 have to survive
+ * the switch, which takes 20 bytes of stack instead of the 34 bytes of a full
+ * frame (35 with RAMPZ, 36 with RAMPZ and EIND).
+ *
+ * Cycle counts (save + restore, RAMPZ and EIND excluded):
+ *
+ *      full frame:     81 + 82 = 163 cycles
+ *      yield frame:    53 + 55 = 108 cycles
+ */
+    #define portSAVE_YIELD_CONTEXT()                                             \
+    __asm__ __volatile__ ( "in     __tmp_reg__, __SREG__                   \n\t" \
+                           "cli                                            \n\t" \
+                           "push   __tmp_reg__                             \n\t" \
+                           "push   r2                                      \n\t" \
+                           "push   r3                                      \n\t" \
+                           "push   r4                                      \n\t" \
+                           "push   r5                                      \n\t" \
+                           "push   r6                                      \n\t" \
+                           "push   r7                                      \n\t" \
+                           "push   r8                                      \n\t" \
+                           "push   r9                                      \n\t" \
+                           "push   r10                                     \n\t" \
+                           "push   r11                                     \n\t" \
+                           "push   r12                                     \n\t" \
+                           "push   r13                                     \n\t" \
+                           "push   r14                                     \n\t" \
+                           "push   r15                                     \n\t" \
+                           "push   r16                                     \n\t" \
+                           "push   r17                                     \n\t" \
+                           "push   r28                                     \n\t" \
+                           "push   r29                                     \n\t" \
+                           "ldi    r26, 0x01                               \n\t" \
+                           "push   r26                                     \n\t" \
+                           "lds    r26, pxCurrentTCB                       \n\t" \
+                           "lds    r27, pxCurrentTCB + 1                   \n\t" \
+                           "in     __tmp_reg__, __SP_L__                   \n\t" \
+                           "st     x+, __tmp_reg__                         \n\t" \
+                           "in     __tmp_reg__, __SP_H__                   \n\t" \
+                           "st     x+, __tmp_reg__                         \n\t" \
+                           );
+/*-----------------------------------------------------------*/
+
+/*
+ * Opposite to portSAVE_CONTEXT() and portSAVE_YIELD_CONTEXT(). The frame tag
+ * on top of the stack selects whether a yield frame or a full frame is popped.
+ * Interrupts will have been disabled during the context save so we can write
+ * to the stack pointer.
  */
 #if defined( __AVR_3_BYTE_PC__ ) && defined( __AVR_HAVE_RAMPZ__ )
 /* 3-Byte PC Restore with RAMPZ */
@@ -395,6 +616,31 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
                            "out    __SP_L__, r28                           \n\t" \
                            "ld     r29, x+                                 \n\t" \
                            "out    __SP_H__, r29                           \n\t" \
+                           "pop    __tmp_reg__                             \n\t" \
+                           "tst    __tmp_reg__                             \n\t" \
+                           "breq   1f                                      \n\t" \
+                           "pop    r29                                     \n\t" \
+                           "pop    r28                                     \n\t" \
+                           "pop    r17                                     \n\t" \
+                           "pop    r16                                     \n\t" \
+                           "pop    r15                                     \n\t" \
+                           "pop    r14                                     \n\t" \
+                           "pop    r13                                     \n\t" \
+                           "pop    r12                                     \n\t" \
+                           "pop    r11                                     \n\t" \
+                           "pop    r10                                     \n\t" \
+                           "pop    r9                                      \n\t" \
+                           "pop    r8                                      \n\t" \
+                           "pop    r7                                      \n\t" \
+                           "pop    r6                                      \n\t" \
+                           "pop    r5                                      \n\t" \
+                           "pop    r4                                      \n\t" \
+                           "pop    r3                                      \n\t" \
+                           "pop    r2                                      \n\t" \
+                           "pop    __tmp_reg__                             \n\t" \
+                           "out    __SREG__, __tmp_reg__                   \n\t" \
+                           "rjmp   2f                                      \n\t" \
+                           "1:                                             \n\t" \
                            "pop    r31                                     \n\t" \
                            "pop    r30                                     \n\t" \
                            "pop    r29                                     \n\t" \
@@ -433,6 +679,7 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
                            "pop    __tmp_reg__                             \n\t" \
                            "out    __SREG__, __tmp_reg__                   \n\t" \
                            "pop    __tmp_reg__                             \n\t" \
+                           "2:                                             \n\t" \
                            );
 #elif defined( __AVR_HAVE_RAMPZ__ )
 /* 2-Byte PC Restore with RAMPZ */
@@ -443,6 +690,31 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
                            "out    __SP_L__, r28                           \n\t" \
                            "ld     r29, x+                                 \n\t" \
                            "out    __SP_H__, r29                           \n\t" \
+                           "pop    __tmp_reg__                             \n\t" \
+                           "tst    __tmp_reg__                             \n\t" \
+                           "breq   1f                                      \n\t" \
+                           "pop    r29                                     \n\t" \
+                           "pop    r28                                     \n\t" \
+                           "pop    r17                                     \n\t" \
+                           "pop    r16                                     \n\t" \
+                           "pop    r15                                     \n\t" \
+                           "pop    r14                                     \n\t" \
+                           "pop    r13                                     \n\t" \
+                           "pop    r12                                     \n\t" \
+                           "pop    r11                                     \n\t" \
+                           "pop    r10                                     \n\t" \
+                           "pop    r9                                      \n\t" \
+                           "pop    r8                                      \n\t" \
+                           "pop    r7                                      \n\t" \
+                           "pop    r6                                      \n\t" \
+                           "pop    r5                                      \n\t" \
+                           "pop    r4                                      \n\t" \
+                           "pop    r3                                      \n\t" \
+                           "pop    r2                                      \n\t" \
+                           "pop    __tmp_reg__                             \n\t" \
+                           "out    __SREG__, __tmp_reg__                   \n\t" \
+                           "rjmp   2f                                      \n\t" \
+                           "1:                                             \n\t" \
                            "pop    r31                                     \n\t" \
                            "pop    r30                                     \n\t" \
                            "pop    r29                                     \n\t" \
@@ -479,6 +751,7 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
                            "pop    __tmp_reg__                             \n\t" \
                            "out    __SREG__, __tmp_reg__                   \n\t" \
                            "pop    __tmp_reg__                             \n\t" \
+                           "2:                                             \n\t" \
                            );
 #else /* if defined( __AVR_3_BYTE_PC__ ) && defined( __AVR_HAVE_RAMPZ__ ) */
 /* 2-Byte PC Restore */
@@ -489,6 +762,31 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
                            "out    __SP_L__, r28                           \n\t" \
                            "ld     r29, x+                                 \n\t" \
                            "out    __SP_H__, r29                           \n\t" \
+                           "pop    __tmp_reg__                             \n\t" \
+                           "tst    __tmp_reg__                             \n\t" \
+                           "breq   1f                                      \n\t" \
+                           "pop    r29                                     \n\t" \
+                           "pop    r28                                     \n\t" \
+                           "pop    r17                                     \n\t" \
+                           "pop    r16                                     \n\t" \
+                           "pop    r15                                     \n\t" \
+                           "pop    r14                                     \n\t" \
+                           "pop    r13                                     \n\t" \
+                           "pop    r12                                     \n\t" \
+                           "pop    r11                                     \n\t" \
+                           "pop    r10                                     \n\t" \
+                           "pop    r9                                      \n\t" \
+                           "pop    r8                                      \n\t" \
+                           "pop    r7                                      \n\t" \
+                           "pop    r6                                      \n\t" \
+                           "pop    r5                                      \n\t" \
+                           "pop    r4                                      \n\t" \
+                           "pop    r3                                      \n\t" \
+                           "pop    r2                                      \n\t" \
+                           "pop    __tmp_reg__                             \n\t" \
+                           "out    __SREG__, __tmp_reg__                   \n\t" \
+                           "rjmp   2f                                      \n\t" \
+                           "1:                                             \n\t" \
                            "pop    r31                                     \n\t" \
                            "pop    r30                                     \n\t" \
                            "pop    r29                                     \n\t" \
@@ -523,6 +821,7 @@ extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
                            "pop    __tmp_reg__                             \n\t" \
                            "out    __SREG__, __tmp_reg__                   \n\t" \
                            "pop    __tmp_reg__                             \n\t" \
+                           "2:                                             \n\t" \
                            );
 #endif /* if defined( __AVR_3_BYTE_PC__ ) && defined( __AVR_HAVE_RAMPZ__ ) */
 /*-----------------------------------------------------------*/
@@ -615,6 +914,11 @@ StackType_t * pxPortInitialiseStack( StackType_t * pxTopOfStack,
     /* Leave register R26 - R31 untouched */
     pxTopOfStack -= 7;
 
+    /* The first context of a task is always restored as a full frame, because
+     * the parameter has to be passed in R24/R25. */
+    *pxTopOfStack = ( StackType_t ) 0x00; /* Frame tag */
+    pxTopOfStack--;
+
     return pxTopOfStack;
 }
 /*-----------------------------------------------------------*/
@@ -624,6 +928,21 @@ BaseType_t xPortStartScheduler( void )
     /* Setup the relevant timer hardware to generate the tick. */
     prvSetupTimerInterrupt();
 
+    #if( portRECLAIM_MAIN_STACK == 1 )
+    {
+        /* SP points to the next free byte, everything above it belongs to the
+         * frames of xPortStartScheduler(), vTaskStartScheduler(), setup() and
+         * main(), which are never returned to. */
+        pucMainStackLow = ( uint8_t * ) SP + 1;
+
+        /* Keep malloc() of avr-libc below the reclaimed region. */
+        if( ( __malloc_heap_end == NULL ) || ( __malloc_heap_end > ( char * ) pucMainStackLow ) )
+        {
+            __malloc_heap_end = ( char * ) pucMainStackLow;
+        }
+    }
+    #endif
+
     /* Restore the context of the first task that is going to run. */
     portRESTORE_CONTEXT();
 
@@ -636,6 +955,167 @@ BaseType_t xPortStartScheduler( void )
 }
 /*-----------------------------------------------------------*/
 
+#if( portRECLAIM_MAIN_STACK == 1 )
+
+    void vPortReclaimMainStack( void )
+    {
+        uint8_t * pucRegion;
+
+        taskENTER_CRITICAL();
+        {
+            pucRegion = pucMainStackLow;
+            pucMainStackLow = NULL;
+        }
+        taskEXIT_CRITICAL();
+
+        #if( portUSE_AUTO_HEAP == 1 )
+        {
+            /* The heap already takes the memory up to the margin left for the
+             * stack of main(), so only the margin itself is added. */
+            configASSERT( ( pucRegion == NULL ) || ( pucRegion >= portMAIN_STACK_END ) );
+
+            if( pucRegion != NULL )
+            {
+                pucRegion = portMAIN_STACK_END;
+            }
+        }
+        #endif
+
+        if( pucRegion != NULL )
+        {
+            vPortAddHeapRegion( pucRegion, ( size_t ) ( ( uint8_t * ) RAMEND + 1 - pucRegion ) );
+        }
+    }
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_AUTO_HEAP == 1 )
+
+/*
+ * Place the heap between the memory of malloc() and the stack of main(). This
+ * happens on the first call to pvPortMalloc(), usually by xTaskCreate() from
+ * setup().
+ */
+    static void prvAutoHeapInit( void )
+    {
+        uint8_t * pucStart;
+
+        if( pucAutoHeapStart == NULL )
+        {
+            pucStart = &__heap_start + portMALLOC_HEAP_RESERVE;
+
+            if( ( uint8_t * ) __brkval > pucStart )
+            {
+                pucStart = ( uint8_t * ) __brkval;
+            }
+
+            /* The stack of main() must not have grown into the heap already. */
+            configASSERT( portMAIN_STACK_END > pucStart );
+            configASSERT( ( uint8_t * ) SP >= portMAIN_STACK_END );
+
+            /* Keep malloc() of avr-libc below the heap. */
+            __malloc_heap_end = ( char * ) pucStart;
+
+            xAutoHeapSize = ( size_t ) ( portMAIN_STACK_END - pucStart );
+            pucAutoHeapStart = pucStart;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    uint8_t * pucPortGetHeapStart( void )
+    {
+        prvAutoHeapInit();
+
+        return pucAutoHeapStart;
+    }
+/*-----------------------------------------------------------*/
+
+    size_t xPortGetHeapSize( void )
+    {
+        prvAutoHeapInit();
+
+        return xAutoHeapSize;
+    }
+
+#else /* if ( portUSE_AUTO_HEAP == 1 ) */
+
+    size_t xPortGetHeapSize( void )
+    {
+        return configTOTAL_HEAP_SIZE;
+    }
+
+#endif /* if ( portUSE_AUTO_HEAP == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( portUSE_XMEM == 1 )
+
+/*
+ * Enable the external memory interface in .init3, before .data and .bss are
+ * set up, so the heap can place blocks there from the first allocation on. The
+ * whole external memory is the upper sector, so its wait states are set with
+ * SRW11:SRW10. The function is naked and runs into .init4.
+ */
+    static void prvXmemInit( void ) __attribute__( ( naked, used, section( ".init3" ) ) );
+
+    static void prvXmemInit( void )
+    {
+        XMCRB = 0;
+        XMCRA = ( uint8_t ) ( _BV( SRE ) | ( ( portXMEM_WAIT_STATES & 0x03 ) << SRW10 ) );
+    }
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_RUN_TIME_COUNTER == 1 )
+
+/*
+ * Run time counter for the run time statistics, read on every context switch,
+ * and the timestamp of the latency histograms.
+ *
+ * With Timer0, Timer1 or Timer5 generating the tick, the counter of the tick
+ * timer is extended to 32 bits by the tick count kept in ulRunTimeBase, so no
+ * further timer is needed. One count is 64 CPU cycles (4 us at 16 MHz) for
+ * Timer1 and Timer5, and 1024 CPU cycles for Timer0.
+ *
+ * The Watchdog Timer has no readable counter, and asynchronous Timer2 counts
+ * too slow, so micros() of the Arduino core (Timer0) is used instead. One
+ * count is 1 us then, with a resolution of 4 us at 16 MHz.
+ */
+    uint32_t ulPortGetRunTimeCounterValue( void )
+    {
+        #if defined( portRUN_TIME_TCNT )
+            uint32_t ulBase;
+            uint16_t usCount;
+            uint8_t ucSREG;
+
+            ucSREG = SREG;
+            portDISABLE_INTERRUPTS();
+            {
+                ulBase = ulRunTimeBase;
+                usCount = portRUN_TIME_TCNT;
+
+                /* The timer has already cleared the counter on compare match,
+                 * but the tick interrupt has not yet added the period. */
+                if( portRUN_TIME_PENDING != 0 )
+                {
+                    usCount = portRUN_TIME_TCNT;
+                    ulBase += portRUN_TIME_COUNTS_PER_TICK;
+                }
+            }
+            SREG = ucSREG;
+
+            return ulBase + usCount;
+        #else
+            extern unsigned long micros( void );
+
+            return micros();
+        #endif
+    }
+
+#endif
+/*-----------------------------------------------------------*/
+
 void vPortEndScheduler( void )
 {
     /* It is unlikely that the ATmega port will get stopped. */
@@ -644,12 +1124,18 @@ void vPortEndScheduler( void )
 
 /*
  * Manual context switch. The first thing we do is save the registers so we
- * can use a naked attribute.
+ * can use a naked attribute. As this is always a function call, only the
+ * call-saved registers are stored (see portSAVE_YIELD_CONTEXT()).
  */
 void vPortYield( void ) __attribute__( ( hot, flatten, naked ) );
 void vPortYield( void )
 {
-    portSAVE_CONTEXT();
+    portSAVE_YIELD_CONTEXT();
+
+    #if( portUSE_INTERRUPT_STACK == 1 )
+        portSWITCH_TO_INTERRUPT_STACK();
+    #endif
+
     vTaskSwitchContext();
     portRESTORE_CONTEXT();
 
@@ -665,6 +1151,11 @@ void vPortYieldFromISR( void ) __attribute__( ( hot, flatten, naked ) );
 void vPortYieldFromISR( void )
 {
     portSAVE_CONTEXT();
+
+    #if( portUSE_INTERRUPT_STACK == 1 )
+        portSWITCH_TO_INTERRUPT_STACK();
+    #endif
+
     vTaskSwitchContext();
     portRESTORE_CONTEXT();
 
@@ -683,10 +1174,57 @@ void vPortYieldFromTick( void )
 {
     portSAVE_CONTEXT();
 
-    if( xTaskIncrementTick() != pdFALSE )
-    {
-        vTaskSwitchContext();
-    }
+    #if( portUSE_TIMER2_ASYNC == 1 )
+        ucNextTickCompare += portTIMER2_COUNTS_PER_TICK;
+        OCR2A = ucNextTickCompare;
+    #endif
+
+    #if( configUSE_TICKLESS_IDLE == 1 ) && defined( portUSE_WDTO )
+        ucTickInterruptFired = 1;
+    #endif
+
+    #if( portUSE_RUN_TIME_COUNTER == 1 ) && defined( portRUN_TIME_TCNT )
+        ulRunTimeBase += portRUN_TIME_COUNTS_PER_TICK;
+    #endif
+
+    #if( configUSE_LATENCY_HISTOGRAMS == 1 )
+        ulLatencyTickStart = portGET_LATENCY_TIMESTAMP();
+    #endif
+
+    #if( portUSE_PC_PROFILER == 1 )
+        prvProfileTick();
+    #endif
+
+    #if( portUSE_INTERRUPT_STACK == 1 )
+        if( ucPortInterruptNesting != 0 )
+        {
+            /* The tick interrupted an ISR that runs on the interrupt stack,
+             * so the context just saved is not the one of a task. Leave the
+             * switch to the ISR when it returns to the task stack. */
+            if( xTaskIncrementTick() != pdFALSE )
+            {
+                ucPortYieldPending = pdTRUE;
+            }
+        }
+        else
+        {
+            portSWITCH_TO_INTERRUPT_STACK();
+
+            if( xTaskIncrementTick() != pdFALSE )
+            {
+                vTaskSwitchContext();
+            }
+        }
+    #else
+        if( xTaskIncrementTick() != pdFALSE )
+        {
+            vTaskSwitchContext();
+        }
+    #endif
+
+    #if( configUSE_LATENCY_HISTOGRAMS == 1 )
+        vTaskRecordLatency( eLatencyTickISR, ulLatencyTickStart );
+    #endif
 
     portRESTORE_CONTEXT();
 
@@ -745,7 +1283,42 @@ void vPortYieldFromTick( void )
         portTIMSK = ucLowByte;
     }
 
-#elif defined (portUSE_TIMER5)
+#elif( portUSE_TIMER1 == 1 )
+
+/*
+ * Setup Timer1 compare match A to generate a tick interrupt.
+ *
+ * INFO :   Timer1 is configured in the Arduino core implementation (wiring.c)
+ *          for the PWM of pin 9 and 10, and the Servo library uses it too.
+ *          Both are not available when Timer1 generates the tick. Timer0 and
+ *          millis() are not touched.
+ */
+    static void prvSetupTimerInterrupt( void )
+    {
+        /* The Arduino core implementation sets bit WGM10 to put Timer1 in 8-bit
+         * phase correct PWM mode. TCCR1A must be cleared before OCR1A is
+         * written, just like for Timer5. */
+        TCCR1A = ( 0 << WGM11 ) | ( 0 << WGM10 );
+
+        /* CTC mode (only WGM12 set) with a prescaler of 64 (CS11 and CS10). */
+        TCCR1B = ( 0 << WGM13 ) | ( 1 << WGM12 ) | ( 0 << CS12 ) | ( 1 << CS11 ) | ( 1 << CS10 );
+
+        /* Output Compare Register (OCRnx) value formular:
+        *
+        *               f_CPU
+        * OCRnx = ---------------- - 1
+        *         prescaler * f_OC
+        *
+        * With 16 MHz the slowest possible tick rate is 4 Hz.
+        */
+        OCR1A = ( configCPU_CLOCK_HZ / ( 64 * configTICK_RATE_HZ ) ) - 1;
+
+        /* Set the OCIE1A (Output Compare Interrupt Enable) bit in TIMSK1, so
+         * the ISR gets called when OCR1A and TCNT1 match. */
+        TIMSK1 = ( 1 << OCIE1A );
+    }
+
+#elif( portUSE_TIMER5 == 1 )
 
 /*
  * Setup Timer5 compare match A to generate a tick interrupt.
@@ -794,6 +1367,41 @@ void vPortYieldFromTick( void )
         TIMSK5 = ( 1 << OCIE5A );
     }
 
+#elif( portUSE_TIMER2_ASYNC == 1 )
+
+/*
+ * Setup the asynchronous Timer2 compare match A to generate a tick interrupt.
+ *
+ * INFO :   The Arduino core implementation (wiring.c) configures Timer2 for the
+ *          PWM of pin 9 and 10, and tone() uses it too. Both are not available
+ *          when Timer2 generates the tick.
+ */
+    static void prvSetupTimerInterrupt( void )
+    {
+        configASSERT( ( portTIMER2_COUNTER_HZ % configTICK_RATE_HZ ) == 0 );
+
+        /* The interrupts must be disabled while the clock source is switched,
+         * because the counter and control registers may get corrupted. */
+        TIMSK2 = 0;
+        ASSR = _BV( AS2 );
+
+        /* Normal mode, the counter runs freely and the compare match A is
+         * moved forward by one tick period in every tick interrupt. */
+        TCNT2 = 0;
+        OCR2A = ucNextTickCompare;
+        TCCR2A = 0;
+        TCCR2B = portTIMER2_PRESCALE_128;
+
+        /* Wait until the new settings got transferred to the asynchronous
+         * clock domain. */
+        while( ( ASSR & portTIMER2_UPDATE_BUSY ) != 0 )
+        {
+        }
+
+        TIFR2 = _BV( OCF2B ) | _BV( OCF2A ) | _BV( TOV2 );
+        TIMSK2 = _BV( OCIE2A );
+    }
+
 #endif /* if defined( portUSE_WDTO ) */
 
 /*-----------------------------------------------------------*/
@@ -832,8 +1440,278 @@ void vPortYieldFromTick( void )
  */
     ISR( portSCHEDULER_ISR )
     {
+        #if( portUSE_TIMER2_ASYNC == 1 )
+            ucNextTickCompare += portTIMER2_COUNTS_PER_TICK;
+            OCR2A = ucNextTickCompare;
+        #endif
+
+        #if( configUSE_TICKLESS_IDLE == 1 ) && defined( portUSE_WDTO )
+            ucTickInterruptFired = 1;
+        #endif
+
+        #if( portUSE_RUN_TIME_COUNTER == 1 ) && defined( portRUN_TIME_TCNT )
+            ulRunTimeBase += portRUN_TIME_COUNTS_PER_TICK;
+        #endif
+
+        #if( configUSE_LATENCY_HISTOGRAMS == 1 )
+            ulLatencyTickStart = portGET_LATENCY_TIMESTAMP();
+        #endif
+
         xTaskIncrementTick();
+
+        #if( configUSE_LATENCY_HISTOGRAMS == 1 )
+            vTaskRecordLatency( eLatencyTickISR, ulLatencyTickStart );
+        #endif
     }
 #endif /* if configUSE_PREEMPTION == 1 */
+/*-----------------------------------------------------------*/
+
+#if( configUSE_TICKLESS_IDLE == 1 )
+
+/* Sleep mode used while the ticks are suppressed. The Watchdog Timer keeps
+ * running in power-down, the asynchronous Timer2 needs power-save. Define
+ * SLEEP_MODE_IDLE here if peripherals like the UART have to stay alive. */
+    #ifndef portTICKLESS_SLEEP_MODE
+        #if defined( portUSE_WDTO )
+            #define portTICKLESS_SLEEP_MODE    SLEEP_MODE_PWR_DOWN
+        #else
+            #define portTICKLESS_SLEEP_MODE    SLEEP_MODE_PWR_SAVE
+        #endif
+    #endif
+
+    #if defined( portUSE_WDTO )
+
+/*
+ * The Watchdog Timer has no readable counter, so it is reprogrammed to the
+ * longest period (up to WDTO_8S) that does not exceed the expected idle time.
+ * Each prescaler step doubles the period, which is a whole number of ticks.
+ *
+ * The wake-up is the tick interrupt itself, which already counts one tick. If
+ * any other interrupt wakes the MCU early, the time spent asleep can not be
+ * measured and the tick count slips by up to one sleep period.
+ */
+        __attribute__( ( weak ) ) void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+        {
+            eSleepModeStatus eSleepStatus;
+            TickType_t xModifiableIdleTime = xExpectedIdleTime;
+            TickType_t xSleepTicks = 1;
+            uint8_t ucPeriod = portUSE_WDTO;
+
+            /* Enter a critical section that will not effect interrupts bringing
+             * the MCU out of sleep mode. */
+            portDISABLE_INTERRUPTS();
+
+            /* Ensure it is still ok to enter the sleep mode. */
+            eSleepStatus = eTaskConfirmSleepModeStatus();
+
+            if( eSleepStatus == eAbortSleep )
+            {
+                /* A task has been moved out of the Blocked state since this
+                 * macro was executed, or a context switch is being held
+                 * pending. Do not enter a sleep state. */
+                portENABLE_INTERRUPTS();
+            }
+            else if( eSleepStatus == eNoTasksWaitingTimeout )
+            {
+                /* No task waits for a timeout, so only an external interrupt
+                 * can make one ready again. Switch the Watchdog Timer off and
+                 * sleep until then. The tick count does not advance. */
+                wdt_disable();
+
+                configPRE_PWR_DOWN_PROCESSING();
+                portSET_MODE_AND_SLEEP( SLEEP_MODE_PWR_DOWN );
+                configPOST_PWR_DOWN_PROCESSING();
+
+                wdt_interrupt_enable( portUSE_WDTO );
+                portENABLE_INTERRUPTS();
+            }
+            else
+            {
+                /* The application may shorten the sleep, or veto it by
+                 * setting the idle time to 0. */
+                configPRE_SLEEP_PROCESSING( xModifiableIdleTime );
+
+                if( xModifiableIdleTime > 0 )
+                {
+                    while( ( ucPeriod < WDTO_8S ) && ( ( TickType_t ) ( xSleepTicks << 1 ) <= xModifiableIdleTime ) )
+                    {
+                        ucPeriod++;
+                        xSleepTicks <<= 1;
+                    }
+
+                    ucTickInterruptFired = 0;
+                    wdt_interrupt_enable( ucPeriod );
+
+                    portSET_MODE_AND_SLEEP( portTICKLESS_SLEEP_MODE );
+
+                    /* Back to the normal tick period. This also restarts the
+                     * watchdog counter. */
+                    wdt_interrupt_enable( portUSE_WDTO );
+
+                    if( ucTickInterruptFired != 0 )
+                    {
+                        /* The tick interrupt that woke us up already counted
+                         * the last tick of the sleep period. */
+                        vTaskStepTick( xSleepTicks - 1 );
+                    }
+                }
+
+                configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+
+                portENABLE_INTERRUPTS();
+            }
+        }
+
+    #else /* if defined( portUSE_WDTO ) */
+
+/*
+ * Synchronise with the asynchronous clock domain and read the counter. This
+ * also makes sure at least one TOSC1 cycle passed since the last wake-up, so
+ * the compare interrupt logic is ready to wake the MCU again.
+ */
+        static uint8_t prvReadTimer2( void )
+        {
+            TCCR2A = 0;
+
+            while( ( ASSR & _BV( TCR2AUB ) ) != 0 )
+            {
+            }
+
+            return TCNT2;
+        }
+
+/* The compare match B only wakes the MCU, all the work is done in
+ * vPortSuppressTicksAndSleep(). */
+        EMPTY_INTERRUPT( TIMER2_COMPB_vect )
+
+/*
+ * While the ticks are suppressed, the compare match B wakes the MCU at most
+ * 255 counts (~1 s) ahead. As long as nothing made a task ready, the wake-up is
+ * chained to the next window without leaving this function, until the
+ * expected idle time is over. The free running counter measures the time
+ * actually spent, so early wake-ups do not slip the tick count.
+ */
+        __attribute__( ( weak ) ) void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+        {
+            eSleepModeStatus eSleepStatus;
+            TickType_t xModifiableIdleTime = xExpectedIdleTime;
+            TickType_t xCompleteTicks;
+            uint32_t ulElapsedCounts, ulTargetCounts, ulWindow;
+            uint8_t ucLastTick, ucLastCount, ucCount;
+
+            portDISABLE_INTERRUPTS();
+
+            eSleepStatus = eTaskConfirmSleepModeStatus();
+
+            if( eSleepStatus == eAbortSleep )
+            {
+                portENABLE_INTERRUPTS();
+            }
+            else
+            {
+                /* Stop the tick interrupt, the counter keeps running and
+                 * measures the time since the last tick. */
+                TIMSK2 &= ( uint8_t ) ~_BV( OCIE2A );
+
+                ucLastTick = ( uint8_t ) ( ucNextTickCompare - portTIMER2_COUNTS_PER_TICK );
+                ucLastCount = prvReadTimer2();
+                ulElapsedCounts = ( uint8_t ) ( ucLastCount - ucLastTick );
+
+                if( eSleepStatus == eNoTasksWaitingTimeout )
+                {
+                    /* Timer2 stops in power-down, the tick count does not
+                     * advance until an external interrupt wakes the MCU. */
+                    configPRE_PWR_DOWN_PROCESSING();
+                    portSET_MODE_AND_SLEEP( SLEEP_MODE_PWR_DOWN );
+                    configPOST_PWR_DOWN_PROCESSING();
+
+                    ucLastTick = prvReadTimer2();
+                    ulElapsedCounts = 0;
+                }
+                else
+                {
+                    configPRE_SLEEP_PROCESSING( xModifiableIdleTime );
+
+                    /* Wake up one tick early, the last tick of the idle time
+                     * is handled by the tick interrupt as usual. */
+                    if( xModifiableIdleTime > 1 )
+                    {
+                        ulTargetCounts = ( uint32_t ) ( xModifiableIdleTime - 1 ) * portTIMER2_COUNTS_PER_TICK;
+                    }
+                    else
+                    {
+                        ulTargetCounts = 0;
+                    }
+
+                    while( ulElapsedCounts < ulTargetCounts )
+                    {
+                        ulWindow = ulTargetCounts - ulElapsedCounts;
+
+                        if( ulWindow > 0xFF )
+                        {
+                            ulWindow = 0xFF;
+                        }
+
+                        OCR2B = ( uint8_t ) ( ucLastCount + ( uint8_t ) ulWindow );
+
+                        while( ( ASSR & _BV( OCR2BUB ) ) != 0 )
+                        {
+                        }
+
+                        TIFR2 = _BV( OCF2B );
+                        TIMSK2 |= _BV( OCIE2B );
+
+                        portSET_MODE_AND_SLEEP( portTICKLESS_SLEEP_MODE );
+
+                        TIMSK2 &= ( uint8_t ) ~_BV( OCIE2B );
+
+                        ucCount = prvReadTimer2();
+                        ulElapsedCounts += ( uint8_t ) ( ucCount - ucLastCount );
+                        ucLastCount = ucCount;
+
+                        /* Stop chaining as soon as an interrupt made a task
+                         * ready. */
+                        if( eTaskConfirmSleepModeStatus() == eAbortSleep )
+                        {
+                            break;
+                        }
+                    }
+
+                    configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+                }
+
+                /* Correct the kernels tick count and continue with the tick
+                 * period that is currently in progress. */
+                xCompleteTicks = ( TickType_t ) ( ulElapsedCounts / portTIMER2_COUNTS_PER_TICK );
+
+                ucNextTickCompare = ( uint8_t ) ( ucLastTick + ( uint8_t ) ( ( xCompleteTicks + 1 ) * portTIMER2_COUNTS_PER_TICK ) );
+                OCR2A = ucNextTickCompare;
+
+                /* A late wake-up must not step the tick count past the time
+                 * the next task is due. */
+                if( xCompleteTicks >= xExpectedIdleTime )
+                {
+                    xCompleteTicks = xExpectedIdleTime - 1;
+                }
+
+                while( ( ASSR & _BV( OCR2AUB ) ) != 0 )
+                {
+                }
+
+                TIFR2 = _BV( OCF2A );
+                TIMSK2 |= _BV( OCIE2A );
+
+                if( xCompleteTicks > 0 )
+                {
+                    vTaskStepTick( xCompleteTicks );
+                }
+
+                portENABLE_INTERRUPTS();
+            }
+        }
+
+    #endif /* if defined( portUSE_WDTO ) */
+
+#endif /* if ( configUSE_TICKLESS_IDLE == 1 ) */
 
 #endif
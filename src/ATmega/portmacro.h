@@ -51,6 +51,7 @@
  */
 
 #include <avr/wdt.h>
+#include <avr/sleep.h>
 
 /* Type definitions. */
 #define portCHAR                 char
@@ -78,6 +79,8 @@ typedef uint8_t        UBaseType_t;
 
 /* Critical section management. */
 
+#if ( portUSE_CRITICAL_PROFILER == 0 )
+
 #define portENTER_CRITICAL()                        \
     __asm__ __volatile__ (                          \
         "in __tmp_reg__, __SREG__"        "\n\t"    \
@@ -94,6 +97,44 @@ typedef uint8_t        UBaseType_t;
         ::: "memory"                                \
         )
 
+#else
+
+/* Profiled critical sections, see critical_profiler.h. Only the sections that
+ * mask the interrupts (SREG bit I set before) and the exits that unmask them
+ * again are timed. */
+#define portENTER_CRITICAL()                                        \
+    do {                                                            \
+        const uint8_t ucProfileSREG = SREG;                         \
+        __asm__ __volatile__ (                                      \
+            "cli"                             "\n\t"                \
+            "push %0"                         "\n\t"                \
+            :: "r" ( ucProfileSREG ) : "memory"                     \
+            );                                                      \
+        if( ( ucProfileSREG & _BV( SREG_I ) ) != 0 )                \
+        {                                                           \
+            vCriticalProfileEnter();                                \
+        }                                                           \
+    } while( 0 )
+
+#define portEXIT_CRITICAL()                                         \
+    do {                                                            \
+        uint8_t ucProfileSREG;                                      \
+        __asm__ __volatile__ (                                      \
+            "pop %0"                          "\n\t"                \
+            : "=r" ( ucProfileSREG ) :: "memory"                    \
+            );                                                      \
+        if( ( ucProfileSREG & _BV( SREG_I ) ) != 0 )                \
+        {                                                           \
+            vCriticalProfileExit();                                 \
+        }                                                           \
+        __asm__ __volatile__ (                                      \
+            "out __SREG__, %0"                "\n\t"                \
+            :: "r" ( ucProfileSREG ) : "memory"                     \
+            );                                                      \
+    } while( 0 )
+
+#endif /* if ( portUSE_CRITICAL_PROFILER == 0 ) */
+
 
 #define portDISABLE_INTERRUPTS()    __asm__ __volatile__ ( "cli" ::: "memory" )
 #define portENABLE_INTERRUPTS()     __asm__ __volatile__ ( "sei" ::: "memory" )
@@ -101,7 +142,11 @@ typedef uint8_t        UBaseType_t;
 
 /* Architecture specifics. */
 
-#if( portUSE_TIMER5 == 0 )
+#if( ( portUSE_TIMER1 + portUSE_TIMER5 + portUSE_TIMER2_ASYNC ) > 1 )
+    #error "Only one of portUSE_TIMER1, portUSE_TIMER5 and portUSE_TIMER2_ASYNC can be used for the scheduler."
+#endif
+
+#if( portUSE_TIMER1 == 0 ) && ( portUSE_TIMER5 == 0 ) && ( portUSE_TIMER2_ASYNC == 0 )
 
 /* System Tick  - Scheduler timer
  * Prefer to use the enhanced Watchdog Timer, but also Timer0 is ok.
@@ -144,6 +189,72 @@ typedef uint8_t        UBaseType_t;
 
 #define portBYTE_ALIGNMENT        1
 #define portNOP()    __asm__ __volatile__ ( "nop" );
+#define portFORCE_INLINE    inline __attribute__( ( always_inline ) )
+/*-----------------------------------------------------------*/
+
+/* Port optimised task selection. uxTopReadyPriority is used as a bit map of
+ * the ready priorities. AVR has no instruction to find the highest set bit, and
+ * a shift by a variable amount is a loop, so the bit masks and the index of the
+ * highest bit in a nibble are read from two small tables in flash. This makes
+ * the selection take the same time for every priority. */
+#if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+
+    #include <avr/pgmspace.h>
+
+    #if ( configMAX_PRIORITIES > 16 )
+        #error configUSE_PORT_OPTIMISED_TASK_SELECTION can only be set to 1 when configMAX_PRIORITIES is less than or equal to 16.
+    #endif
+
+    #if ( configMAX_PRIORITIES > 8 )
+        #define portTOP_READY_PRIORITY_TYPE    uint16_t
+    #else
+        #define portTOP_READY_PRIORITY_TYPE    uint8_t
+    #endif
+
+    extern const uint8_t ucPortPriorityBitMask[ 8 ] PROGMEM;
+    extern const uint8_t ucPortHighestBitInNibble[ 16 ] PROGMEM;
+
+    static inline __attribute__( ( always_inline ) ) portTOP_READY_PRIORITY_TYPE uxPortPriorityBit( UBaseType_t uxPriority )
+    {
+        portTOP_READY_PRIORITY_TYPE uxBit = pgm_read_byte( &( ucPortPriorityBitMask[ uxPriority & 0x07 ] ) );
+
+        #if ( configMAX_PRIORITIES > 8 )
+            if( ( uxPriority & 0x08 ) != 0 )
+            {
+                uxBit <<= 8;
+            }
+        #endif
+
+        return uxBit;
+    }
+
+    static inline __attribute__( ( always_inline ) ) UBaseType_t uxPortHighestPriority( portTOP_READY_PRIORITY_TYPE uxReadyPriorities )
+    {
+        UBaseType_t uxBase = 0;
+        uint8_t ucBits = ( uint8_t ) uxReadyPriorities;
+
+        #if ( configMAX_PRIORITIES > 8 )
+            if( ( uxReadyPriorities >> 8 ) != 0 )
+            {
+                ucBits = ( uint8_t ) ( uxReadyPriorities >> 8 );
+                uxBase = 8;
+            }
+        #endif
+
+        if( ( ucBits & 0xF0 ) != 0 )
+        {
+            ucBits >>= 4;
+            uxBase += 4;
+        }
+
+        return uxBase + pgm_read_byte( &( ucPortHighestBitInNibble[ ucBits ] ) );
+    }
+
+    #define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities )      ( uxReadyPriorities ) |= uxPortPriorityBit( uxPriority )
+    #define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities )       ( uxReadyPriorities ) &= ( portTOP_READY_PRIORITY_TYPE ) ~uxPortPriorityBit( uxPriority )
+    #define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities )    uxTopPriority = uxPortHighestPriority( uxReadyPriorities )
+
+#endif /* configUSE_PORT_OPTIMISED_TASK_SELECTION */
 /*-----------------------------------------------------------*/
 
 /* Kernel utilities. */
@@ -151,7 +262,239 @@ extern void vPortYield( void )      __attribute__( ( naked ) );
 #define portYIELD()             vPortYield()
 
 extern void vPortYieldFromISR( void )   __attribute__( ( naked ) );
-#define portYIELD_FROM_ISR()    vPortYieldFromISR()
+
+#if ( portUSE_INTERRUPT_STACK == 1 )
+    #define portYIELD_FROM_ISR()                  \
+    do {                                          \
+        if( ucPortInterruptNesting != 0 )         \
+        {                                         \
+            ucPortYieldPending = pdTRUE;          \
+        }                                         \
+        else                                      \
+        {                                         \
+            vPortYieldFromISR();                  \
+        }                                         \
+    } while( 0 )
+#else
+    #define portYIELD_FROM_ISR()    vPortYieldFromISR()
+#endif
+/*-----------------------------------------------------------*/
+
+/* Dedicated interrupt stack.
+ *
+ * When portUSE_INTERRUPT_STACK is 1, the kernel switches to a shared stack of
+ * portINTERRUPT_STACK_SIZE bytes right after the context of a task has been
+ * saved, so xTaskIncrementTick() and vTaskSwitchContext() no longer run on
+ * the task stacks. Application ISRs declared with portINTERRUPT_STACK_ISR()
+ * instead of ISR() run on that stack as well. Only the return address and 4
+ * bytes stay on the interrupted stack. Nested interrupts (ISR_NOBLOCK) keep
+ * using the interrupt stack they interrupted.
+ *
+ * A portYIELD_FROM_ISR() inside such an ISR is held pending until the
+ * outermost one returns to the task stack, because the context of a task must
+ * never be saved on the shared stack.
+ *
+ * Every task stack still needs room for one saved context, and ISRs that are
+ * declared with ISR() (like the ones of the Arduino core) still use the stack
+ * of the interrupted task. */
+#if ( portUSE_INTERRUPT_STACK == 1 )
+
+    #include <avr/interrupt.h>
+
+    #ifndef portINTERRUPT_STACK_SIZE
+        #define portINTERRUPT_STACK_SIZE    128
+    #endif
+
+    extern uint8_t ucPortInterruptStack[ portINTERRUPT_STACK_SIZE ];
+    extern volatile uint8_t ucPortInterruptNesting;
+    extern volatile uint8_t ucPortYieldPending;
+
+    #if defined( __AVR_HAVE_RAMPZ__ )
+        #define portINTERRUPT_STACK_SAVE_RAMPZ       "in     r0, 0x3B                                \n\t" "push   r0                                      \n\t"
+        #define portINTERRUPT_STACK_RESTORE_RAMPZ    "pop    r0                                      \n\t" "out    0x3B, r0                                \n\t"
+    #else
+        #define portINTERRUPT_STACK_SAVE_RAMPZ
+        #define portINTERRUPT_STACK_RESTORE_RAMPZ
+    #endif
+
+/* Load the stack pointer with the top of the interrupt stack. Only used while
+ * the interrupts are disabled and no ISR is running on the interrupt stack. */
+    #define portSWITCH_TO_INTERRUPT_STACK()                                      \
+    __asm__ __volatile__ ( "ldi    r26, lo8(%0)                            \n\t" \
+                           "out    __SP_L__, r26                           \n\t" \
+                           "ldi    r26, hi8(%0)                            \n\t" \
+                           "out    __SP_H__, r26                           \n\t" \
+                           :: "i" ( &( ucPortInterruptStack[ portINTERRUPT_STACK_SIZE - 1 ] ) ) \
+                           : "r26"                                           \
+                           )
+
+/* Save the registers a C function may clobber and switch to the interrupt
+ * stack, unless it is already in use by an interrupted ISR. */
+    #define portENTER_INTERRUPT_STACK()                                    \
+    __asm__ __volatile__ ( "push   r28                                     \n\t" \
+                           "in     r28, __SREG__                           \n\t" \
+                           "push   r28                                     \n\t" \
+                           "push   r29                                     \n\t" \
+                           "push   r30                                     \n\t" \
+                           "in     r28, __SP_L__                           \n\t" \
+                           "in     r29, __SP_H__                           \n\t" \
+                           "lds    r30, ucPortInterruptNesting             \n\t" \
+                           "inc    r30                                     \n\t" \
+                           "sts    ucPortInterruptNesting, r30             \n\t" \
+                           "cpi    r30, 1                                  \n\t" \
+                           "brne   1f                                      \n\t" \
+                           "ldi    r30, lo8(%0)                            \n\t" \
+                           "out    __SP_L__, r30                           \n\t" \
+                           "ldi    r30, hi8(%0)                            \n\t" \
+                           "out    __SP_H__, r30                           \n\t" \
+                           "1:                                             \n\t" \
+                           "push   r28                                     \n\t" \
+                           "push   r29                                     \n\t" \
+                           "push   r0                                      \n\t" \
+                           "push   r1                                      \n\t" \
+                           "clr    r1                                      \n\t" \
+                           portINTERRUPT_STACK_SAVE_RAMPZ                    \
+                           "push   r18                                     \n\t" \
+                           "push   r19                                     \n\t" \
+                           "push   r20                                     \n\t" \
+                           "push   r21                                     \n\t" \
+                           "push   r22                                     \n\t" \
+                           "push   r23                                     \n\t" \
+                           "push   r24                                     \n\t" \
+                           "push   r25                                     \n\t" \
+                           "push   r26                                     \n\t" \
+                           "push   r27                                     \n\t" \
+                           "push   r31                                     \n\t" \
+                           :: "i" ( &( ucPortInterruptStack[ portINTERRUPT_STACK_SIZE - 1 ] ) ) \
+                           )
+
+/* Opposite to portENTER_INTERRUPT_STACK(). The last ISR leaving the interrupt
+ * stack performs a context switch requested by portYIELD_FROM_ISR(). */
+    #define portEXIT_INTERRUPT_STACK()                                       \
+    __asm__ __volatile__ ( "pop    r31                                     \n\t" \
+                           "pop    r27                                     \n\t" \
+                           "pop    r26                                     \n\t" \
+                           "pop    r25                                     \n\t" \
+                           "pop    r24                                     \n\t" \
+                           "pop    r23                                     \n\t" \
+                           "pop    r22                                     \n\t" \
+                           "pop    r21                                     \n\t" \
+                           "pop    r20                                     \n\t" \
+                           "pop    r19                                     \n\t" \
+                           "pop    r18                                     \n\t" \
+                           portINTERRUPT_STACK_RESTORE_RAMPZ                 \
+                           "pop    r1                                      \n\t" \
+                           "pop    r0                                      \n\t" \
+                           "pop    r29                                     \n\t" \
+                           "pop    r28                                     \n\t" \
+                           "out    __SP_L__, r28                           \n\t" \
+                           "out    __SP_H__, r29                           \n\t" \
+                           "lds    r30, ucPortInterruptNesting             \n\t" \
+                           "dec    r30                                     \n\t" \
+                           "sts    ucPortInterruptNesting, r30             \n\t" \
+                           "brne   1f                                      \n\t" \
+                           "lds    r30, ucPortYieldPending                 \n\t" \
+                           "tst    r30                                     \n\t" \
+                           "breq   1f                                      \n\t" \
+                           "clr    r30                                     \n\t" \
+                           "sts    ucPortYieldPending, r30                 \n\t" \
+                           "call   vPortYieldFromISR                       \n\t" \
+                           "cli                                            \n\t" \
+                           "1:                                             \n\t" \
+                           "pop    r30                                     \n\t" \
+                           "pop    r29                                     \n\t" \
+                           "pop    r28                                     \n\t" \
+                           "out    __SREG__, r28                           \n\t" \
+                           "pop    r28                                     \n\t" \
+                           "reti                                           \n\t" \
+                           )
+
+/* Use instead of ISR( vector ) to run the body of an ISR on the interrupt
+ * stack. */
+    #define portINTERRUPT_STACK_ISR( vector )                          \
+    static void vector ## _body( void ) __attribute__( ( noinline, used ) ); \
+    ISR( vector, ISR_NAKED )                                           \
+    {                                                                  \
+        portENTER_INTERRUPT_STACK();                                   \
+        vector ## _body();                                             \
+        portEXIT_INTERRUPT_STACK();                                    \
+    }                                                                  \
+    static void vector ## _body( void )
+
+#endif /* if ( portUSE_INTERRUPT_STACK == 1 ) */
+/*-----------------------------------------------------------*/
+
+/* Size of the heap of heap_4.c in bytes, chosen at boot if portUSE_AUTO_HEAP
+ * is 1. */
+extern size_t xPortGetHeapSize( void );
+
+#if ( portUSE_AUTO_HEAP == 1 )
+    extern uint8_t * pucPortGetHeapStart( void );
+    #define portHEAP_START    pucPortGetHeapStart()
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( portUSE_XMEM == 1 )
+    #if !defined( XMCRA )
+        #error portUSE_XMEM needs a device with an external memory interface
+    #endif
+
+/* The external memory is mapped behind the internal SRAM.  The last byte is
+ * left out, so the end of the region still fits in a pointer. */
+    #define portHEAP_EXTERNAL_START    ( ( uint8_t * ) ( RAMEND + 1 ) )
+
+    #ifndef portXMEM_SIZE
+        #define portXMEM_SIZE          ( ( size_t ) ( 0xFFFFU - RAMEND - 1U ) )
+    #endif
+
+    #ifndef portHEAP_REGIONS
+        #define portHEAP_REGIONS       { { portHEAP_EXTERNAL_START, portXMEM_SIZE }, { NULL, 0 } }
+    #endif
+#endif
+/*-----------------------------------------------------------*/
+
+/* The run time counter is kept for the run time statistics, for the latency
+ * histograms and for the critical section profiler. */
+#if ( configGENERATE_RUN_TIME_STATS == 1 ) || ( configUSE_LATENCY_HISTOGRAMS == 1 ) || ( portUSE_CRITICAL_PROFILER == 1 )
+    #define portUSE_RUN_TIME_COUNTER    1
+#else
+    #define portUSE_RUN_TIME_COUNTER    0
+#endif
+
+#if ( portUSE_RUN_TIME_COUNTER == 1 )
+/* Run time counter, see port.c. */
+    extern uint32_t ulPortGetRunTimeCounterValue( void );
+#endif
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+    #define portGET_RUN_TIME_COUNTER_VALUE()    ulPortGetRunTimeCounterValue()
+#endif
+
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 ) || ( portUSE_CRITICAL_PROFILER == 1 )
+    #define portGET_LATENCY_TIMESTAMP()    ulPortGetRunTimeCounterValue()
+
+/* Length of one count of the run time counter in nanoseconds, in the order
+ * the tick timer is chosen in port.c. */
+    #if defined( portUSE_WDTO )
+        #define portLATENCY_COUNT_NS    ( 1000U )
+    #elif defined( portUSE_TIMER0 )
+        #define portLATENCY_COUNT_NS    ( 1024000000000ULL / configCPU_CLOCK_HZ )
+    #elif ( portUSE_TIMER1 == 1 ) || ( portUSE_TIMER5 == 1 )
+        #define portLATENCY_COUNT_NS    ( 64000000000ULL / configCPU_CLOCK_HZ )
+    #else
+        #define portLATENCY_COUNT_NS    ( 1000U )
+    #endif
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( portRECLAIM_MAIN_STACK == 1 )
+/* Adds the stack of main() to the heap, called by the idle task when it runs
+ * for the first time. */
+    extern void vPortReclaimMainStack( void );
+
+    #define portIDLE_TASK_STARTUP()    vPortReclaimMainStack()
+#endif
 /*-----------------------------------------------------------*/
 
 #if defined( __AVR_3_BYTE_PC__ )
@@ -166,6 +509,39 @@ extern void vPortYieldFromISR( void )   __attribute__( ( naked ) );
 #endif
 
 #define portTASK_FUNCTION( vFunction, pvParameters )              void vFunction( void * pvParameters )
+/*-----------------------------------------------------------*/
+
+/* Macros for tickless idle/low power functionality. */
+#if( configUSE_TICKLESS_IDLE == 1 )
+
+    #if !defined( portUSE_WDTO ) && ( portUSE_TIMER2_ASYNC == 0 )
+        #error "Tickless idle needs the Watchdog Timer or the asynchronous Timer2 to generate the system ticks."
+    #endif
+
+    #ifndef portSUPPRESS_TICKS_AND_SLEEP
+        extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+        #define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime )    vPortSuppressTicksAndSleep( xExpectedIdleTime )
+    #endif
+
+    #ifndef configPRE_PWR_DOWN_PROCESSING
+        #define configPRE_PWR_DOWN_PROCESSING()
+    #endif
+
+    #ifndef configPOST_PWR_DOWN_PROCESSING
+        #define configPOST_PWR_DOWN_PROCESSING()
+    #endif
+
+#endif
+
+#define portSET_MODE_AND_SLEEP( mode ) \
+    {                                  \
+        set_sleep_mode( mode );        \
+        sleep_enable();                \
+        portENABLE_INTERRUPTS();       \
+        sleep_cpu();                   \
+        portDISABLE_INTERRUPTS();      \
+        sleep_disable();               \
+    }
 
 /* *INDENT-OFF* */
 #ifdef __cplusplus
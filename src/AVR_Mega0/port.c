@@ -52,6 +52,129 @@ extern volatile RTOS_TCB_t * volatile pxCurrentTCB;
 
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+
+/* Lookup tables for portRECORD_READY_PRIORITY(), portRESET_READY_PRIORITY()
+ * and portGET_HIGHEST_PRIORITY(), see portmacro.h. */
+    const uint8_t ucPortPriorityBitMask[ 8 ] PROGMEM =
+    {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+    };
+
+    const uint8_t ucPortHighestBitInNibble[ 16 ] PROGMEM =
+    {
+        0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3
+    };
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_RUN_TIME_COUNTER == 1 ) && defined( TICK_TMR_READ )
+
+/* One count of the run time counter is 2^portRUN_TIME_SHIFT CPU cycles (4 us
+ * at 16 MHz), so the 32 bit counter wraps after 4.7 hours. */
+    #define portRUN_TIME_SHIFT              ( 6 )
+    #define portRUN_TIME_COUNTS_PER_TICK    ( ( ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) + 1 ) >> portRUN_TIME_SHIFT )
+
+/* Counts of all the completed tick periods. The run time counter adds the
+ * count of the tick timer in the current period. */
+    static volatile uint32_t ulRunTimeBase = 0;
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( configUSE_LATENCY_HISTOGRAMS == 1 )
+
+/* Start of the tick interrupt for the eLatencyTickISR histogram, static as
+ * vPortYieldFromTick() is naked and has no stack frame for locals. */
+    static uint32_t ulLatencyTickStart;
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_PC_PROFILER == 1 )
+
+/* Size of the frame of portSAVE_CONTEXT(), and of a return address on the
+ * stack. */
+    #if defined( __AVR_HAVE_RAMPZ__ )
+        #define portCONTEXT_FRAME_SIZE      ( 34U )
+    #else
+        #define portCONTEXT_FRAME_SIZE      ( 33U )
+    #endif
+
+    #if defined( __AVR_3_BYTE_PC__ )
+        #define portRETURN_ADDRESS_SIZE     ( 3U )
+    #else
+        #define portRETURN_ADDRESS_SIZE     ( 2U )
+    #endif
+
+/*
+ * Samples the code interrupted by the tick for the PC profiler. Above the
+ * frame saved by vPortYieldFromTick() is the return address into the tick ISR
+ * and above that the one pushed by the interrupt, high byte first. Not inlined,
+ * as vPortYieldFromTick() is naked and has no stack frame for locals.
+ */
+    static void prvProfileTick( void ) __attribute__( ( noinline ) );
+    static void prvProfileTick( void )
+    {
+        /* The stack pointer saved into the TCB points below the frame. */
+        const uint8_t * pucPC = *( uint8_t * const * ) pxCurrentTCB;
+        uint32_t ulAddress = 0;
+
+        pucPC += 1U + portCONTEXT_FRAME_SIZE + portRETURN_ADDRESS_SIZE;
+
+        for( uint8_t x = 0; x < portRETURN_ADDRESS_SIZE; x++ )
+        {
+            ulAddress = ( ulAddress << 8 ) | pucPC[ x ];
+        }
+
+        /* Word address to byte address. */
+        vPcProfileSample( ulAddress << 1, ( void * ) pxCurrentTCB );
+    }
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_AUTO_HEAP == 1 )
+
+/* Linker symbol of avr-libc marking the end of .bss and .noinit, and the
+ * current end of the memory used by malloc() (NULL until first used). */
+    extern uint8_t __heap_start;
+    extern char * __brkval;
+
+/* Start and size of the heap, fixed by the first call to prvAutoHeapInit(). */
+    static uint8_t * pucAutoHeapStart = NULL;
+    static size_t xAutoHeapSize = 0;
+
+/* Lowest address the stack of main() may use before the scheduler starts. */
+    #define portMAIN_STACK_END    ( ( uint8_t * ) RAMEND + 1 - portMAIN_STACK_MARGIN )
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portRECLAIM_MAIN_STACK == 1 )
+
+/* Lowest address of the main() stack still in use when the first task was
+ * started. The memory from here up to RAMEND is dead once the scheduler runs. */
+    static uint8_t * pucMainStackLow = NULL;
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( portUSE_INTERRUPT_STACK == 1 )
+
+/* Stack shared by the kernel and by the ISRs declared with
+ * portINTERRUPT_STACK_ISR(), see portmacro.h. */
+    uint8_t ucPortInterruptStack[ portINTERRUPT_STACK_SIZE ];
+
+/* Number of portINTERRUPT_STACK_ISR() ISRs running, and whether one of them
+ * requested a context switch. */
+    volatile uint8_t ucPortInterruptNesting = 0;
+    volatile uint8_t ucPortYieldPending = pdFALSE;
+
+#endif
+/*-----------------------------------------------------------*/
+
 /*
  * Perform hardware setup to enable ticks from timer.
  */
@@ -126,9 +249,29 @@ StackType_t * pxPortInitialiseStack( StackType_t * pxTopOfStack,
 
 BaseType_t xPortStartScheduler( void )
 {
+#if (portZERO_LATENCY_VECTOR_NUM != 0)
+    /* Raise the zero latency interrupt to level 1, see portmacro.h. */
+    CPUINT.LVL1VEC = portZERO_LATENCY_VECTOR_NUM;
+#endif
+
     /* Setup the hardware to generate the tick. */
     prvSetupTimerInterrupt();
 
+    #if( portRECLAIM_MAIN_STACK == 1 )
+    {
+        /* SP points to the next free byte, everything above it belongs to the
+         * frames of xPortStartScheduler(), vTaskStartScheduler(), setup() and
+         * main(), which are never returned to. */
+        pucMainStackLow = ( uint8_t * ) SP + 1;
+
+        /* Keep malloc() of avr-libc below the reclaimed region. */
+        if( ( __malloc_heap_end == NULL ) || ( __malloc_heap_end > ( char * ) pucMainStackLow ) )
+        {
+            __malloc_heap_end = ( char * ) pucMainStackLow;
+        }
+    }
+    #endif
+
     /* Restore the context of the first task that is going to run. */
     portRESTORE_CONTEXT();
 
@@ -141,6 +284,142 @@ BaseType_t xPortStartScheduler( void )
 }
 /*-----------------------------------------------------------*/
 
+#if( portRECLAIM_MAIN_STACK == 1 )
+
+    void vPortReclaimMainStack( void )
+    {
+        uint8_t * pucRegion;
+
+        taskENTER_CRITICAL();
+        {
+            pucRegion = pucMainStackLow;
+            pucMainStackLow = NULL;
+        }
+        taskEXIT_CRITICAL();
+
+        #if( portUSE_AUTO_HEAP == 1 )
+        {
+            /* The heap already takes the memory up to the margin left for the
+             * stack of main(), so only the margin itself is added. */
+            configASSERT( ( pucRegion == NULL ) || ( pucRegion >= portMAIN_STACK_END ) );
+
+            if( pucRegion != NULL )
+            {
+                pucRegion = portMAIN_STACK_END;
+            }
+        }
+        #endif
+
+        if( pucRegion != NULL )
+        {
+            vPortAddHeapRegion( pucRegion, ( size_t ) ( ( uint8_t * ) RAMEND + 1 - pucRegion ) );
+        }
+    }
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_AUTO_HEAP == 1 )
+
+/*
+ * Place the heap between the memory of malloc() and the stack of main(). This
+ * happens on the first call to pvPortMalloc(), usually by xTaskCreate() from
+ * setup().
+ */
+    static void prvAutoHeapInit( void )
+    {
+        uint8_t * pucStart;
+
+        if( pucAutoHeapStart == NULL )
+        {
+            pucStart = &__heap_start + portMALLOC_HEAP_RESERVE;
+
+            if( ( uint8_t * ) __brkval > pucStart )
+            {
+                pucStart = ( uint8_t * ) __brkval;
+            }
+
+            /* The stack of main() must not have grown into the heap already. */
+            configASSERT( portMAIN_STACK_END > pucStart );
+            configASSERT( ( uint8_t * ) SP >= portMAIN_STACK_END );
+
+            /* Keep malloc() of avr-libc below the heap. */
+            __malloc_heap_end = ( char * ) pucStart;
+
+            xAutoHeapSize = ( size_t ) ( portMAIN_STACK_END - pucStart );
+            pucAutoHeapStart = pucStart;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    uint8_t * pucPortGetHeapStart( void )
+    {
+        prvAutoHeapInit();
+
+        return pucAutoHeapStart;
+    }
+/*-----------------------------------------------------------*/
+
+    size_t xPortGetHeapSize( void )
+    {
+        prvAutoHeapInit();
+
+        return xAutoHeapSize;
+    }
+
+#else /* if ( portUSE_AUTO_HEAP == 1 ) */
+
+    size_t xPortGetHeapSize( void )
+    {
+        return configTOTAL_HEAP_SIZE;
+    }
+
+#endif /* if ( portUSE_AUTO_HEAP == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if( portUSE_RUN_TIME_COUNTER == 1 )
+
+/*
+ * Run time counter for the run time statistics, read on every context switch,
+ * and the timestamp of the latency histograms.
+ *
+ * With a TCB generating the tick, its counter is extended to 32 bits by the
+ * tick count kept in ulRunTimeBase, so no further timer is needed. The RTC
+ * counts too slow, so micros() of the Arduino core is used instead, with one
+ * count being 1 us.
+ */
+uint32_t ulPortGetRunTimeCounterValue( void )
+{
+#if defined( TICK_TMR_READ )
+    uint32_t ulBase;
+    uint16_t usCount;
+    uint8_t ucSREG;
+
+    ucSREG = SREG;
+    portDISABLE_INTERRUPTS();
+    ulBase = ulRunTimeBase;
+    usCount = TICK_TMR_READ();
+
+    /* The counter has already wrapped, but the tick interrupt has not yet
+     * added the period. */
+    if( ( INT_FLAGS & INT_MASK ) != 0 )
+    {
+        usCount = TICK_TMR_READ();
+        ulBase += portRUN_TIME_COUNTS_PER_TICK;
+    }
+    SREG = ucSREG;
+
+    return ulBase + ( usCount >> portRUN_TIME_SHIFT );
+#else
+    extern unsigned long micros( void );
+
+    return micros();
+#endif
+}
+
+#endif
+/*-----------------------------------------------------------*/
+
 void vPortEndScheduler( void )
 {
     /* vPortEndScheduler is not implemented in this port. */
@@ -155,6 +434,11 @@ void vPortYield( void ) __attribute__( ( naked ) );
 void vPortYield( void )
 {
     portSAVE_CONTEXT();
+
+#if (portUSE_INTERRUPT_STACK == 1)
+    portSWITCH_TO_INTERRUPT_STACK();
+#endif
+
     vTaskSwitchContext();
     portRESTORE_CONTEXT();
     asm volatile ( "ret" );
@@ -169,6 +453,13 @@ void vPortYieldFromISR( void ) __attribute__( ( naked ) );
 void vPortYieldFromISR( void )
 {
     portSAVE_CONTEXT();
+
+#if (portUSE_INTERRUPT_STACK == 1)
+    portSWITCH_TO_INTERRUPT_STACK();
+#endif
+
+    portUNMASK_ZERO_LATENCY_FROM_ISR();
+
     vTaskSwitchContext();
     portRESTORE_CONTEXT();
     asm volatile ( "reti" );
@@ -186,10 +477,50 @@ void vPortYieldFromTick( void )
 {
     portSAVE_CONTEXT();
 
+    portUNMASK_ZERO_LATENCY_FROM_ISR();
+
+#if (portUSE_RUN_TIME_COUNTER == 1) && defined(TICK_TMR_READ)
+    ulRunTimeBase += portRUN_TIME_COUNTS_PER_TICK;
+#endif
+
+#if (configUSE_LATENCY_HISTOGRAMS == 1)
+    ulLatencyTickStart = portGET_LATENCY_TIMESTAMP();
+#endif
+
+#if (portUSE_PC_PROFILER == 1)
+    prvProfileTick();
+#endif
+
+#if (portUSE_INTERRUPT_STACK == 1)
+    if( ucPortInterruptNesting != 0 )
+    {
+        /* The tick preempted an ISR that runs on the interrupt stack, so the
+         * context just saved is not the one of a task. Leave the switch to
+         * the ISR when it returns to the task stack. */
+        if( xTaskIncrementTick() != pdFALSE )
+        {
+            ucPortYieldPending = pdTRUE;
+        }
+    }
+    else
+    {
+        portSWITCH_TO_INTERRUPT_STACK();
+
+        if( xTaskIncrementTick() != pdFALSE )
+        {
+            vTaskSwitchContext();
+        }
+    }
+#else
     if( xTaskIncrementTick() != pdFALSE )
     {
         vTaskSwitchContext();
     }
+#endif
+
+#if (configUSE_LATENCY_HISTOGRAMS == 1)
+    vTaskRecordLatency( eLatencyTickISR, ulLatencyTickStart );
+#endif
 
     portRESTORE_CONTEXT();
 
@@ -237,71 +568,73 @@ static void prvSetupTimerInterrupt( void )
     {
         /* Clear tick interrupt flag. */
         INT_FLAGS = INT_MASK;
+
+#if (portUSE_RUN_TIME_COUNTER == 1) && defined(TICK_TMR_READ)
+        ulRunTimeBase += portRUN_TIME_COUNTS_PER_TICK;
+#endif
+
+#if (configUSE_LATENCY_HISTOGRAMS == 1)
+        ulLatencyTickStart = portGET_LATENCY_TIMESTAMP();
+#endif
+
         xTaskIncrementTick();
+
+#if (configUSE_LATENCY_HISTOGRAMS == 1)
+        vTaskRecordLatency( eLatencyTickISR, ulLatencyTickStart );
+#endif
     }
 #endif /* if configUSE_PREEMPTION == 1 */
 
 #if (configUSE_TICKLESS_IDLE == 1)
 
-volatile uint32_t RTC_OVF_Count = 0;
+#include "porttickless.h"
+
+/* Set by the compare interrupt, so a wake-up by the RTC can be told apart from
+ * a wake-up by any other interrupt. */
+static volatile uint8_t ucRTCWakeup = 0;
+
+/* Number of times the MCU left the sleep mode, see ulPortGetSleepWakeups(). */
+static volatile uint32_t ulSleepWakeups = 0;
 
 ISR(RTC_CNT_vect)
 {
-    if (RTC.INTFLAGS & RTC_OVF_bm )
-    {
-        RTC_OVF_Count += 0x00010000;
-        RTC.INTFLAGS = (RTC_OVF_bm);
-    }  
-    
-    if (RTC.INTFLAGS & RTC_CMP_bm )
-    {
-        RTC.INTFLAGS = (RTC_CMP_bm);
-        //Disable compare interrupt
-        RTC.INTCTRL &= (0xFF ^ RTC_CMP_bm);
-    }    
-
+    RTC.INTFLAGS = (RTC_OVF_bm | RTC_CMP_bm);
+    ucRTCWakeup = 1;
 }
 
-static uint32_t ulGetExternalTime(void)
+static uint16_t usReadRTC(void)
 {
-    uint32_t time_rtc;
-
     while (RTC.STATUS & RTC_CNTBUSY_bm)
     {
         ;
     }
-    time_rtc = RTC.CNT;
-    time_rtc += RTC_OVF_Count;
-    return time_rtc;
+    return RTC.CNT;
 }
 
-static void vSetWakeTimeInterrupt(uint16_t xExpectedIdleTime)
+static void vSetRTCCompare(uint16_t usCompare)
 {
-    uint32_t rtc_cnt_time;
-
-    /* compute the required  */
-    rtc_cnt_time = RTC_TICKS_TO_COUNTS(xExpectedIdleTime);
-    rtc_cnt_time += ulGetExternalTime();
-
     while (RTC.STATUS & RTC_CMPBUSY_bm)
     {
         ;
     }
-    RTC.CMP = (rtc_cnt_time & 0xFFFF);
+    RTC.CMP = usCompare;
+}
+
+uint32_t ulPortGetSleepWakeups(void)
+{
+    uint32_t ulWakeups;
 
-    //Enable compare interrupt
-    RTC.INTCTRL |= RTC_CMP_bm;
+    portENTER_CRITICAL();
+    ulWakeups = ulSleepWakeups;
+    portEXIT_CRITICAL();
+
+    return ulWakeups;
 }
 
 /* Define the function that is called by portSUPPRESS_TICKS_AND_SLEEP(). */
 __attribute__((weak)) void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
 {
-     eSleepModeStatus eSleepStatus;
-     uint32_t ulLowPowerTimeBeforeSleep, ulLowPowerTimeAfterSleep;
-    
-    /* Read the current time from a time source that will remain operational
-    while the microcontroller is in a low power state. */
-    ulLowPowerTimeBeforeSleep = ulGetExternalTime();
+    eSleepModeStatus eSleepStatus;
 
     /* Stop the timer that is generating the tick interrupt. */
     TICK_TMR_STOP();
@@ -338,6 +671,7 @@ __attribute__((weak)) void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTi
              * to keep better track of the calender time then the PIT peripheral can be
              * used to make rough adjustments. */
             portSET_MODE_AND_SLEEP(SLEEP_MODE_PWR_DOWN);
+            ulSleepWakeups++;
 
             /* A user definable macro that allows application code to be inserted
              * here.  Such application code can be used to reverse any actions taken
@@ -346,29 +680,66 @@ __attribute__((weak)) void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTi
         }
         else
         {
+            uint8_t ucShift;
+            uint16_t usWindowStart = 0, usWindow = 0;
+            uint32_t ulTargetCounts, ulElapsedCounts = 0;
+            TickType_t xCompleteTicks;
+
             /* Configure an interrupt to bring the microcontroller out of its low
              * power state at the time the kernel next needs to execute.  The
              * interrupt must be generated from a source that remains operational
-             * when the microcontroller is in a low power state. */
-            vSetWakeTimeInterrupt(xExpectedIdleTime);
+             * when the microcontroller is in a low power state.  The prescaler
+             * trades resolution for the length of one compare window. */
+            ucShift = ucSelectPrescaler(xExpectedIdleTime);
+            ulTargetCounts = ulTicksToCounts(xExpectedIdleTime, ucShift);
 
             /* Allow the application to define some pre-sleep processing.  This is
              * the standard configPRE_SLEEP_PROCESSING() macro as described on the
              * FreeRTOS.org website. */
             configPRE_SLEEP_PROCESSING(xExpectedIdleTime);
 
-            /* Enter the low power state. */
-            portSET_MODE_AND_SLEEP(SLEEP_MODE_STANDBY);
-
-            /* Determine how long the microcontroller was actually in a low power
-             * state for, which will be less than xExpectedIdleTime if the
-             * microcontroller was brought out of low power mode by an interrupt
-             * other than that configured by the vSetWakeTimeInterrupt() call.
-             * Note that the scheduler is suspended before
-             * portSUPPRESS_TICKS_AND_SLEEP() is called, and resumed when
-             * portSUPPRESS_TICKS_AND_SLEEP() returns.  Therefore no other tasks will
-             * execute until this function completes. */
-            ulLowPowerTimeAfterSleep = ulGetExternalTime();
+            if (ulTargetCounts != 0)
+            {
+                usWindow = usNextWindow(ulTargetCounts, 0);
+                vSetRTCCompare(usWindow);
+                ucRTCWakeup = 0;
+                RTC_START(ucShift);
+
+                for (;;)
+                {
+                    /* Enter the low power state. */
+                    portSET_MODE_AND_SLEEP(SLEEP_MODE_STANDBY);
+                    ulSleepWakeups++;
+
+                    if (ucRTCWakeup != 0)
+                    {
+                        /* A compare window has ended.  Chain the next one
+                         * without returning to the scheduler, unless the
+                         * expected idle time is over. */
+                        ucRTCWakeup = 0;
+                        ulElapsedCounts += usWindow;
+                        usWindowStart += usWindow;
+
+                        if (ulElapsedCounts >= ulTargetCounts)
+                        {
+                            break;
+                        }
+
+                        usWindow = usNextWindow(ulTargetCounts, ulElapsedCounts);
+                        vSetRTCCompare(usWindowStart + usWindow);
+                    }
+
+                    /* Another interrupt only ends the sleep if it made a task
+                     * ready to run, or requested a context switch. */
+                    if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+                    {
+                        ulElapsedCounts += (uint16_t)(usReadRTC() - usWindowStart);
+                        break;
+                    }
+                }
+
+                RTC_STOP();
+            }
 
             /* Allow the application to define some post sleep processing.  This is
              * the standard configPOST_SLEEP_PROCESSING() macro, as described on the
@@ -378,10 +749,27 @@ __attribute__((weak)) void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTi
             configPOST_SLEEP_PROCESSING(xExpectedIdleTime);
 
             /* Correct the kernels tick count to account for the time the
-            * microcontroller spent in its low power state. */
-            vTaskStepTick(RTC_COUNTS_TO_TICKS(ulLowPowerTimeAfterSleep - ulLowPowerTimeBeforeSleep));
-            //  vTaskStepTick(xExpectedIdleTime);
-
+             * microcontroller spent in its low power state.  Note that the
+             * scheduler is suspended before portSUPPRESS_TICKS_AND_SLEEP() is
+             * called, and resumed when portSUPPRESS_TICKS_AND_SLEEP() returns.
+             * Therefore no other tasks will execute until this function
+             * completes. */
+            if (ulElapsedCounts >= ulTargetCounts)
+            {
+                /* The target is rounded down to whole counts, so the sleep
+                 * lasted the expected idle time less than one count. */
+                xCompleteTicks = xExpectedIdleTime;
+            }
+            else
+            {
+                xCompleteTicks = xCountsToTicks(ulElapsedCounts, ucShift);
+            }
+
+            vTaskStepTick(xCompleteTicks);
+
+#if (portUSE_RUN_TIME_COUNTER == 1) && defined(TICK_TMR_READ)
+            ulRunTimeBase += (uint32_t)xCompleteTicks * portRUN_TIME_COUNTS_PER_TICK;
+#endif
         }
 
         /* Exit the critical section - it might be possible to do this immediately
@@ -161,22 +161,37 @@
 
 #if ( configUSE_TICKLESS_IDLE == 1 )
 
-#define LOW_POWER_CLOCK     (32768UL)
-
-#define RTC_TICK_PERIOD_MS            ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
-#define RTC_TICKS_TO_COUNTS(tick_cnt) (uint32_t)(((float)(tick_cnt * LOW_POWER_CLOCK)/configTICK_RATE_HZ) - 0.5)
-#define RTC_COUNTS_TO_TICKS(counts)   (uint32_t)((float)((counts * 1.0) * configTICK_RATE_HZ)/LOW_POWER_CLOCK  )
+#if ( configUSE_TIMER_INSTANCE == 4 )
+    #error The RTC can not generate the tick and time the tickless idle, use a TCB.
+#endif
 
+/* The RTC counts the internal 32.768 kHz oscillator divided by 2^shift. Its
+ * prescaler is selected for every sleep, see vPortSuppressTicksAndSleep(). */
+#define RTC_CLOCK_SHIFT               ( 15 )
 
 #define RTC_INIT()                                                          \
 {                                                                           \
 	while( RTC.STATUS > 0 ) {; }                                            \
+	RTC.CTRLA = 0;                                                          \
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc;                                      \
 	RTC.PER = 0xFFFF;                                                       \
-	RTC.CMP = 0x3FFF;                                                       \
+	RTC.INTCTRL = 0;                                                        \
+}
+
+#define RTC_START( shift )                                                  \
+{                                                                           \
+	while( RTC.STATUS > 0 ) {; }                                            \
 	RTC.CNT = 0;                                                            \
 	RTC.INTFLAGS = RTC_OVF_bm | RTC_CMP_bm;                                 \
-	RTC.CTRLA = RTC_RUNSTDBY_bm | RTC_PRESCALER_DIV1_gc | RTC_RTCEN_bm ;    \
-	RTC.INTCTRL = RTC_OVF_bm | RTC_CMP_bm;                                  \
+	RTC.INTCTRL = RTC_CMP_bm;                                               \
+	RTC.CTRLA = RTC_RUNSTDBY_bm | ( ( shift ) << RTC_PRESCALER_gp ) | RTC_RTCEN_bm; \
+}
+
+#define RTC_STOP()                                                          \
+{                                                                           \
+	while( RTC.STATUS > 0 ) {; }                                            \
+	RTC.CTRLA = 0;                                                          \
+	RTC.INTCTRL = 0;                                                        \
 }
 
 #endif
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        porttickless.h
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Tick and RTC count arithmetic of the tickless idle of the
+ *              megaAVR 0-series port.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef PORTTICKLESS_H
+#define PORTTICKLESS_H
+
+/* The arithmetic of the tickless idle of this port, which times the sleep with
+ * the RTC counting the 32.768 kHz oscillator divided by 2^ucShift. It uses no
+ * hardware, so extras/tickless checks it on the host. The includer defines
+ * TickType_t, configTICK_RATE_HZ and RTC_CLOCK_SHIFT. */
+
+/*-----------------------------------------------------------*/
+
+/* Convert between ticks and RTC counts at a prescaler of 2^ucShift, without
+ * floating point and without overflow for any 32 bit tick count. */
+static inline uint32_t ulTicksToCounts(TickType_t xTicks, uint8_t ucShift)
+{
+    uint8_t ucScale = RTC_CLOCK_SHIFT - ucShift;
+
+    return ((uint32_t)(xTicks / configTICK_RATE_HZ) << ucScale) +
+           (((uint32_t)(xTicks % configTICK_RATE_HZ) << ucScale) / configTICK_RATE_HZ);
+}
+
+static inline TickType_t xCountsToTicks(uint32_t ulCounts, uint8_t ucShift)
+{
+    uint8_t ucScale = RTC_CLOCK_SHIFT - ucShift;
+
+    return (TickType_t)(((ulCounts >> ucScale) * configTICK_RATE_HZ) +
+                        (((ulCounts & ((1UL << ucScale) - 1)) * configTICK_RATE_HZ) >> ucScale));
+}
+
+/* Select the smallest prescaler that fits the expected idle time into one
+ * 16 bit compare window, which gives the best resolution. Longer idle times
+ * use the largest prescaler (1 count per second, about 18 hours per window)
+ * and are split into several windows. */
+static inline uint8_t ucSelectPrescaler(TickType_t xExpectedIdleTime)
+{
+    uint8_t ucShift = 0;
+
+    /* The first test keeps ulTicksToCounts() from overflowing. */
+    while ((ucShift < RTC_CLOCK_SHIFT) &&
+           ((((xExpectedIdleTime / configTICK_RATE_HZ) >> (ucShift + 1)) != 0) ||
+            (ulTicksToCounts(xExpectedIdleTime, ucShift) > 0xFFFF)))
+    {
+        ucShift++;
+    }
+
+    return ucShift;
+}
+
+/* Length of the next compare window, the counts still to sleep but at most
+ * one wrap of the RTC. */
+static inline uint16_t usNextWindow(uint32_t ulTargetCounts, uint32_t ulElapsedCounts)
+{
+    return ((ulTargetCounts - ulElapsedCounts) > 0xFFFF) ? 0xFFFF : (uint16_t)(ulTargetCounts - ulElapsedCounts);
+}
+
+/*-----------------------------------------------------------*/
+
+#endif /* PORTTICKLESS_H */
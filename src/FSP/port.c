@@ -904,6 +904,23 @@ void SysTick_Handler (void)
      * critical sections in FromISR functions (reference xTaskRemoveFromEventList,
      * for example). */
     uint32_t ulPreviousMask = portSET_INTERRUPT_MASK_FROM_ISR();
+#if (configUSE_LATENCY_HISTOGRAMS == 1)
+    uint32_t ulTickStart = portGET_LATENCY_TIMESTAMP();
+#endif
+#if (portUSE_PC_PROFILER == 1)
+
+    /* The PC is the seventh word of the exception frame, which is on the
+     * process stack if the tick interrupted a task. Returning to base level
+     * means no other interrupt was interrupted. */
+    if (SCB->ICSR & SCB_ICSR_RETTOBASE_Msk)
+    {
+        vPcProfileSample(((uint32_t *) __get_PSP())[6], xTaskGetCurrentTaskHandle());
+    }
+    else
+    {
+        vPcProfileSample(0U, xTaskGetCurrentTaskHandle());
+    }
+#endif
     if (xTaskIncrementTick() != pdFALSE)
     {
         /* A context switch is required.  Context switching is performed in
@@ -911,6 +928,10 @@ void SysTick_Handler (void)
         SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
     }
 
+#if (configUSE_LATENCY_HISTOGRAMS == 1)
+    vTaskRecordLatency(eLatencyTickISR, ulTickStart);
+#endif
+
     portCLEAR_INTERRUPT_MASK_FROM_ISR(ulPreviousMask);
 }
 
@@ -1229,6 +1250,15 @@ BaseType_t xPortStartScheduler (void)
     /* Make PendSV the lowest priority interrupt. */
     NVIC_SetPriority(PendSV_IRQn, UINT8_MAX);
 
+#if (configUSE_LATENCY_HISTOGRAMS == 1) || (portUSE_CRITICAL_PROFILER == 1)
+
+    /* Start the cycle counter used as the timestamp of the latency histograms
+     * and of the critical section profiler. */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT       = 0U;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
     /* Start the timer that generates the tick ISR.  Interrupts are disabled
      * here already. */
     vPortSetupTimerInterrupt();
@@ -1286,6 +1316,15 @@ void vPortEnterCritical (void)
     {
         g_mask_level_before_disable = old_mask_level;
         configASSERT((SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) == 0);
+
+#if (portUSE_CRITICAL_PROFILER == 1)
+
+        /* Timed for the caller of taskENTER_CRITICAL(), see critical_profiler.h. */
+        if (old_mask_level == 0U)
+        {
+            vCriticalProfileBegin(profKIND_CRITICAL, (uintptr_t) __builtin_return_address(0));
+        }
+#endif
     }
 }
 
@@ -1298,6 +1337,9 @@ void vPortExitCritical (void)
     uxCriticalNesting--;
     if (uxCriticalNesting == 0)
     {
+#if (portUSE_CRITICAL_PROFILER == 1)
+        vCriticalProfileEnd(profKIND_CRITICAL);
+#endif
         portCLEAR_INTERRUPT_MASK(g_mask_level_before_disable);
     }
 }
@@ -200,6 +200,15 @@ void       vResetPrivilege(void) RM_FREERTOS_PORT_NAKED_FUNCTION;
 
 /*-----------------------------------------------------------*/
 
+/* Timestamp of the latency histograms, the cycle counter of the DWT enabled
+ * in xPortStartScheduler(). */
+ #if (configUSE_LATENCY_HISTOGRAMS == 1) || (portUSE_CRITICAL_PROFILER == 1)
+  #define portGET_LATENCY_TIMESTAMP()    (DWT->CYCCNT)
+  #define portLATENCY_COUNT_NS           (1000000000UL / configCPU_CLOCK_HZ)
+ #endif
+
+/*-----------------------------------------------------------*/
+
 /* Tickless idle/low power functionality. */
  #ifndef portSUPPRESS_TICKS_AND_SLEEP
 extern void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime);
@@ -2679,6 +2679,58 @@
     #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
 #endif
 
+#ifndef configUSE_LATENCY_HISTOGRAMS
+    #define configUSE_LATENCY_HISTOGRAMS    0
+#endif
+
+#ifndef configLATENCY_HISTOGRAM_BUCKETS
+    #define configLATENCY_HISTOGRAM_BUCKETS    16
+#endif
+
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+
+    #ifndef portGET_LATENCY_TIMESTAMP
+        #error If configUSE_LATENCY_HISTOGRAMS is set to 1 then portGET_LATENCY_TIMESTAMP() must be defined to return a free running 32 bit count, and portLATENCY_COUNT_NS the length of one count in nanoseconds.
+    #endif
+
+    #if ( configNUMBER_OF_CORES > 1 )
+        #error configUSE_LATENCY_HISTOGRAMS is only supported on single core ports.
+    #endif
+
+    #if ( configLATENCY_HISTOGRAM_BUCKETS < 2 ) || ( configLATENCY_HISTOGRAM_BUCKETS > 32 )
+        #error configLATENCY_HISTOGRAM_BUCKETS must be between 2 and 32.
+    #endif
+
+#endif /* configUSE_LATENCY_HISTOGRAMS */
+
+#ifndef configUSE_TASK_SWITCH_STATS
+    #define configUSE_TASK_SWITCH_STATS    0
+#endif
+
+#if ( configUSE_TASK_SWITCH_STATS == 1 ) && ( configNUMBER_OF_CORES > 1 )
+    #error configUSE_TASK_SWITCH_STATS is only supported on single core ports.
+#endif
+
+#ifndef configUSE_IDLE_STACK_SCAN
+    #define configUSE_IDLE_STACK_SCAN    0
+#endif
+
+#ifndef configIDLE_STACK_SCAN_BYTES
+    #define configIDLE_STACK_SCAN_BYTES    32
+#endif
+
+#ifndef configSTACK_HEADROOM_THRESHOLD
+    #define configSTACK_HEADROOM_THRESHOLD    0
+#endif
+
+#if ( configUSE_IDLE_STACK_SCAN == 1 ) && ( configNUMBER_OF_CORES > 1 )
+    #error configUSE_IDLE_STACK_SCAN is only supported on single core ports.
+#endif
+
+#if ( configUSE_IDLE_STACK_SCAN == 1 ) && ( configIDLE_STACK_SCAN_BYTES < 1 )
+    #error configIDLE_STACK_SCAN_BYTES must be at least 1.
+#endif
+
 #ifndef portPRIVILEGE_BIT
     #define portPRIVILEGE_BIT    ( ( UBaseType_t ) 0x00 )
 #endif
@@ -2727,6 +2779,10 @@
     #define portALLOCATE_SECURE_CONTEXT( ulSecureStackSize )
 #endif
 
+#ifndef portIDLE_TASK_STARTUP
+    #define portIDLE_TASK_STARTUP()
+#endif
+
 #ifndef portDONT_DISCARD
     #define portDONT_DISCARD
 #endif
@@ -3177,6 +3233,21 @@ typedef struct xSTATIC_TCB
     #if ( configGENERATE_RUN_TIME_STATS == 1 )
         configRUN_TIME_COUNTER_TYPE ulDummy16;
     #endif
+    #if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+        uint32_t ulDummyLatency;
+        uint8_t ucDummyLatency;
+    #endif
+    #if ( configUSE_TASK_SWITCH_STATS == 1 )
+        uint32_t ulDummySwitch[ 6 ];
+        #if ( configGENERATE_RUN_TIME_STATS == 1 )
+            configRUN_TIME_COUNTER_TYPE ulDummyReady[ 2 ];
+        #endif
+        uint8_t ucDummySwitch;
+    #endif
+    #if ( configUSE_IDLE_STACK_SCAN == 1 )
+        void * pvDummyScan;
+        configSTACK_DEPTH_TYPE uxDummyScan;
+    #endif
     #if ( configUSE_C_RUNTIME_TLS_SUPPORT == 1 )
         configTLS_BLOCK_TYPE xDummy17;
     #endif
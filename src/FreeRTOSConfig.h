@@ -51,8 +51,8 @@
 // #define configTICK_RATE_HZ                          100 /* Device specific */
 #define configUSE_PREEMPTION                        1
 #define configUSE_TIME_SLICING                      0
-#define configUSE_PORT_OPTIMISED_TASK_SELECTION     0
-#define configUSE_TICKLESS_IDLE                     0
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION     0 /* AVR: opt-in, up to 16 priorities, see Benchmark_TaskSelection */
+#define configUSE_TICKLESS_IDLE                     0 /* ATmega: needs the Watchdog Timer or asynchronous Timer2 tick */
 #define configMAX_PRIORITIES                        5
 #define configMINIMAL_STACK_SIZE                    128
 #define configMAX_TASK_NAME_LEN                     16
@@ -85,7 +85,7 @@
 #define configSUPPORT_STATIC_ALLOCATION             1
 #define configSUPPORT_DYNAMIC_ALLOCATION            1
 // #define configTOTAL_HEAP_SIZE                       4096 /* Device specific */
-#define configAPPLICATION_ALLOCATED_HEAP            0
+#define configAPPLICATION_ALLOCATED_HEAP            portUSE_AUTO_HEAP
 #define configSTACK_ALLOCATION_FROM_SEPARATE_HEAP   0
 #define configENABLE_HEAP_PROTECTOR                 0
 
@@ -103,9 +103,15 @@
 #define configCHECK_FOR_STACK_OVERFLOW              1 /* Debugging */
 
 /* Run time and task stats gathering related definitions. */
-// #define configGENERATE_RUN_TIME_STATS               0
+#define configGENERATE_RUN_TIME_STATS               0 /* AVR: counter from the tick timer or micros() */
 // #define configUSE_TRACE_FACILITY                    0
 // #define configUSE_STATS_FORMATTING_FUNCTIONS        0
+#define configUSE_LATENCY_HISTOGRAMS                0 /* vTaskGetLatencyHistogram() */
+#define configLATENCY_HISTOGRAM_BUCKETS             16
+#define configUSE_TASK_SWITCH_STATS                 0 /* switch counts in TaskStatus_t */
+#define configUSE_IDLE_STACK_SCAN                   0 /* stack marks kept by the idle task */
+#define configIDLE_STACK_SCAN_BYTES                 32
+#define configSTACK_HEADROOM_THRESHOLD              0 /* vApplicationStackHeadroomHook() */
 
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                       0
@@ -191,9 +197,22 @@
     defined( ARDUINO_AVR_LEONARDO ) || \
     defined( ARDUINO_AVR_PRO )
 
-    /* These devices are using the watchdog timer interrupt to generate the
-    system ticks, which results in a different/lower tick rate. */
-    #define configTICK_RATE_HZ          ( ( TickType_t ) 1000 / portTICK_PERIOD_MS )
+    /* When set to 0, the Watchdog timer interrupt is used to generate the
+     * system ticks, which results in a different/lower tick rate (~16 ms).
+     *
+     * When set to 1, the Timer1 compare match interrupt is used instead and
+     * the tick rate can be set freely (4 Hz up to 1 kHz and more).
+     *
+     * INFO :   Timer0 and millis() are not affected, but the PWM on pin 9/10
+     *          and the Servo library can not be used together with Timer1.
+     */
+    #define portUSE_TIMER1              0
+
+    #if( portUSE_TIMER1 == 1 )
+        #define configTICK_RATE_HZ      ( ( TickType_t ) 1000 )
+    #else
+        #define configTICK_RATE_HZ      ( ( TickType_t ) 1000 / portTICK_PERIOD_MS )
+    #endif
 
 #elif defined( ARDUINO_AVR_MEGA2560 )
 
@@ -206,8 +225,20 @@
      */
     #define portUSE_TIMER5              1
 
+    /* When set to 1 (and portUSE_TIMER5 set to 0), Timer2 clocked by a
+     * 32.768 kHz watch crystal on TOSC1/TOSC2 is used to generate the system
+     * ticks. The tick keeps running in power-save mode, which allows long and
+     * accurate tickless idle periods. The tick rate must divide 256.
+     *
+     * INFO :   The Arduino Mega has no watch crystal fitted by default. PWM on
+     *          pin 9/10 and tone() are not available with this setting.
+     */
+    #define portUSE_TIMER2_ASYNC        0
+
     #if( portUSE_TIMER5 == 1 )
         #define configTICK_RATE_HZ      ( ( TickType_t ) 1000 )
+    #elif( portUSE_TIMER2_ASYNC == 1 )
+        #define configTICK_RATE_HZ      ( ( TickType_t ) 128 )
     #else
         #define configTICK_RATE_HZ      ( ( TickType_t ) 1000 / portTICK_PERIOD_MS )
     #endif
@@ -226,11 +257,153 @@
     #define configUSE_TIMER_INSTANCE    4
     #define configTICK_RATE_HZ          ( ( TickType_t ) 1000 )
 
+    /* Vector number of the interrupt raised to CPUINT level 1, e.g.
+     * TCA0_OVF_vect_num. It is not masked while the kernel runs in the tick
+     * ISR, but it must not call any FreeRTOS API function. 0 for none. */
+    #define portZERO_LATENCY_VECTOR_NUM 0
+
+#elif defined( FREERTOS_HOST_POSIX )
+
+    /* The tick is the SIGALRM of an interval timer. When portHOST_VIRTUAL_CLOCK
+     * is set to 1 (e.g. with -DportHOST_VIRTUAL_CLOCK=1), it is a virtual clock
+     * that only advances while the idle task runs or a task is in delay(). */
+    #define configTICK_RATE_HZ          ( ( TickType_t ) 1000 )
+
 #endif
 /*-----------------------------------------------------------*/
 
+/* AVR ports only. When set to 1, the kernel runs the tick and the context
+ * switches on a dedicated interrupt stack of portINTERRUPT_STACK_SIZE bytes,
+ * and ISRs declared with portINTERRUPT_STACK_ISR() run on it as well. Each
+ * task stack then only has to hold its own frames plus one saved context,
+ * instead of the worst case nesting of the kernel and all the ISRs. */
+#define portUSE_INTERRUPT_STACK             0
+#define portINTERRUPT_STACK_SIZE            128
+/*-----------------------------------------------------------*/
+
+/* AVR ports only. When set to 1, the stack used by main() and setup() up to
+ * vTaskStartScheduler() is added to the heap once the idle task runs for the
+ * first time, as it is never used again. malloc() of avr-libc is limited to the
+ * memory below it. */
+#define portRECLAIM_MAIN_STACK              0
+/*-----------------------------------------------------------*/
+
+/* AVR ports only. When set to 1, the heap is not a fixed array of
+ * configTOTAL_HEAP_SIZE bytes, but is sized at boot to take all the memory from
+ * the end of .bss (__heap_start) up to RAMEND, except for:
+ *
+ *   - portMAIN_STACK_MARGIN bytes below RAMEND, used by the stack of main()
+ *     and setup() until the scheduler is started, and
+ *   - portMALLOC_HEAP_RESERVE bytes above __heap_start, left to malloc() of
+ *     avr-libc (as well as anything it already allocated before).
+ *
+ * The chosen size can be read with xPortGetHeapSize(). */
+#define portUSE_AUTO_HEAP                   0
+#define portMAIN_STACK_MARGIN               256
+#define portMALLOC_HEAP_RESERVE             0
+/*-----------------------------------------------------------*/
+
+/* When set to 1, heap_4.c takes pools of fixed size objects from the start of
+ * the heap, one per size in portHEAP_SLAB_SIZES with the number of objects in
+ * portHEAP_SLAB_COUNTS. pvPortMalloc() serves a request from the smallest pool
+ * it fits in, in constant time and without a block header, and only uses the
+ * heap when that pool is exhausted. Sizes that are equal once aligned share
+ * one pool. A queue or stream buffer is allocated together with its storage,
+ * so the StaticQueue_t class takes semaphores and mutexes, and the stream
+ * buffer class stream and message buffers of up to 31 bytes. The pools are not
+ * part of xPortGetFreeHeapSize(), see uxPortGetSlabStats(). */
+#define portUSE_HEAP_SLABS                  0
+#define portHEAP_SLAB_SIZES                 { 16, sizeof( StaticTimer_t ), sizeof( StaticStreamBuffer_t ) + 32, sizeof( StaticQueue_t ), sizeof( StaticTask_t ) }
+#define portHEAP_SLAB_COUNTS                { 4, 2, 2, 4, 4 }
+/*-----------------------------------------------------------*/
+
+/* When set to 1, heap_4.c manages the heap as several regions: ucHeap, the
+ * regions of the table portHEAP_REGIONS (by default the external memory of the
+ * port, see portUSE_XMEM) and those added with vPortAddHeapRegion() or
+ * vPortDefineHeapRegions(), up to portHEAP_MAX_REGIONS. Blocks of
+ * portHEAP_EXTERNAL_THRESHOLD bytes or more, like the storage of queues and
+ * stream buffers, are taken from external memory first, smaller ones from
+ * internal memory first, and task stacks and TCBs as set by
+ * portHEAP_TASK_PLACEMENT. uxPortGetHeapRegionStats() returns the use of each
+ * region. */
+#define portUSE_HEAP_REGIONS                0
+#define portHEAP_MAX_REGIONS                4
+#define portHEAP_EXTERNAL_THRESHOLD         128
+#define portHEAP_TASK_PLACEMENT             portHEAP_PLACE_INTERNAL
+/*-----------------------------------------------------------*/
+
+/* ATmega640/1280/2560 only. When set to 1, the external memory interface is
+ * enabled before main() with portXMEM_WAIT_STATES (0 to 3) wait states, and the
+ * external RAM from behind the internal SRAM up to 0xFFFE becomes a region of
+ * the heap with portUSE_HEAP_REGIONS. Define portXMEM_SIZE for a smaller RAM. */
+#define portUSE_XMEM                        0
+#define portXMEM_WAIT_STATES                0
+/*-----------------------------------------------------------*/
+
+/* When set to 1, heap_4.c keeps a reserve of portHEAP_ISR_BLOCKS blocks of
+ * portHEAP_ISR_BLOCK_SIZE bytes for pvPortMallocFromISR(), and
+ * vPortFreeFromISR() frees any block from an ISR: blocks of the reserve go
+ * straight back, blocks of the heap go on a list that the next pvPortMalloc()
+ * or vPortFree() of a task returns to the heap. Both only mask the interrupts
+ * for a few instructions. */
+#define portUSE_HEAP_ISR                    0
+#define portHEAP_ISR_BLOCKS                 4
+#define portHEAP_ISR_BLOCK_SIZE             64
+/*-----------------------------------------------------------*/
+
+/* When set to 1, heap_tlsf.c implements pvPortMalloc() and vPortFree() instead
+ * of heap_4.c, with a two level segregated fit allocator that takes a bounded
+ * time no matter how fragmented the heap is. Each power of two of block sizes
+ * is split in 2^portHEAP_TLSF_SL_LOG2 (1 to 3) free lists, a block can be at
+ * most 2^portHEAP_TLSF_FL_MAX bytes. Not combinable with portUSE_HEAP_SLABS. */
+#define portUSE_HEAP_TLSF                   0
+#define portHEAP_TLSF_SL_LOG2               2
+#define portHEAP_TLSF_FL_MAX                16
+/*-----------------------------------------------------------*/
+
+/* When set to 1, the kernel trace macros write the task switches, the blocking
+ * and the queue operations as records of 4 bytes into a RAM buffer of
+ * portTRACE_BUFFER_SIZE bytes, see trace_recorder.h. Recording is started with
+ * vTraceStart(), the records are read with xTraceRead() (e.g. to Serial) and
+ * extras/trace/trace2perfetto.py converts them into a timeline. */
+#define portUSE_TRACE_RECORDER              0
+#define portTRACE_BUFFER_SIZE               256
+/*-----------------------------------------------------------*/
+
+/* When set to 1, the critical sections and the scheduler suspension are timed
+ * and the worst case is kept for the portCRITICAL_PROFILER_SITES call sites
+ * with the longest ones, see critical_profiler.h. For profiling builds only,
+ * it makes every critical section longer. */
+#define portUSE_CRITICAL_PROFILER           0
+#define portCRITICAL_PROFILER_SITES         8
+/*-----------------------------------------------------------*/
+
+/* When set to 1, the tick interrupt samples the code address it interrupted
+ * and counts it per task in a table of portPC_PROFILER_SLOTS entries (a power
+ * of two, 10 bytes each on the AVR), in buckets of 2^portPC_PROFILER_SHIFT
+ * bytes, see pc_profiler.h. extras/profiler/pcprof.py maps them to symbols. */
+#define portUSE_PC_PROFILER                 0
+#define portPC_PROFILER_SLOTS               32
+#define portPC_PROFILER_SHIFT               4
+/*-----------------------------------------------------------*/
+
+/* When set to 1, xTelemetryStart() creates a low priority task that sends a
+ * binary frame with the tasks, the heap and up to portTELEMETRY_MAX_QUEUES
+ * queues every portTELEMETRY_PERIOD_MS, see telemetry.h. Up to
+ * portTELEMETRY_MAX_TASKS tasks are sent. Requires configUSE_TRACE_FACILITY,
+ * extras/telemetry/frtop.py shows the frames like top. */
+#define portUSE_TELEMETRY                   0
+#define portTELEMETRY_PERIOD_MS             1000
+#define portTELEMETRY_MAX_TASKS             8
+#define portTELEMETRY_MAX_QUEUES            4
+/*-----------------------------------------------------------*/
+
 /* Set appropriate heap size for the supported devices. */
-#if defined( ARDUINO_AVR_UNO ) || \
+#if( portUSE_AUTO_HEAP == 1 )
+
+    #define configTOTAL_HEAP_SIZE   xPortGetHeapSize()
+
+#elif defined( ARDUINO_AVR_UNO ) || \
     defined( ARDUINO_AVR_PRO )
 
     #define configTOTAL_HEAP_SIZE   ( ( size_t ) 768 )
@@ -253,6 +426,27 @@
 
     #define configTOTAL_HEAP_SIZE   ( ( size_t ) 4096 )
 
+#elif defined( FREERTOS_HOST_POSIX )
+
+    #define configTOTAL_HEAP_SIZE   ( ( size_t ) ( 64 * 1024 ) )
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_TRACE_RECORDER == 1 )
+    #include "trace_recorder.h"
+#endif
+
+#if( portUSE_CRITICAL_PROFILER == 1 )
+    #include "critical_profiler.h"
+#endif
+
+#if( portUSE_PC_PROFILER == 1 )
+    #include "pc_profiler.h"
+#endif
+
+#if( portUSE_TELEMETRY == 1 )
+    #include "telemetry.h"
 #endif
 /*-----------------------------------------------------------*/
 
@@ -0,0 +1,279 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        Arduino.cpp
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Stand-in for the Arduino core of the POSIX host port, see
+ *              Arduino.h.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined( FREERTOS_HOST_POSIX )
+
+#include <stdio.h>
+
+#include "Arduino.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*-----------------------------------------------------------*/
+
+#define hostNUM_PINS    32
+
+/* Value read back by digitalRead(). */
+static uint8_t ucPinState[ hostNUM_PINS ];
+
+HardwareSerial Serial;
+
+/*-----------------------------------------------------------*/
+
+/* The C library of the host is not reentrant across tasks that preempt each
+ * other in the same thread, so every output is made with the tick masked. */
+#define hostSERIAL_PRINTF( ... )                        \
+    {                                                   \
+        int iCount;                                     \
+        portENTER_CRITICAL();                           \
+        iCount = printf( __VA_ARGS__ );                 \
+        portEXIT_CRITICAL();                            \
+        return ( iCount > 0 ) ? ( size_t ) iCount : 0;  \
+    }
+
+/*-----------------------------------------------------------*/
+
+extern "C" void pinMode( uint8_t ucPin, uint8_t ucMode )
+{
+    ( void ) ucPin;
+    ( void ) ucMode;
+}
+/*-----------------------------------------------------------*/
+
+extern "C" void digitalWrite( uint8_t ucPin, uint8_t ucValue )
+{
+    if( ucPin < hostNUM_PINS )
+    {
+        ucPinState[ ucPin ] = ( ucValue != LOW ) ? HIGH : LOW;
+    }
+}
+/*-----------------------------------------------------------*/
+
+extern "C" int digitalRead( uint8_t ucPin )
+{
+    return ( ucPin < hostNUM_PINS ) ? ucPinState[ ucPin ] : LOW;
+}
+/*-----------------------------------------------------------*/
+
+extern "C" int analogRead( uint8_t ucPin )
+{
+    ( void ) ucPin;
+
+    /* Half of the range of the 10 bit ADC. */
+    return 512;
+}
+/*-----------------------------------------------------------*/
+
+extern "C" unsigned long millis( void )
+{
+    return ( unsigned long ) ( ullPortGetHostTime() / 1000U );
+}
+/*-----------------------------------------------------------*/
+
+extern "C" unsigned long micros( void )
+{
+    return ( unsigned long ) ullPortGetHostTime();
+}
+/*-----------------------------------------------------------*/
+
+extern "C" void delay( unsigned long ulMilliseconds )
+{
+    vPortHostBusyWait( ( uint64_t ) ulMilliseconds * 1000U );
+}
+/*-----------------------------------------------------------*/
+
+extern "C" void delayMicroseconds( unsigned int uiMicroseconds )
+{
+    vPortHostBusyWait( uiMicroseconds );
+}
+/*-----------------------------------------------------------*/
+
+/* Called by vApplicationIdleHook() in port.c after loop(), as in the Arduino
+ * cores. */
+extern "C" void serialEventRun( void )
+{
+    fflush( stdout );
+    vPortHostIdle();
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    setup();
+
+    /* Only reached if the scheduler was not started in setup(), or after
+     * vTaskEndScheduler(). */
+    for( ;; )
+    {
+        loop();
+        serialEventRun();
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+void HardwareSerial::begin( unsigned long ulBaud )
+{
+    ( void ) ulBaud;
+}
+
+void HardwareSerial::end( void )
+{
+}
+
+void HardwareSerial::flush( void )
+{
+    portENTER_CRITICAL();
+    fflush( stdout );
+    portEXIT_CRITICAL();
+}
+
+int HardwareSerial::available( void )
+{
+    return 0;
+}
+
+int HardwareSerial::read( void )
+{
+    return -1;
+}
+
+size_t HardwareSerial::write( uint8_t ucByte )
+{
+    hostSERIAL_PRINTF( "%c", ucByte );
+}
+
+size_t HardwareSerial::write( const uint8_t * pucBuffer, size_t xLength )
+{
+    size_t xWritten;
+
+    portENTER_CRITICAL();
+    xWritten = fwrite( pucBuffer, 1, xLength, stdout );
+    portEXIT_CRITICAL();
+
+    return xWritten;
+}
+
+size_t HardwareSerial::print( const char * pcString )
+{
+    hostSERIAL_PRINTF( "%s", pcString );
+}
+
+size_t HardwareSerial::print( const __FlashStringHelper * pcString )
+{
+    return print( ( const char * ) pcString );
+}
+
+size_t HardwareSerial::print( char cChar )
+{
+    hostSERIAL_PRINTF( "%c", cChar );
+}
+
+size_t HardwareSerial::print( int iValue, int iBase )
+{
+    return print( ( long ) iValue, iBase );
+}
+
+size_t HardwareSerial::print( unsigned int uiValue, int iBase )
+{
+    return print( ( unsigned long ) uiValue, iBase );
+}
+
+size_t HardwareSerial::print( long lValue, int iBase )
+{
+    if( ( lValue < 0 ) && ( iBase == DEC ) )
+    {
+        return print( '-' ) + print( ( unsigned long ) -lValue, iBase );
+    }
+
+    return print( ( unsigned long ) lValue, iBase );
+}
+
+size_t HardwareSerial::print( unsigned long ulValue, int iBase )
+{
+    char cBuffer[ sizeof( unsigned long ) * 8 + 1 ];
+    char * pcDigit = &( cBuffer[ sizeof( cBuffer ) - 1 ] );
+
+    if( ( iBase < 2 ) || ( iBase > 16 ) )
+    {
+        iBase = DEC;
+    }
+
+    *pcDigit = '\0';
+
+    do
+    {
+        *--pcDigit = "0123456789ABCDEF"[ ulValue % ( unsigned long ) iBase ];
+        ulValue /= ( unsigned long ) iBase;
+    } while( ulValue != 0 );
+
+    return print( pcDigit );
+}
+
+size_t HardwareSerial::print( double dValue, int iDigits )
+{
+    hostSERIAL_PRINTF( "%.*f", iDigits, dValue );
+}
+
+size_t HardwareSerial::println( void )
+{
+    hostSERIAL_PRINTF( "\r\n" );
+}
+
+size_t HardwareSerial::println( const char * pcString )
+{
+    return print( pcString ) + println();
+}
+
+size_t HardwareSerial::println( const __FlashStringHelper * pcString )
+{
+    return print( pcString ) + println();
+}
+
+size_t HardwareSerial::println( char cChar )
+{
+    return print( cChar ) + println();
+}
+
+size_t HardwareSerial::println( int iValue, int iBase )
+{
+    return print( iValue, iBase ) + println();
+}
+
+size_t HardwareSerial::println( unsigned int uiValue, int iBase )
+{
+    return print( uiValue, iBase ) + println();
+}
+
+size_t HardwareSerial::println( long lValue, int iBase )
+{
+    return print( lValue, iBase ) + println();
+}
+
+size_t HardwareSerial::println( unsigned long ulValue, int iBase )
+{
+    return print( ulValue, iBase ) + println();
+}
+
+size_t HardwareSerial::println( double dValue, int iDigits )
+{
+    return print( dValue, iDigits ) + println();
+}
+
+#endif /* FREERTOS_HOST_POSIX */
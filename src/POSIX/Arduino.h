@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        Arduino.h
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Stand-in for the Arduino core of the POSIX host port. Only
+ *              what FreeRTOSConfig.h, port.c and the examples use is there.
+ *              Pins have no effect and analogRead() returns a fixed value.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ARDUINO_H__
+#define __ARDUINO_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/*-----------------------------------------------------------*/
+
+/* Nominal clock of the host "board", only used by configCPU_CLOCK_HZ. */
+#ifndef F_CPU
+    #define F_CPU           16000000UL
+#endif
+
+#define HIGH                0x1
+#define LOW                 0x0
+
+#define INPUT               0x0
+#define OUTPUT              0x1
+#define INPUT_PULLUP        0x2
+
+#define LED_BUILTIN         13
+
+#define A0                  14
+#define A1                  15
+#define A2                  16
+#define A3                  17
+#define A4                  18
+#define A5                  19
+
+#define DEC                 10
+#define HEX                 16
+#define OCT                 8
+#define BIN                 2
+
+#define PROGMEM
+#define F( string_literal )     ( ( const __FlashStringHelper * ) ( string_literal ) )
+#define pgm_read_byte( addr )   ( *( const uint8_t * ) ( addr ) )
+#define pgm_read_word( addr )   ( *( const uint16_t * ) ( addr ) )
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+/*-----------------------------------------------------------*/
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+void setup( void );
+void loop( void );
+
+void pinMode( uint8_t ucPin, uint8_t ucMode );
+void digitalWrite( uint8_t ucPin, uint8_t ucValue );
+int digitalRead( uint8_t ucPin );
+int analogRead( uint8_t ucPin );
+
+unsigned long millis( void );
+unsigned long micros( void );
+void delay( unsigned long ulMilliseconds );
+void delayMicroseconds( unsigned int uiMicroseconds );
+
+#ifdef __cplusplus
+    }
+#endif
+/*-----------------------------------------------------------*/
+
+#ifdef __cplusplus
+
+/* Strings in "flash" are plain strings on the host. */
+class __FlashStringHelper;
+
+/* Serial writes to stdout. The output of a call is not interleaved with the
+ * one of another task. */
+class HardwareSerial
+{
+public:
+    void begin( unsigned long ulBaud );
+    void end( void );
+    void flush( void );
+    int available( void );
+    int read( void );
+
+    size_t write( uint8_t ucByte );
+    size_t write( const uint8_t * pucBuffer, size_t xLength );
+    size_t print( const char * pcString );
+    size_t print( const __FlashStringHelper * pcString );
+    size_t print( char cChar );
+    size_t print( int iValue, int iBase = DEC );
+    size_t print( unsigned int uiValue, int iBase = DEC );
+    size_t print( long lValue, int iBase = DEC );
+    size_t print( unsigned long ulValue, int iBase = DEC );
+    size_t print( double dValue, int iDigits = 2 );
+    size_t println( void );
+    size_t println( const char * pcString );
+    size_t println( const __FlashStringHelper * pcString );
+    size_t println( char cChar );
+    size_t println( int iValue, int iBase = DEC );
+    size_t println( unsigned int uiValue, int iBase = DEC );
+    size_t println( long lValue, int iBase = DEC );
+    size_t println( unsigned long ulValue, int iBase = DEC );
+    size_t println( double dValue, int iDigits = 2 );
+
+    operator bool( void ) { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif /* __cplusplus */
+/*-----------------------------------------------------------*/
+
+#endif /* __ARDUINO_H__ */
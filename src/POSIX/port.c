@@ -0,0 +1,599 @@
+/*
+ * FreeRTOS Kernel V11.1.0
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#if defined( FREERTOS_HOST_POSIX )
+
+/* For the registers in the signal context, see prvSIGNAL_PC(). */
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*-----------------------------------------------------------
+* Implementation of functions defined in portable.h for a POSIX host.
+*----------------------------------------------------------*/
+
+/* Context of a task. The stack given by the kernel only holds a pointer to
+ * it, see pxPortInitialiseStack(). */
+typedef struct HostTask
+{
+    ucontext_t xContext;
+    TaskFunction_t pxCode;
+    void * pvParameters;
+    void * pvStack;
+} HostTask_t;
+
+/* The TCB is only used to get to the pointer that pxTopOfStack points to. */
+typedef void FreeRTOS_TCB_t;
+extern volatile FreeRTOS_TCB_t * volatile pxCurrentTCB;
+
+/* The "interrupt enable" flag and the critical nesting of the running task.
+ * Both are saved on the stack of a task while it is switched out. */
+static volatile sig_atomic_t xInterruptsMasked = pdFALSE;
+static volatile sig_atomic_t xTickPending = pdFALSE;
+static UBaseType_t uxCriticalNesting = 0;
+
+#if ( portUSE_PC_PROFILER == 1 )
+
+/* Code address interrupted by the last SIGALRM, sampled by the next prvTick()
+ * as the tick may be deferred by a critical section. */
+    static volatile uint32_t ulTickAddress = 0;
+
+/* PC of the signal context, as an offset from the start of the executable so
+ * it matches the addresses of a PIE executable in nm. 0 where unknown. */
+    #if defined( __linux__ ) && defined( __x86_64__ )
+        #define prvSIGNAL_PC( pvContext )    ( ( ucontext_t * ) ( pvContext ) )->uc_mcontext.gregs[ REG_RIP ]
+    #elif defined( __linux__ ) && defined( __aarch64__ )
+        #define prvSIGNAL_PC( pvContext )    ( ( ucontext_t * ) ( pvContext ) )->uc_mcontext.pc
+    #endif
+
+    #ifdef prvSIGNAL_PC
+        extern char __executable_start;
+        #define prvSIGNAL_ADDRESS( pvContext )    ( ( uint32_t ) ( ( uintptr_t ) prvSIGNAL_PC( pvContext ) - ( uintptr_t ) &__executable_start ) )
+    #else
+        #define prvSIGNAL_ADDRESS( pvContext )    ( ( uint32_t ) 0U )
+    #endif
+
+#endif /* portUSE_PC_PROFILER */
+
+/* Context of main() while the scheduler runs, resumed by vPortEndScheduler(). */
+static ucontext_t xSchedulerContext;
+static BaseType_t xSchedulerStarted = pdFALSE;
+
+/* A task that deleted itself can not free its stack while still running on
+ * it, so that is done at the next occasion. */
+static HostTask_t * pxPendingFree = NULL;
+
+#define portHOST_TICK_PERIOD_US    ( ( uint64_t ) 1000000 / configTICK_RATE_HZ )
+
+#if ( portHOST_VIRTUAL_CLOCK == 0 )
+    /* Taken by the first ullPortGetHostTime(), so micros() counts from the
+     * start of the process as on a board, not from the scheduler start. */
+    static struct timespec xStartTime;
+    static BaseType_t xStartTimeTaken = pdFALSE;
+#else
+    /* Virtual time in microseconds and the time of the next tick. */
+    static uint64_t ullVirtualTime = 0;
+    static uint64_t ullNextTickTime = portHOST_TICK_PERIOD_US;
+#endif
+/*-----------------------------------------------------------*/
+
+/* Compiler barrier, keeps the accesses to the kernel data inside the sections
+ * that are guarded by the interrupt flag. */
+#define portHOST_BARRIER()    __asm__ __volatile__ ( "" ::: "memory" )
+/*-----------------------------------------------------------*/
+
+static HostTask_t * prvGetHostTask( volatile FreeRTOS_TCB_t * pxTCB )
+{
+    /* pxTopOfStack is the first member of the TCB. */
+    return ( HostTask_t * ) **( StackType_t * volatile * ) pxTCB;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFreePending( void )
+{
+    if( pxPendingFree != NULL )
+    {
+        free( pxPendingFree->pvStack );
+        free( pxPendingFree );
+        pxPendingFree = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Selects the next task and switches to it. Must be called with the interrupts
+ * masked. Returns when the calling task runs again. */
+static void prvSwitchContext( void )
+{
+    HostTask_t * pxFrom = prvGetHostTask( pxCurrentTCB );
+    HostTask_t * pxTo;
+    UBaseType_t uxSavedCriticalNesting = uxCriticalNesting;
+
+    vTaskSwitchContext();
+    pxTo = prvGetHostTask( pxCurrentTCB );
+
+    if( pxTo != pxFrom )
+    {
+        swapcontext( &( pxFrom->xContext ), &( pxTo->xContext ) );
+        prvFreePending();
+    }
+
+    uxCriticalNesting = uxSavedCriticalNesting;
+}
+/*-----------------------------------------------------------*/
+
+/* The tick "interrupt". Must be called with the interrupts masked. */
+static void prvTick( void )
+{
+    #if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+        const uint32_t ulTickStart = portGET_LATENCY_TIMESTAMP();
+    #endif
+    BaseType_t xSwitchRequired;
+
+    #if ( portUSE_PC_PROFILER == 1 )
+    {
+        vPcProfileSample( ulTickAddress, ( void * ) pxCurrentTCB );
+        ulTickAddress = 0;
+    }
+    #endif
+
+    xSwitchRequired = xTaskIncrementTick();
+
+    /* Recorded before the switch, which only returns when this task runs
+     * again. */
+    #if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+        vTaskRecordLatency( eLatencyTickISR, ulTickStart );
+    #endif
+
+    if( xSwitchRequired != pdFALSE )
+    {
+        prvSwitchContext();
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Runs the ticks that came in while the interrupts were masked. Must be called
+ * with the interrupts enabled. */
+static void prvRunPendingTick( void )
+{
+    while( xTickPending != pdFALSE )
+    {
+        xInterruptsMasked = pdTRUE;
+        xTickPending = pdFALSE;
+        portHOST_BARRIER();
+        prvTick();
+        portHOST_BARRIER();
+        xInterruptsMasked = pdFALSE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+#if ( portHOST_VIRTUAL_CLOCK == 0 )
+
+    static void prvTickSignalHandler( int iSignal,
+                                      siginfo_t * pxInfo,
+                                      void * pvContext )
+    {
+        int iSavedErrno = errno;
+
+        ( void ) iSignal;
+        ( void ) pxInfo;
+        ( void ) pvContext;
+
+        #if ( portUSE_PC_PROFILER == 1 )
+        {
+            ulTickAddress = prvSIGNAL_ADDRESS( pvContext );
+        }
+        #endif
+
+        if( xInterruptsMasked != pdFALSE )
+        {
+            xTickPending = pdTRUE;
+        }
+        else
+        {
+            /* Switching the context here is what a tick ISR does on a board. The
+             * handler frame stays on the stack of the preempted task until it
+             * runs again. */
+            xInterruptsMasked = pdTRUE;
+            portHOST_BARRIER();
+            prvTick();
+            portHOST_BARRIER();
+            xInterruptsMasked = pdFALSE;
+        }
+
+        errno = iSavedErrno;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvSetupTimerInterrupt( void )
+    {
+        struct sigaction xAction = { 0 };
+        struct itimerval xTimer = { 0 };
+
+        xAction.sa_sigaction = prvTickSignalHandler;
+        xAction.sa_flags = SA_RESTART | SA_SIGINFO;
+        sigemptyset( &xAction.sa_mask );
+        sigaction( SIGALRM, &xAction, NULL );
+
+        xTimer.it_interval.tv_usec = ( suseconds_t ) portHOST_TICK_PERIOD_US;
+        xTimer.it_value.tv_usec = ( suseconds_t ) portHOST_TICK_PERIOD_US;
+        setitimer( ITIMER_REAL, &xTimer, NULL );
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvStopTimerInterrupt( void )
+    {
+        struct itimerval xTimer = { 0 };
+
+        setitimer( ITIMER_REAL, &xTimer, NULL );
+    }
+
+#endif /* portHOST_VIRTUAL_CLOCK == 0 */
+/*-----------------------------------------------------------*/
+
+/* Entry point of every task. It is switched to with the interrupts masked. */
+static void prvTaskStart( void )
+{
+    HostTask_t * pxTask = prvGetHostTask( pxCurrentTCB );
+
+    prvFreePending();
+    uxCriticalNesting = 0;
+    xInterruptsMasked = pdFALSE;
+    prvRunPendingTick();
+
+    pxTask->pxCode( pxTask->pvParameters );
+
+    /* A task must not return from its function. */
+    #if ( INCLUDE_vTaskDelete == 1 )
+        vTaskDelete( NULL );
+    #endif
+
+    for( ;; )
+    {
+    }
+}
+/*-----------------------------------------------------------*/
+
+StackType_t * pxPortInitialiseStack( StackType_t * pxTopOfStack,
+                                     TaskFunction_t pxCode,
+                                     void * pvParameters )
+{
+    HostTask_t * pxTask;
+    UBaseType_t uxSavedInterruptStatus;
+
+    /* xTaskCreate() calls this outside a critical section. The tick must not
+     * switch to another task while it is inside the host allocator, which is
+     * not reentrant. */
+    uxSavedInterruptStatus = uxPortSetInterruptMask();
+    {
+        pxTask = malloc( sizeof( HostTask_t ) );
+
+        if( pxTask != NULL )
+        {
+            pxTask->pvStack = malloc( portHOST_TASK_STACK_SIZE );
+        }
+    }
+    vPortClearInterruptMask( uxSavedInterruptStatus );
+
+    configASSERT( pxTask != NULL );
+    configASSERT( pxTask->pvStack != NULL );
+
+    pxTask->pxCode = pxCode;
+    pxTask->pvParameters = pvParameters;
+
+    getcontext( &( pxTask->xContext ) );
+    pxTask->xContext.uc_stack.ss_sp = pxTask->pvStack;
+    pxTask->xContext.uc_stack.ss_size = portHOST_TASK_STACK_SIZE;
+    pxTask->xContext.uc_link = NULL;
+
+    #if ( portHOST_VIRTUAL_CLOCK == 0 )
+        sigdelset( &( pxTask->xContext.uc_sigmask ), SIGALRM );
+    #endif
+
+    makecontext( &( pxTask->xContext ), prvTaskStart, 0 );
+
+    *pxTopOfStack = ( StackType_t ) pxTask;
+
+    return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+    /* The interrupts were masked by vTaskStartScheduler(). */
+    #if ( portHOST_VIRTUAL_CLOCK == 0 )
+        prvSetupTimerInterrupt();
+    #endif
+
+    xSchedulerStarted = pdTRUE;
+
+    /* Start the first task. */
+    swapcontext( &xSchedulerContext, &( prvGetHostTask( pxCurrentTCB )->xContext ) );
+
+    /* Only reached after vTaskEndScheduler(). */
+    prvFreePending();
+    xSchedulerStarted = pdFALSE;
+    uxCriticalNesting = 0;
+    xTickPending = pdFALSE;
+    xInterruptsMasked = pdFALSE;
+
+    return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+    #if ( portHOST_VIRTUAL_CLOCK == 0 )
+        prvStopTimerInterrupt();
+    #endif
+
+    /* Return to xPortStartScheduler(). The calling task is left behind. */
+    setcontext( &xSchedulerContext );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+    sig_atomic_t xWasMasked = xInterruptsMasked;
+
+    xInterruptsMasked = pdTRUE;
+    portHOST_BARRIER();
+    prvSwitchContext();
+    portHOST_BARRIER();
+    xInterruptsMasked = xWasMasked;
+
+    if( xWasMasked == pdFALSE )
+    {
+        prvRunPendingTick();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortCancelThread( void * pxTaskToDelete )
+{
+    HostTask_t * pxTask = prvGetHostTask( pxTaskToDelete );
+    UBaseType_t uxSavedInterruptStatus;
+
+    /* prvDeleteTCB() calls this outside a critical section, see
+     * pxPortInitialiseStack(). */
+    uxSavedInterruptStatus = uxPortSetInterruptMask();
+    {
+        if( ( xSchedulerStarted != pdFALSE ) && ( pxTaskToDelete == pxCurrentTCB ) )
+        {
+            /* Still running on this stack, e.g. vTaskEndScheduler() deleting
+             * the timer task from a timer callback. */
+            prvFreePending();
+            pxPendingFree = pxTask;
+        }
+        else
+        {
+            free( pxTask->pvStack );
+            free( pxTask );
+        }
+    }
+    vPortClearInterruptMask( uxSavedInterruptStatus );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+    #if ( portUSE_CRITICAL_PROFILER == 1 )
+        const BaseType_t xWasMasked = xInterruptsMasked;
+    #endif
+
+    xInterruptsMasked = pdTRUE;
+    portHOST_BARRIER();
+    uxCriticalNesting++;
+
+    #if ( portUSE_CRITICAL_PROFILER == 1 )
+        if( xWasMasked == pdFALSE )
+        {
+            vCriticalProfileBegin( profKIND_CRITICAL, ( uintptr_t ) __builtin_return_address( 0 ) );
+        }
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+    configASSERT( uxCriticalNesting > 0 );
+
+    uxCriticalNesting--;
+
+    if( uxCriticalNesting == 0 )
+    {
+        #if ( portUSE_CRITICAL_PROFILER == 1 )
+            vCriticalProfileEnd( profKIND_CRITICAL );
+        #endif
+
+        vPortEnableInterrupts();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+    xInterruptsMasked = pdTRUE;
+    portHOST_BARRIER();
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+    portHOST_BARRIER();
+    xInterruptsMasked = pdFALSE;
+    prvRunPendingTick();
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortSetInterruptMask( void )
+{
+    UBaseType_t uxSavedInterruptStatus = ( UBaseType_t ) xInterruptsMasked;
+
+    xInterruptsMasked = pdTRUE;
+    portHOST_BARRIER();
+
+    return uxSavedInterruptStatus;
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( UBaseType_t uxSavedInterruptStatus )
+{
+    /* Also used in the tick, where the interrupts stay masked. */
+    if( uxSavedInterruptStatus == pdFALSE )
+    {
+        vPortEnableInterrupts();
+    }
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortGetHostTime( void )
+{
+    #if ( portHOST_VIRTUAL_CLOCK == 0 )
+        struct timespec xNow;
+
+        clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+        if( xStartTimeTaken == pdFALSE )
+        {
+            xStartTime = xNow;
+            xStartTimeTaken = pdTRUE;
+        }
+
+        return ( ( uint64_t ) ( xNow.tv_sec - xStartTime.tv_sec ) * 1000000U ) +
+               ( uint64_t ) ( ( xNow.tv_nsec - xStartTime.tv_nsec ) / 1000 );
+    #else
+        return ullVirtualTime;
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+void vPortHostIdle( void )
+{
+    #if ( portHOST_VIRTUAL_CLOCK == 0 )
+        if( xSchedulerStarted != pdFALSE )
+        {
+            /* Like the sleep mode of a board, any tick ends it. */
+            pause();
+        }
+        else
+        {
+            usleep( ( useconds_t ) portHOST_TICK_PERIOD_US );
+        }
+    #else
+        vPortHostBusyWait( portHOST_TICK_PERIOD_US );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+void vPortHostBusyWait( uint64_t ullMicroseconds )
+{
+    #if ( portHOST_VIRTUAL_CLOCK == 0 )
+        uint64_t ullEnd = ullPortGetHostTime() + ullMicroseconds;
+        uint64_t ullNow;
+        struct timespec xWait;
+
+        /* nanosleep() returns early for every tick, which may have run other
+         * tasks in between. */
+        while( ( ullNow = ullPortGetHostTime() ) < ullEnd )
+        {
+            xWait.tv_sec = ( time_t ) ( ( ullEnd - ullNow ) / 1000000U );
+            xWait.tv_nsec = ( long ) ( ( ( ullEnd - ullNow ) % 1000000U ) * 1000U );
+            nanosleep( &xWait, NULL );
+        }
+    #else
+        uint64_t ullEnd = ullVirtualTime + ullMicroseconds;
+
+        /* Every tick that passes while the task is busy is a tick interrupt.
+         * With the interrupts masked it is held pending, like on a board. */
+        while( ullNextTickTime <= ullEnd )
+        {
+            ullVirtualTime = ullNextTickTime;
+            ullNextTickTime += portHOST_TICK_PERIOD_US;
+
+            if( xSchedulerStarted == pdFALSE )
+            {
+                continue;
+            }
+
+            if( xInterruptsMasked != pdFALSE )
+            {
+                xTickPending = pdTRUE;
+            }
+            else
+            {
+                xInterruptsMasked = pdTRUE;
+                portHOST_BARRIER();
+                prvTick();
+                portHOST_BARRIER();
+                xInterruptsMasked = pdFALSE;
+            }
+        }
+
+        ullVirtualTime = ullEnd;
+    #endif /* if ( portHOST_VIRTUAL_CLOCK == 0 ) */
+}
+/*-----------------------------------------------------------*/
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+    uint32_t ulPortGetRunTimeCounterValue( void )
+    {
+        return ( uint32_t ) ullPortGetHostTime();
+    }
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 ) || ( portUSE_CRITICAL_PROFILER == 1 )
+
+    uint32_t ulPortGetLatencyTimestamp( void )
+    {
+        struct timespec xNow;
+
+        /* Always the host time, also with the virtual clock, which does not
+         * advance within a tick. */
+        clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+        return ( uint32_t ) ( ( ( uint64_t ) xNow.tv_sec * 1000000000U ) + ( uint64_t ) xNow.tv_nsec );
+    }
+
+#endif
+
+#endif /* FREERTOS_HOST_POSIX */
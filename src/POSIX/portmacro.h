@@ -0,0 +1,196 @@
+/*
+ * FreeRTOS Kernel V11.1.0
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+#if defined( FREERTOS_HOST_POSIX )
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/*-----------------------------------------------------------
+ * Port specific definitions.
+ *
+ * The settings in this file configure FreeRTOS correctly for the
+ * given hardware and compiler.
+ *
+ * These settings should not be altered.
+ *-----------------------------------------------------------
+ */
+
+/* The POSIX host port runs the kernel and all the tasks in a single process
+ * and a single thread, so the scheduling is as deterministic as on the boards.
+ * Each task is a ucontext with its own host stack. The tick is either:
+ *
+ *   - the SIGALRM of an interval timer (portHOST_VIRTUAL_CLOCK 0), which
+ *     preempts the tasks like the tick interrupt of a board, or
+ *   - a virtual clock (portHOST_VIRTUAL_CLOCK 1) that only advances while the
+ *     idle task runs or a task calls delay(). Time does not pass while a task
+ *     computes, so a run does not depend on the speed or load of the host.
+ *
+ * "Interrupts" are a flag: while it is set, a tick is held pending and run as
+ * soon as the flag is cleared. */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef portHOST_VIRTUAL_CLOCK
+    #define portHOST_VIRTUAL_CLOCK    0
+#endif
+
+/* Size of the host stack of each task in bytes. The stack given to
+ * xTaskCreate() only holds a pointer to the context, as the C library of the
+ * host needs a lot more than the stack depth that fits an AVR. */
+#ifndef portHOST_TASK_STACK_SIZE
+    #define portHOST_TASK_STACK_SIZE    ( 64 * 1024 )
+#endif
+
+#if ( portUSE_AUTO_HEAP == 1 ) || ( portRECLAIM_MAIN_STACK == 1 )
+    #error portUSE_AUTO_HEAP and portRECLAIM_MAIN_STACK are not supported by the POSIX host port.
+#endif
+
+/* Type definitions. */
+#define portCHAR                 char
+#define portFLOAT                float
+#define portDOUBLE               double
+#define portLONG                 long
+#define portSHORT                short
+
+#define portPOINTER_SIZE_TYPE    uintptr_t
+
+typedef uintptr_t      StackType_t;
+typedef long           BaseType_t;
+typedef unsigned long  UBaseType_t;
+
+#if configTICK_TYPE_WIDTH_IN_BITS == TICK_TYPE_WIDTH_16_BITS
+    typedef uint16_t   TickType_t;
+    #define portMAX_DELAY    ( TickType_t ) 0xffff
+#elif ( configTICK_TYPE_WIDTH_IN_BITS == TICK_TYPE_WIDTH_32_BITS )
+    typedef uint32_t   TickType_t;
+    #define portMAX_DELAY    ( TickType_t ) 0xffffffffUL
+#else
+    #error configTICK_TYPE_WIDTH_IN_BITS set to unsupported tick type width.
+#endif
+/*-----------------------------------------------------------*/
+
+/* Critical section management. */
+extern void vPortEnterCritical( void );
+extern void vPortExitCritical( void );
+extern void vPortDisableInterrupts( void );
+extern void vPortEnableInterrupts( void );
+extern UBaseType_t uxPortSetInterruptMask( void );
+extern void vPortClearInterruptMask( UBaseType_t uxSavedInterruptStatus );
+
+#define portENTER_CRITICAL()                        vPortEnterCritical()
+#define portEXIT_CRITICAL()                         vPortExitCritical()
+#define portDISABLE_INTERRUPTS()                    vPortDisableInterrupts()
+#define portENABLE_INTERRUPTS()                     vPortEnableInterrupts()
+#define portSET_INTERRUPT_MASK_FROM_ISR()           uxPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )      vPortClearInterruptMask( x )
+/*-----------------------------------------------------------*/
+
+/* Architecture specifics. */
+#define portSTACK_GROWTH          ( -1 )
+#define portTICK_PERIOD_MS        ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT        8
+#define portNOP()                 __asm__ __volatile__ ( "" ::: "memory" )
+#define portFORCE_INLINE          inline __attribute__( ( always_inline ) )
+/*-----------------------------------------------------------*/
+
+/* Port optimised task selection. uxTopReadyPriority is used as a bit map of
+ * the ready priorities and the highest one is found with a count of the
+ * leading zeros. */
+#if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+
+    #if ( configMAX_PRIORITIES > 32 )
+        #error configUSE_PORT_OPTIMISED_TASK_SELECTION can only be set to 1 when configMAX_PRIORITIES is less than or equal to 32.
+    #endif
+
+    #define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities )      ( uxReadyPriorities ) |= ( 1UL << ( uxPriority ) )
+    #define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities )       ( uxReadyPriorities ) &= ~( 1UL << ( uxPriority ) )
+    #define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities )    uxTopPriority = ( ( sizeof( unsigned long ) * 8UL ) - 1UL - ( UBaseType_t ) __builtin_clzl( ( uxReadyPriorities ) ) )
+
+#endif /* configUSE_PORT_OPTIMISED_TASK_SELECTION */
+/*-----------------------------------------------------------*/
+
+/* Kernel utilities. */
+extern void vPortYield( void );
+#define portYIELD()    vPortYield()
+
+/* The host stack of a task is freed together with its TCB. */
+extern void vPortCancelThread( void * pxTaskToDelete );
+#define portCLEAN_UP_TCB( pxTCB )    vPortCancelThread( pxTCB )
+/*-----------------------------------------------------------*/
+
+/* Host time in microseconds since the start of the process, or the virtual
+ * time if portHOST_VIRTUAL_CLOCK is 1. */
+extern uint64_t ullPortGetHostTime( void );
+
+/* Called by the idle task through serialEventRun(). Sleeps until the next tick
+ * or advances the virtual clock by one tick. */
+extern void vPortHostIdle( void );
+
+/* Keeps the calling task busy for the given time, as the busy waiting delay()
+ * of the Arduino cores does. Ticks that fall into this time are handled and
+ * can preempt the task. */
+extern void vPortHostBusyWait( uint64_t ullMicroseconds );
+/*-----------------------------------------------------------*/
+
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+/* Run time counter for the run time statistics in microseconds. */
+    extern uint32_t ulPortGetRunTimeCounterValue( void );
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+    #define portGET_RUN_TIME_COUNTER_VALUE()    ulPortGetRunTimeCounterValue()
+#endif
+
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 ) || ( portUSE_CRITICAL_PROFILER == 1 )
+/* Timestamp of the latency histograms in nanoseconds of the host clock. */
+    extern uint32_t ulPortGetLatencyTimestamp( void );
+    #define portGET_LATENCY_TIMESTAMP()    ulPortGetLatencyTimestamp()
+    #define portLATENCY_COUNT_NS           ( 1U )
+#endif
+/*-----------------------------------------------------------*/
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters )    void vFunction( void * pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters )          void vFunction( void * pvParameters )
+/*-----------------------------------------------------------*/
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* PORTMACRO_H */
+
+#endif
@@ -0,0 +1,277 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        critical_profiler.c
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Profiler of the critical sections and of the scheduler
+ *              suspension, see critical_profiler.h.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if ( portUSE_CRITICAL_PROFILER == 1 )
+
+/*-----------------------------------------------------------*/
+
+#if defined( portGET_LATENCY_TIMESTAMP )
+    #define profTIMESTAMP()     portGET_LATENCY_TIMESTAMP()
+    #define profCOUNT_NS        ( ( uint32_t ) portLATENCY_COUNT_NS )
+#else
+    extern unsigned long micros( void );
+
+    #define profTIMESTAMP()     ( ( uint32_t ) micros() )
+    #define profCOUNT_NS        ( 1000U )
+#endif
+
+/* The profiler must not use the critical sections it times. On the AVR
+ * portSET_INTERRUPT_MASK_FROM_ISR() is not defined, SREG is saved instead. */
+#if defined( __AVR__ )
+    #define profENTER()     const uint8_t ucSavedSREG = SREG; portDISABLE_INTERRUPTS()
+    #define profEXIT()      SREG = ucSavedSREG
+#else
+    #define profENTER()     UBaseType_t uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR()
+    #define profEXIT()      portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus )
+#endif
+
+/* The return address is a word address on the AVR. */
+#if defined( __AVR__ )
+    #define profSITE( uxAddress )   ( ( uint32_t ) ( uxAddress ) << 1 )
+#else
+    #define profSITE( uxAddress )   ( ( uint32_t ) ( uxAddress ) )
+#endif
+
+#if ( portCRITICAL_PROFILER_SITES < 1 ) || ( portCRITICAL_PROFILER_SITES > 32 )
+    #error "portCRITICAL_PROFILER_SITES must be 1 to 32."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* The section of a kind being timed, if ucActive. */
+typedef struct ProfileSection
+{
+    uint32_t ulStart;
+    uint32_t ulSite;
+    uint8_t ucActive;
+} ProfileSection_t;
+
+static ProfileSection_t xSections[ profKINDS ];
+
+/* Sites of each kind, unused ones have a ulCount of 0. */
+static CriticalProfileSite_t xSites[ profKINDS ][ portCRITICAL_PROFILER_SITES ];
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Starts timing a section of ucKind. Called with interrupts masked.
+ */
+static void prvStart( uint8_t ucKind,
+                      uint32_t ulSite );
+
+/*
+ * Counts the section of ucKind being timed, if any, for its site. Called with
+ * interrupts masked.
+ */
+static void prvStop( uint8_t ucKind );
+
+/*-----------------------------------------------------------*/
+
+static void prvStart( uint8_t ucKind,
+                      uint32_t ulSite )
+{
+    ProfileSection_t * const pxSection = &( xSections[ ucKind ] );
+
+    pxSection->ulSite = ulSite;
+    pxSection->ucActive = pdTRUE;
+    pxSection->ulStart = profTIMESTAMP();
+}
+/*-----------------------------------------------------------*/
+
+static void prvStop( uint8_t ucKind )
+{
+    ProfileSection_t * const pxSection = &( xSections[ ucKind ] );
+    CriticalProfileSite_t * pxSite = NULL;
+    CriticalProfileSite_t * pxFree = NULL;
+    CriticalProfileSite_t * pxShortest = NULL;
+    uint32_t ulDuration;
+
+    if( pxSection->ucActive == pdFALSE )
+    {
+        return;
+    }
+
+    ulDuration = profTIMESTAMP() - pxSection->ulStart;
+    pxSection->ucActive = pdFALSE;
+
+    /* The site, else a free entry, else the one with the shortest worst
+     * case if this section is longer. */
+    for( UBaseType_t x = 0; x < portCRITICAL_PROFILER_SITES; x++ )
+    {
+        CriticalProfileSite_t * const pxEntry = &( xSites[ ucKind ][ x ] );
+
+        if( pxEntry->ulCount == 0 )
+        {
+            pxFree = pxEntry;
+        }
+        else if( pxEntry->ulSite == pxSection->ulSite )
+        {
+            pxSite = pxEntry;
+            break;
+        }
+        else if( ( pxShortest == NULL ) || ( pxEntry->ulMax < pxShortest->ulMax ) )
+        {
+            pxShortest = pxEntry;
+        }
+    }
+
+    if( pxSite == NULL )
+    {
+        if( pxFree != NULL )
+        {
+            pxSite = pxFree;
+        }
+        else if( pxShortest->ulMax < ulDuration )
+        {
+            pxSite = pxShortest;
+        }
+        else
+        {
+            return;
+        }
+
+        pxSite->ulSite = pxSection->ulSite;
+        pxSite->ulMax = 0;
+        pxSite->ulTotal = 0;
+        pxSite->ulCount = 0;
+    }
+
+    if( ulDuration > pxSite->ulMax )
+    {
+        pxSite->ulMax = ulDuration;
+    }
+
+    pxSite->ulTotal += ulDuration;
+    pxSite->ulCount++;
+}
+/*-----------------------------------------------------------*/
+
+void vCriticalProfileEnter( void )
+{
+    prvStart( profKIND_CRITICAL, profSITE( ( uintptr_t ) __builtin_return_address( 0 ) ) );
+}
+/*-----------------------------------------------------------*/
+
+void vCriticalProfileExit( void )
+{
+    prvStop( profKIND_CRITICAL );
+}
+/*-----------------------------------------------------------*/
+
+void vCriticalProfileBegin( uint8_t ucKind,
+                            uintptr_t uxSite )
+{
+    profENTER();
+    {
+        prvStart( ucKind, profSITE( uxSite ) );
+    }
+    profEXIT();
+}
+/*-----------------------------------------------------------*/
+
+void vCriticalProfileEnd( uint8_t ucKind )
+{
+    profENTER();
+    {
+        prvStop( ucKind );
+    }
+    profEXIT();
+}
+/*-----------------------------------------------------------*/
+
+void vCriticalProfileSwitch( void )
+{
+    /* Called from vTaskSwitchContext() with interrupts masked. A switch in a
+     * critical section ends it, the next task runs with interrupts enabled. */
+    prvStop( profKIND_CRITICAL );
+}
+/*-----------------------------------------------------------*/
+
+size_t xCriticalProfileGetTop( uint8_t ucKind,
+                               CriticalProfileSite_t * pxSites,
+                               size_t xMaxSites,
+                               int xReset )
+{
+    uint32_t ulTaken = 0;
+    size_t xCount = 0;
+
+    configASSERT( ucKind < profKINDS );
+
+    /* Selection of the longest worst cases. The entries are read one at a
+     * time, to keep both the interrupts masked and the stack used short. */
+    while( xCount < xMaxSites )
+    {
+        CriticalProfileSite_t xEntry;
+        UBaseType_t uxLongest = portCRITICAL_PROFILER_SITES;
+
+        for( UBaseType_t x = 0; x < portCRITICAL_PROFILER_SITES; x++ )
+        {
+            if( ( ulTaken & ( ( uint32_t ) 1U << x ) ) != 0 )
+            {
+                continue;
+            }
+
+            profENTER();
+            {
+                xEntry = xSites[ ucKind ][ x ];
+            }
+            profEXIT();
+
+            if( ( xEntry.ulCount != 0 ) &&
+                ( ( uxLongest == portCRITICAL_PROFILER_SITES ) || ( xEntry.ulMax > pxSites[ xCount ].ulMax ) ) )
+            {
+                uxLongest = x;
+                pxSites[ xCount ] = xEntry;
+            }
+        }
+
+        if( uxLongest == portCRITICAL_PROFILER_SITES )
+        {
+            break;
+        }
+
+        ulTaken |= ( uint32_t ) 1U << uxLongest;
+        xCount++;
+    }
+
+    if( xReset != 0 )
+    {
+        profENTER();
+        {
+            ( void ) memset( xSites[ ucKind ], 0x00, sizeof( xSites[ ucKind ] ) );
+        }
+        profEXIT();
+    }
+
+    return xCount;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulCriticalProfileGetCountNs( void )
+{
+    return profCOUNT_NS;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* portUSE_CRITICAL_PROFILER */
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        critical_profiler.h
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Profiler of the critical sections and of the scheduler
+ *              suspension. Enabled with portUSE_CRITICAL_PROFILER in
+ *              FreeRTOSConfig.h, which then includes this file.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CRITICAL_PROFILER_H__
+#define __CRITICAL_PROFILER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Two kinds of sections are timed:
+ *
+ *   profKIND_CRITICAL    interrupts masked, from the portENTER_CRITICAL() that
+ *                        masks them to the portEXIT_CRITICAL() that unmasks
+ *                        them again. Nested sections count as one, the one of
+ *                        the outermost call site. A task switch within the
+ *                        section (a yield in the kernel) ends it, as the next
+ *                        task runs with interrupts enabled.
+ *   profKIND_SUSPENDED   scheduler suspended, from the outermost
+ *                        vTaskSuspendAll() to the xTaskResumeAll() that
+ *                        resumes it, without the moving of the pending ready
+ *                        tasks in xTaskResumeAll().
+ *
+ * Critical sections entered while the interrupts are already masked, e.g. in
+ * an ISR, are not timed. Neither are portSET_INTERRUPT_MASK_FROM_ISR() and
+ * portDISABLE_INTERRUPTS().
+ *
+ * Each section is counted for its call site, the return address of the call
+ * of portENTER_CRITICAL() (taskENTER_CRITICAL()) or vTaskSuspendAll(). The
+ * worst case, total and count of the portCRITICAL_PROFILER_SITES sites with
+ * the longest worst case are kept per kind. A site with a longer worst case
+ * replaces the one with the shortest once the table is full.
+ *
+ * The site is a byte address in the code, e.g. for
+ *
+ *   avr-addr2line -f -e sketch.ino.elf 0x1a2c
+ *
+ * It points behind the call instruction. On the AVR the 16 bit return address
+ * only covers the first 128 KB of the flash (the ATmega2560 has 256 KB).
+ *
+ * The timestamp is portGET_LATENCY_TIMESTAMP() of the port if it has one (the
+ * run time counter on the AVR ports, the DWT cycle counter on the Renesas
+ * boards, nanoseconds on the host port), micros() of the Arduino core
+ * otherwise. Timing makes each critical section about 10 us longer on a
+ * 16 MHz AVR, so this is meant for profiling builds only.
+ */
+
+/*-----------------------------------------------------------*/
+
+#define profKIND_CRITICAL       ( 0 )
+#define profKIND_SUSPENDED      ( 1 )
+#define profKINDS               ( 2 )
+
+typedef struct CriticalProfileSite
+{
+    uint32_t ulSite;    /* Code address of the call site. */
+    uint32_t ulMax;     /* Longest section in timestamp counts. */
+    uint32_t ulTotal;   /* Sum of all sections in timestamp counts. */
+    uint32_t ulCount;   /* Number of sections. */
+} CriticalProfileSite_t;
+
+/*
+ * Copies up to uxMaxSites sites of ucKind into pxSites, the longest worst case
+ * first, and clears them if xReset is not 0. Returns the number of sites
+ * copied.
+ */
+size_t xCriticalProfileGetTop( uint8_t ucKind, CriticalProfileSite_t * pxSites, size_t xMaxSites, int xReset );
+
+/*
+ * Returns the length of one timestamp count in nanoseconds.
+ */
+uint32_t ulCriticalProfileGetCountNs( void );
+
+/* Called by the ports and by the macros below. vCriticalProfileEnter() and
+ * vCriticalProfileExit() are called with interrupts masked, after masking and
+ * before unmasking them. vCriticalProfileEnter() takes the call site from its
+ * return address, so it must be called directly from the critical section. */
+void vCriticalProfileEnter( void );
+void vCriticalProfileExit( void );
+void vCriticalProfileBegin( uint8_t ucKind, uintptr_t uxSite );
+void vCriticalProfileEnd( uint8_t ucKind );
+void vCriticalProfileSwitch( void );
+
+/*-----------------------------------------------------------*/
+
+/* Kernel trace macros and hooks, expanded in tasks.c. */
+#define traceRETURN_vTaskSuspendAll()                                                               \
+    do {                                                                                            \
+        if( uxSchedulerSuspended == ( UBaseType_t ) 1U )                                            \
+        {                                                                                           \
+            vCriticalProfileBegin( profKIND_SUSPENDED, ( uintptr_t ) __builtin_return_address( 0 ) ); \
+        }                                                                                           \
+    } while( 0 )
+
+#define traceENTER_xTaskResumeAll()                                 \
+    do {                                                            \
+        if( uxSchedulerSuspended == ( UBaseType_t ) 1U )            \
+        {                                                           \
+            vCriticalProfileEnd( profKIND_SUSPENDED );              \
+        }                                                           \
+    } while( 0 )
+
+#define portTASK_SWITCH_HOOK( pxTCB )    vCriticalProfileSwitch()
+
+/*-----------------------------------------------------------*/
+
+#endif /* __CRITICAL_PROFILER_H__ */
@@ -47,6 +47,13 @@
 
 #undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
 
+#ifndef portUSE_HEAP_TLSF
+    #define portUSE_HEAP_TLSF    0
+#endif
+
+/* heap_tlsf.c implements the heap instead. */
+#if ( portUSE_HEAP_TLSF != 1 )
+
 #if ( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
     #error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
 #endif
@@ -55,6 +62,58 @@
     #define configHEAP_CLEAR_MEMORY_ON_FREE    0
 #endif
 
+#ifndef portUSE_HEAP_SLABS
+    #define portUSE_HEAP_SLABS    0
+#endif
+
+#if ( portUSE_HEAP_SLABS == 1 )
+    #ifndef portHEAP_SLAB_SIZES
+        #define portHEAP_SLAB_SIZES     { 16, sizeof( StaticTimer_t ), sizeof( StaticStreamBuffer_t ) + 32, sizeof( StaticQueue_t ), sizeof( StaticTask_t ) }
+    #endif
+    #ifndef portHEAP_SLAB_COUNTS
+        #define portHEAP_SLAB_COUNTS    { 4, 2, 2, 4, 4 }
+    #endif
+#endif
+
+#ifndef portUSE_HEAP_REGIONS
+    #define portUSE_HEAP_REGIONS    0
+#endif
+
+#if ( portUSE_HEAP_REGIONS == 1 )
+    #ifndef portHEAP_MAX_REGIONS
+        #define portHEAP_MAX_REGIONS           4
+    #endif
+    #ifndef portHEAP_REGIONS
+        #define portHEAP_REGIONS               { { NULL, 0 } }
+    #endif
+    #ifndef portHEAP_EXTERNAL_THRESHOLD
+        #define portHEAP_EXTERNAL_THRESHOLD    128
+    #endif
+
+/* Memory at or above portHEAP_EXTERNAL_START is external memory, which the
+ * port defines if it has any. */
+    #ifdef portHEAP_EXTERNAL_START
+        #define heapIS_EXTERNAL( pv )    ( ( ( uint8_t * ) ( pv ) >= ( uint8_t * ) ( portHEAP_EXTERNAL_START ) ) ? pdTRUE : pdFALSE )
+    #else
+        #define heapIS_EXTERNAL( pv )    ( pdFALSE )
+    #endif
+#endif
+
+#ifndef portUSE_HEAP_ISR
+    #define portUSE_HEAP_ISR    0
+#endif
+
+#if ( portUSE_HEAP_ISR == 1 )
+    #ifndef portHEAP_ISR_BLOCKS
+        #define portHEAP_ISR_BLOCKS        4
+    #endif
+    #ifndef portHEAP_ISR_BLOCK_SIZE
+        #define portHEAP_ISR_BLOCK_SIZE    64
+    #endif
+
+    #include "atomic.h"
+#endif
+
 /* Block sizes must not get too small. */
 #define heapMINIMUM_BLOCK_SIZE    ( ( size_t ) ( xHeapStructSize << 1 ) )
 
@@ -86,7 +145,12 @@
 /*-----------------------------------------------------------*/
 
 /* Allocate the memory for the heap. */
-#if ( configAPPLICATION_ALLOCATED_HEAP == 1 )
+#if ( configAPPLICATION_ALLOCATED_HEAP == 1 ) && defined( portHEAP_START )
+
+/* The port places the heap at run time, in which case configTOTAL_HEAP_SIZE
+ * is not a constant either. */
+    #define ucHeap    ( portHEAP_START )
+#elif ( configAPPLICATION_ALLOCATED_HEAP == 1 )
 
 /* The application writer has already defined the array used for the RTOS
 * heap - probably so it can be placed in a special segment or address. */
@@ -130,10 +194,88 @@ typedef struct A_BLOCK_LINK
 
 #endif /* configENABLE_HEAP_PROTECTOR */
 
-/* Assert that a heap block pointer is within the heap bounds. */
-#define heapVALIDATE_BLOCK_POINTER( pxBlock )                          \
-    configASSERT( ( ( uint8_t * ) ( pxBlock ) >= &( ucHeap[ 0 ] ) ) && \
-                  ( ( uint8_t * ) ( pxBlock ) <= &( ucHeap[ configTOTAL_HEAP_SIZE - 1 ] ) ) )
+/* Assert that a heap block pointer is within the heap bounds.  The heap starts
+ * at pucHeapStart and ends at pxEnd, which differ from ucHeap once
+ * vPortAddHeapRegion() has been called. */
+#define heapVALIDATE_BLOCK_POINTER( pxBlock )                       \
+    configASSERT( ( ( uint8_t * ) ( pxBlock ) >= pucHeapStart ) && \
+                  ( ( uint8_t * ) ( pxBlock ) <= ( uint8_t * ) pxEnd ) )
+
+#if ( portUSE_HEAP_SLABS == 1 )
+
+/* A pool of objects of one size class.  Free objects are linked through their
+ * first bytes, so allocated objects have no header. */
+    typedef struct HeapSlab
+    {
+        void * pvFreeObject;     /**< The first free object, NULL if the pool is exhausted. */
+        uint8_t * pucStart;      /**< The first object of the pool. */
+        uint8_t * pucEnd;        /**< The byte behind the last object of the pool. */
+        size_t xObjectSize;      /**< The size of the objects, a multiple of portBYTE_ALIGNMENT. */
+        size_t xObjects;
+        size_t xFreeObjects;
+        size_t xMinimumEverFreeObjects;
+        size_t xAllocations;
+        size_t xFallbacks;       /**< Requests of this class that went to the heap as the pool was exhausted. */
+    } HeapSlab_t;
+
+    static const size_t xSlabSizes[] = portHEAP_SLAB_SIZES;
+    static const size_t xSlabCounts[] = portHEAP_SLAB_COUNTS;
+
+    #define heapSLAB_CLASSES    ( sizeof( xSlabSizes ) / sizeof( xSlabSizes[ 0 ] ) )
+
+    PRIVILEGED_DATA static HeapSlab_t xSlabs[ heapSLAB_CLASSES ];
+
+/* Number of pools in xSlabs[], less than heapSLAB_CLASSES if sizes are equal
+ * once aligned. */
+    PRIVILEGED_DATA static size_t xSlabClasses = 0;
+
+/* The pools lie together at the start of the heap. */
+    PRIVILEGED_DATA static uint8_t * pucSlabsStart = NULL;
+    PRIVILEGED_DATA static uint8_t * pucSlabsEnd = NULL;
+
+#endif /* portUSE_HEAP_SLABS */
+
+#if ( portUSE_HEAP_REGIONS == 1 )
+
+/* The bookkeeping of one region of the heap, ucHeap being the first. */
+    typedef struct HeapRegionRecord
+    {
+        uint8_t * pucStart;            /**< The first block of the region. */
+        uint8_t * pucEnd;              /**< The end marker of the region. */
+        size_t xFreeBytes;
+        size_t xMinimumEverFreeBytes;
+        size_t xAllocations;
+        size_t xFrees;
+    } HeapRegionRecord_t;
+
+    PRIVILEGED_DATA static HeapRegionRecord_t xRegions[ portHEAP_MAX_REGIONS ];
+    PRIVILEGED_DATA static UBaseType_t uxRegions = 0;
+
+#endif /* portUSE_HEAP_REGIONS */
+
+#if ( portUSE_HEAP_ISR == 1 )
+
+/* The blocks of the reserve for ISRs are rounded up to keep the next one
+ * aligned and to hold the link while they are free. */
+    #define heapISR_BLOCK_SIZE                                                                                        \
+    ( ( ( ( portHEAP_ISR_BLOCK_SIZE ) < sizeof( void * ) ? sizeof( void * ) : ( size_t ) ( portHEAP_ISR_BLOCK_SIZE ) ) \
+        + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+    PRIVILEGED_DATA static uint8_t ucIsrPool[ ( portHEAP_ISR_BLOCKS * heapISR_BLOCK_SIZE ) + portBYTE_ALIGNMENT ];
+
+/* The aligned blocks of the reserve are set up by the first allocation. */
+    PRIVILEGED_DATA static uint8_t * pucIsrPoolStart = NULL;
+    PRIVILEGED_DATA static uint8_t * pucIsrPoolEnd = NULL;
+    PRIVILEGED_DATA static void * pvIsrFreeBlock = NULL;
+    PRIVILEGED_DATA static UBaseType_t uxIsrFreeBlocks = portHEAP_ISR_BLOCKS;
+    PRIVILEGED_DATA static UBaseType_t uxIsrMinimumEverFreeBlocks = portHEAP_ISR_BLOCKS;
+
+/* Blocks freed by vPortFreeFromISR() that still have to go back to the heap.
+ * ISRs push onto the list, the next pvPortMalloc() or vPortFree() of a task
+ * takes the whole list at once. */
+    PRIVILEGED_DATA static void * volatile pvPendingFrees = NULL;
+
+#endif /* portUSE_HEAP_ISR */
 
 /*-----------------------------------------------------------*/
 
@@ -151,6 +293,98 @@ static void prvInsertBlockIntoFreeList( BlockLink_t * pxBlockToInsert ) PRIVILEG
  */
 static void prvHeapInit( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * Returns an allocated block to the list of free blocks, called with the
+ * scheduler suspended.
+ */
+static void prvReturnBlock( BlockLink_t * pxLink ) PRIVILEGED_FUNCTION;
+
+/*
+ * Resizes the heap block of pv in place, by splitting off its tail or by
+ * absorbing the free blocks next to it.  Returns NULL if the neighbours are not
+ * large enough, with the number of bytes the block holds in pxCopySize.
+ */
+static void * prvReallocBlock( void * pv,
+                               size_t xWantedSize,
+                               size_t * pxCopySize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Makes a region of memory a free block followed by an end marker, and links
+ * both into the list of free blocks at their address.
+ */
+static void prvAddHeapRegion( void * pvRegion,
+                              size_t xRegionSize ) PRIVILEGED_FUNCTION;
+
+#if ( portUSE_HEAP_REGIONS == 1 )
+
+/*
+ * Returns the first free block of at least xWantedSize bytes in internal
+ * (xExternal is pdFALSE) or external memory, or pxEnd if there is none.
+ */
+    static BlockLink_t * prvFindFreeBlock( size_t xWantedSize,
+                                           BaseType_t xExternal,
+                                           BlockLink_t ** ppxPreviousBlock ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns the region pv lies in, or NULL if there are more regions than
+ * portHEAP_MAX_REGIONS.
+ */
+    static HeapRegionRecord_t * prvGetRegion( const void * pv ) PRIVILEGED_FUNCTION;
+
+#endif /* portUSE_HEAP_REGIONS */
+
+#if ( portUSE_HEAP_ISR == 1 )
+
+/*
+ * Links the blocks of the reserve for ISRs, called with the interrupts
+ * masked.
+ */
+    static void prvIsrPoolInit( void ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns a block to the reserve for ISRs.  Returns pdFALSE if pv is not in
+ * the reserve.
+ */
+    static BaseType_t prvIsrPoolFree( void * pv ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns the word a block freed by vPortFreeFromISR() is linked through.
+ */
+    static void ** prvPendingLink( void * pv ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns the blocks freed by vPortFreeFromISR() to the heap.
+ */
+    static void prvDrainPendingFrees( void ) PRIVILEGED_FUNCTION;
+
+#endif /* portUSE_HEAP_ISR */
+
+#if ( portUSE_HEAP_SLABS == 1 )
+
+/*
+ * Places the pools at uxStartAddress, called by prvHeapInit().  Returns the
+ * address behind them.
+ */
+    static portPOINTER_SIZE_TYPE prvSlabInit( portPOINTER_SIZE_TYPE uxStartAddress ) PRIVILEGED_FUNCTION;
+
+/*
+ * Takes an object from the smallest pool it fits in.  Returns NULL if it fits
+ * in none, or if that pool is exhausted.
+ */
+    static void * prvSlabMalloc( size_t xWantedSize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns an object to its pool.  Returns pdFALSE if pv is not in a pool.
+ */
+    static BaseType_t prvSlabFree( void * pv ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns the size of the pool object pv, or 0 if pv is not in a pool.
+ */
+    static size_t prvSlabObjectSize( const void * pv ) PRIVILEGED_FUNCTION;
+
+#endif /* portUSE_HEAP_SLABS */
+
 /*-----------------------------------------------------------*/
 
 /* The size of the structure placed at the beginning of each allocated memory
@@ -160,6 +394,7 @@ static const size_t xHeapStructSize = ( sizeof( BlockLink_t ) + ( ( size_t ) ( p
 /* Create a couple of list links to mark the start and end of the list. */
 PRIVILEGED_DATA static BlockLink_t xStart;
 PRIVILEGED_DATA static BlockLink_t * pxEnd = NULL;
+PRIVILEGED_DATA static uint8_t * pucHeapStart = NULL;
 
 /* Keeps track of the number of calls to allocate and free memory as well as the
  * number of free bytes remaining, but says nothing about fragmentation. */
@@ -170,7 +405,21 @@ PRIVILEGED_DATA static size_t xNumberOfSuccessfulFrees = ( size_t ) 0U;
 
 /*-----------------------------------------------------------*/
 
+#if ( portUSE_HEAP_REGIONS == 1 )
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    /* Large objects, like the storage of queues and stream buffers, go to
+     * external memory first, everything else to internal memory first. */
+    return pvPortMallocPlaced( xWantedSize, ( xWantedSize >= portHEAP_EXTERNAL_THRESHOLD ) ? portHEAP_PLACE_EXTERNAL_FIRST : portHEAP_PLACE_INTERNAL_FIRST );
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortMallocPlaced( size_t xWantedSize,
+                           UBaseType_t uxPlacement )
+#else
 void * pvPortMalloc( size_t xWantedSize )
+#endif /* portUSE_HEAP_REGIONS */
 {
     BlockLink_t * pxBlock;
     BlockLink_t * pxPreviousBlock;
@@ -178,6 +427,38 @@ void * pvPortMalloc( size_t xWantedSize )
     void * pvReturn = NULL;
     size_t xAdditionalRequiredSize;
 
+    #if ( portUSE_HEAP_REGIONS == 1 )
+        BaseType_t xExternal;
+        HeapRegionRecord_t * pxRegion;
+    #endif
+
+    #if ( portUSE_HEAP_ISR == 1 )
+    {
+        /* Blocks freed by ISRs since the last call go back to the heap
+         * first. */
+        prvDrainPendingFrees();
+    }
+    #endif
+
+    #if ( portUSE_HEAP_SLABS == 1 )
+    {
+        /* Objects that fit in a pool are taken from it, in constant time and
+         * without a BlockLink_t.  The heap is only used if the pool is
+         * exhausted.  The pools lie in ucHeap, which is internal memory. */
+        #if ( portUSE_HEAP_REGIONS == 1 )
+            if( uxPlacement != portHEAP_PLACE_EXTERNAL )
+        #endif
+        {
+            pvReturn = prvSlabMalloc( xWantedSize );
+        }
+
+        if( pvReturn != NULL )
+        {
+            return pvReturn;
+        }
+    }
+    #endif /* portUSE_HEAP_SLABS */
+
     if( xWantedSize > 0 )
     {
         /* The wanted size must be increased so it can contain a BlockLink_t
@@ -238,18 +519,35 @@ void * pvPortMalloc( size_t xWantedSize )
         {
             if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
             {
-                /* Traverse the list from the start (lowest address) block until
-                 * one of adequate size is found. */
-                pxPreviousBlock = &xStart;
-                pxBlock = heapPROTECT_BLOCK_POINTER( xStart.pxNextFreeBlock );
-                heapVALIDATE_BLOCK_POINTER( pxBlock );
+                #if ( portUSE_HEAP_REGIONS == 1 )
+                {
+                    /* Search the preferred kind of memory, then the other one
+                     * unless the placement is strict. */
+                    xExternal = ( ( uxPlacement == portHEAP_PLACE_EXTERNAL_FIRST ) || ( uxPlacement == portHEAP_PLACE_EXTERNAL ) ) ? pdTRUE : pdFALSE;
+                    pxBlock = prvFindFreeBlock( xWantedSize, xExternal, &pxPreviousBlock );
 
-                while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != heapPROTECT_BLOCK_POINTER( NULL ) ) )
+                    if( ( pxBlock == pxEnd ) &&
+                        ( ( uxPlacement == portHEAP_PLACE_INTERNAL_FIRST ) || ( uxPlacement == portHEAP_PLACE_EXTERNAL_FIRST ) ) )
+                    {
+                        pxBlock = prvFindFreeBlock( xWantedSize, ( xExternal == pdFALSE ) ? pdTRUE : pdFALSE, &pxPreviousBlock );
+                    }
+                }
+                #else /* if ( portUSE_HEAP_REGIONS == 1 ) */
                 {
-                    pxPreviousBlock = pxBlock;
-                    pxBlock = heapPROTECT_BLOCK_POINTER( pxBlock->pxNextFreeBlock );
+                    /* Traverse the list from the start (lowest address) block until
+                     * one of adequate size is found. */
+                    pxPreviousBlock = &xStart;
+                    pxBlock = heapPROTECT_BLOCK_POINTER( xStart.pxNextFreeBlock );
                     heapVALIDATE_BLOCK_POINTER( pxBlock );
+
+                    while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != heapPROTECT_BLOCK_POINTER( NULL ) ) )
+                    {
+                        pxPreviousBlock = pxBlock;
+                        pxBlock = heapPROTECT_BLOCK_POINTER( pxBlock->pxNextFreeBlock );
+                        heapVALIDATE_BLOCK_POINTER( pxBlock );
+                    }
                 }
+                #endif /* if ( portUSE_HEAP_REGIONS == 1 ) */
 
                 /* If the end marker was reached then a block of adequate size
                  * was not found. */
@@ -302,6 +600,24 @@ void * pvPortMalloc( size_t xWantedSize )
                         mtCOVERAGE_TEST_MARKER();
                     }
 
+                    #if ( portUSE_HEAP_REGIONS == 1 )
+                    {
+                        pxRegion = prvGetRegion( pxBlock );
+
+                        if( pxRegion != NULL )
+                        {
+                            pxRegion->xFreeBytes -= pxBlock->xBlockSize;
+
+                            if( pxRegion->xFreeBytes < pxRegion->xMinimumEverFreeBytes )
+                            {
+                                pxRegion->xMinimumEverFreeBytes = pxRegion->xFreeBytes;
+                            }
+
+                            pxRegion->xAllocations++;
+                        }
+                    }
+                    #endif /* portUSE_HEAP_REGIONS */
+
                     /* The block is being returned - it is allocated and owned
                      * by the application and has no "next" block. */
                     heapALLOCATE_BLOCK( pxBlock );
@@ -350,6 +666,26 @@ void vPortFree( void * pv )
     uint8_t * puc = ( uint8_t * ) pv;
     BlockLink_t * pxLink;
 
+    #if ( portUSE_HEAP_ISR == 1 )
+    {
+        prvDrainPendingFrees();
+
+        if( prvIsrPoolFree( pv ) != pdFALSE )
+        {
+            return;
+        }
+    }
+    #endif /* portUSE_HEAP_ISR */
+
+    #if ( portUSE_HEAP_SLABS == 1 )
+    {
+        if( prvSlabFree( pv ) != pdFALSE )
+        {
+            return;
+        }
+    }
+    #endif /* portUSE_HEAP_SLABS */
+
     if( pv != NULL )
     {
         /* The memory being freed will have an BlockLink_t structure immediately
@@ -383,11 +719,7 @@ void vPortFree( void * pv )
 
                 vTaskSuspendAll();
                 {
-                    /* Add this block to the list of free blocks. */
-                    xFreeBytesRemaining += pxLink->xBlockSize;
-                    traceFREE( pv, pxLink->xBlockSize );
-                    prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
-                    xNumberOfSuccessfulFrees++;
+                    prvReturnBlock( pxLink );
                 }
                 ( void ) xTaskResumeAll();
             }
@@ -404,6 +736,230 @@ void vPortFree( void * pv )
 }
 /*-----------------------------------------------------------*/
 
+static void prvReturnBlock( BlockLink_t * pxLink ) /* PRIVILEGED_FUNCTION */
+{
+    #if ( portUSE_HEAP_REGIONS == 1 )
+    {
+        HeapRegionRecord_t * pxRegion = prvGetRegion( pxLink );
+
+        if( pxRegion != NULL )
+        {
+            pxRegion->xFreeBytes += pxLink->xBlockSize;
+            pxRegion->xFrees++;
+        }
+    }
+    #endif /* portUSE_HEAP_REGIONS */
+
+    /* Add this block to the list of free blocks. */
+    xFreeBytesRemaining += pxLink->xBlockSize;
+    traceFREE( ( ( uint8_t * ) pxLink ) + xHeapStructSize, pxLink->xBlockSize );
+    prvInsertBlockIntoFreeList( pxLink );
+    xNumberOfSuccessfulFrees++;
+}
+/*-----------------------------------------------------------*/
+
+#if ( portUSE_HEAP_ISR == 1 )
+
+    static void prvIsrPoolInit( void ) /* PRIVILEGED_FUNCTION */
+    {
+        portPOINTER_SIZE_TYPE uxAddress;
+        uint8_t * pucBlock;
+        UBaseType_t x;
+
+        uxAddress = ( portPOINTER_SIZE_TYPE ) ucIsrPool;
+        uxAddress += portBYTE_ALIGNMENT_MASK;
+        uxAddress &= ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK );
+
+        pucIsrPoolStart = ( uint8_t * ) uxAddress;
+        pucIsrPoolEnd = pucIsrPoolStart + ( portHEAP_ISR_BLOCKS * heapISR_BLOCK_SIZE );
+
+        /* Link the blocks through their first bytes, the lowest first. */
+        pvIsrFreeBlock = NULL;
+
+        for( x = portHEAP_ISR_BLOCKS; x > 0; x-- )
+        {
+            pucBlock = pucIsrPoolStart + ( ( size_t ) ( x - 1 ) * heapISR_BLOCK_SIZE );
+            *( ( void ** ) pucBlock ) = pvIsrFreeBlock;
+            pvIsrFreeBlock = pucBlock;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    void * pvPortMallocFromISR( size_t xWantedSize )
+    {
+        void * pvReturn = NULL;
+
+        if( ( xWantedSize > 0 ) && ( xWantedSize <= heapISR_BLOCK_SIZE ) )
+        {
+            /* Popping a block is not safe with a compare and swap, as the
+             * block could be taken and returned again in between, so the
+             * interrupts are masked for these few instructions. */
+            ATOMIC_ENTER_CRITICAL();
+            {
+                if( pucIsrPoolStart == NULL )
+                {
+                    prvIsrPoolInit();
+                }
+
+                pvReturn = pvIsrFreeBlock;
+
+                if( pvReturn != NULL )
+                {
+                    pvIsrFreeBlock = *( ( void ** ) pvReturn );
+                    uxIsrFreeBlocks--;
+
+                    if( uxIsrFreeBlocks < uxIsrMinimumEverFreeBlocks )
+                    {
+                        uxIsrMinimumEverFreeBlocks = uxIsrFreeBlocks;
+                    }
+                }
+            }
+            ATOMIC_EXIT_CRITICAL();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return pvReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvIsrPoolFree( void * pv ) /* PRIVILEGED_FUNCTION */
+    {
+        BaseType_t xReturn = pdFALSE;
+
+        /* The reserve is set up before its first block is handed out. */
+        if( ( pucIsrPoolStart != NULL ) && ( ( uint8_t * ) pv >= pucIsrPoolStart ) && ( ( uint8_t * ) pv < pucIsrPoolEnd ) )
+        {
+            configASSERT( ( ( size_t ) ( ( uint8_t * ) pv - pucIsrPoolStart ) % heapISR_BLOCK_SIZE ) == 0 );
+
+            ATOMIC_ENTER_CRITICAL();
+            {
+                *( ( void ** ) pv ) = pvIsrFreeBlock;
+                pvIsrFreeBlock = pv;
+                uxIsrFreeBlocks++;
+            }
+            ATOMIC_EXIT_CRITICAL();
+
+            xReturn = pdTRUE;
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static void ** prvPendingLink( void * pv ) /* PRIVILEGED_FUNCTION */
+    {
+        BlockLink_t * pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+        void ** ppvLink = ( void ** ) &( pxLink->pxNextFreeBlock );
+
+        #if ( portUSE_HEAP_SLABS == 1 )
+        {
+            /* The objects of the pools have no BlockLink_t. */
+            if( ( ( uint8_t * ) pv >= pucSlabsStart ) && ( ( uint8_t * ) pv < pucSlabsEnd ) )
+            {
+                ppvLink = ( void ** ) pv;
+            }
+        }
+        #endif
+
+        return ppvLink;
+    }
+/*-----------------------------------------------------------*/
+
+    void vPortFreeFromISR( void * pv )
+    {
+        void ** ppvLink;
+        void * pvHead;
+
+        if( pv != NULL )
+        {
+            if( prvIsrPoolFree( pv ) == pdFALSE )
+            {
+                ppvLink = prvPendingLink( pv );
+
+                #if ( portUSE_HEAP_SLABS == 1 )
+                    if( ( void * ) ppvLink != pv )
+                #endif
+                {
+                    heapVALIDATE_BLOCK_POINTER( ppvLink );
+                    configASSERT( heapBLOCK_IS_ALLOCATED( ( ( BlockLink_t * ) ppvLink ) ) != 0 );
+                    configASSERT( *ppvLink == NULL );
+                }
+
+                /* Push the block onto the pending list. */
+                do
+                {
+                    pvHead = pvPendingFrees;
+                    *ppvLink = pvHead;
+                } while( Atomic_CompareAndSwapPointers_p32( &pvPendingFrees, pv, pvHead ) != ATOMIC_COMPARE_AND_SWAP_SUCCESS );
+            }
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvDrainPendingFrees( void ) /* PRIVILEGED_FUNCTION */
+    {
+        void * pv;
+        void * pvNext;
+        void ** ppvLink;
+        BlockLink_t * pxLink;
+
+        /* A torn read of the head on an 8 bit MCU only delays the drain to the
+         * next call. */
+        if( pvPendingFrees != NULL )
+        {
+            /* Take the whole list at once, so a block can not be taken by
+             * the drain and pushed again by an ISR in between. */
+            pv = Atomic_SwapPointers_p32( &pvPendingFrees, NULL );
+
+            vTaskSuspendAll();
+            {
+                while( pv != NULL )
+                {
+                    ppvLink = prvPendingLink( pv );
+                    pvNext = *ppvLink;
+                    *ppvLink = NULL;
+
+                    #if ( portUSE_HEAP_SLABS == 1 )
+                        if( prvSlabFree( pv ) == pdFALSE )
+                    #endif
+                    {
+                        pxLink = ( BlockLink_t * ) ppvLink;
+                        heapFREE_BLOCK( pxLink );
+
+                        #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
+                        {
+                            ( void ) memset( pv, 0, pxLink->xBlockSize - xHeapStructSize );
+                        }
+                        #endif
+
+                        prvReturnBlock( pxLink );
+                    }
+
+                    pv = pvNext;
+                }
+            }
+            ( void ) xTaskResumeAll();
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    UBaseType_t uxPortGetIsrPoolFreeBlocks( void )
+    {
+        return uxIsrFreeBlocks;
+    }
+/*-----------------------------------------------------------*/
+
+    UBaseType_t uxPortGetIsrPoolMinimumEverFreeBlocks( void )
+    {
+        return uxIsrMinimumEverFreeBlocks;
+    }
+
+#endif /* portUSE_HEAP_ISR */
+/*-----------------------------------------------------------*/
+
 size_t xPortGetFreeHeapSize( void )
 {
     return xFreeBytesRemaining;
@@ -441,21 +997,396 @@ void * pvPortCalloc( size_t xNum,
 }
 /*-----------------------------------------------------------*/
 
-static void prvHeapInit( void ) /* PRIVILEGED_FUNCTION */
+void * pvPortRealloc( void * pv,
+                      size_t xWantedSize )
 {
-    BlockLink_t * pxFirstFreeBlock;
-    portPOINTER_SIZE_TYPE uxStartAddress, uxEndAddress;
-    size_t xTotalHeapSize = configTOTAL_HEAP_SIZE;
-
-    /* Ensure the heap starts on a correctly aligned boundary. */
-    uxStartAddress = ( portPOINTER_SIZE_TYPE ) ucHeap;
+    void * pvReturn = NULL;
+    size_t xCopySize = 0;
+    size_t xFixedSize = 0;
 
-    if( ( uxStartAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+    if( pv == NULL )
     {
-        uxStartAddress += ( portBYTE_ALIGNMENT - 1 );
-        uxStartAddress &= ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK );
-        xTotalHeapSize -= ( size_t ) ( uxStartAddress - ( portPOINTER_SIZE_TYPE ) ucHeap );
+        pvReturn = pvPortMalloc( xWantedSize );
     }
+    else if( xWantedSize == 0 )
+    {
+        vPortFree( pv );
+    }
+    else
+    {
+        #if ( portUSE_HEAP_ISR == 1 )
+        {
+            /* Blocks freed by ISRs may be the neighbours to absorb. */
+            prvDrainPendingFrees();
+
+            if( ( pucIsrPoolStart != NULL ) && ( ( uint8_t * ) pv >= pucIsrPoolStart ) && ( ( uint8_t * ) pv < pucIsrPoolEnd ) )
+            {
+                xFixedSize = heapISR_BLOCK_SIZE;
+            }
+        }
+        #endif /* portUSE_HEAP_ISR */
+
+        #if ( portUSE_HEAP_SLABS == 1 )
+        {
+            if( xFixedSize == 0 )
+            {
+                xFixedSize = prvSlabObjectSize( pv );
+            }
+        }
+        #endif /* portUSE_HEAP_SLABS */
+
+        if( xFixedSize != 0 )
+        {
+            /* Blocks of the reserve and pool objects keep their size, they are
+             * only moved if they are too small. */
+            xCopySize = xFixedSize;
+
+            if( xWantedSize <= xFixedSize )
+            {
+                pvReturn = pv;
+            }
+        }
+        else
+        {
+            pvReturn = prvReallocBlock( pv, xWantedSize, &xCopySize );
+        }
+
+        if( pvReturn == NULL )
+        {
+            /* There is no room next to the block, so it has to be moved. */
+            pvReturn = pvPortMalloc( xWantedSize );
+
+            if( pvReturn != NULL )
+            {
+                ( void ) memcpy( pvReturn, pv, ( xCopySize < xWantedSize ) ? xCopySize : xWantedSize );
+                vPortFree( pv );
+            }
+        }
+    }
+
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void * prvReallocBlock( void * pv,
+                               size_t xWantedSize,
+                               size_t * pxCopySize ) /* PRIVILEGED_FUNCTION */
+{
+    BlockLink_t * pxLink = ( void * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+    BlockLink_t * pxBeforeIterator = NULL;
+    BlockLink_t * pxIterator;
+    BlockLink_t * pxNextBlock;
+    BlockLink_t * pxNewBlockLink;
+    size_t xBlockSize;
+    size_t xPreviousSize = 0;
+    size_t xNextSize = 0;
+    size_t xCombinedSize;
+    void * pvReturn = NULL;
+
+    heapVALIDATE_BLOCK_POINTER( pxLink );
+    configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
+    configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+    /* The size of the block with its BlockLink_t, rounded up like in
+     * pvPortMalloc(). */
+    if( heapADD_WILL_OVERFLOW( xWantedSize, xHeapStructSize + portBYTE_ALIGNMENT_MASK ) == 0 )
+    {
+        xWantedSize += xHeapStructSize + portBYTE_ALIGNMENT_MASK;
+        xWantedSize &= ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+    }
+    else
+    {
+        xWantedSize = 0;
+    }
+
+    vTaskSuspendAll();
+    {
+        xBlockSize = pxLink->xBlockSize & ~heapBLOCK_ALLOCATED_BITMASK;
+        *pxCopySize = xBlockSize - xHeapStructSize;
+
+        if( ( xWantedSize > 0 ) && ( heapBLOCK_SIZE_IS_VALID( xWantedSize ) != 0 ) )
+        {
+            /* Find the free blocks in front of and behind the block. */
+            for( pxIterator = &xStart; heapPROTECT_BLOCK_POINTER( pxIterator->pxNextFreeBlock ) < pxLink; pxIterator = heapPROTECT_BLOCK_POINTER( pxIterator->pxNextFreeBlock ) )
+            {
+                pxBeforeIterator = pxIterator;
+            }
+
+            pxNextBlock = heapPROTECT_BLOCK_POINTER( pxIterator->pxNextFreeBlock );
+
+            /* End markers have a size of 0, so they are never absorbed. */
+            if( ( ( ( uint8_t * ) pxLink ) + xBlockSize ) == ( uint8_t * ) pxNextBlock )
+            {
+                xNextSize = pxNextBlock->xBlockSize;
+            }
+
+            if( ( pxIterator != &xStart ) && ( ( ( ( uint8_t * ) pxIterator ) + pxIterator->xBlockSize ) == ( uint8_t * ) pxLink ) )
+            {
+                xPreviousSize = pxIterator->xBlockSize;
+            }
+
+            if( xWantedSize <= xBlockSize )
+            {
+                /* Shrink, the tail is split off below. */
+                pvReturn = pv;
+                xCombinedSize = xBlockSize;
+            }
+            else if( ( xWantedSize - xBlockSize ) <= xNextSize )
+            {
+                /* Grow into the free block behind. */
+                pxIterator->pxNextFreeBlock = pxNextBlock->pxNextFreeBlock;
+                pvReturn = pv;
+                xCombinedSize = xBlockSize + xNextSize;
+            }
+            else if( ( xPreviousSize > 0 ) && ( ( xWantedSize - xBlockSize ) <= ( xPreviousSize + xNextSize ) ) )
+            {
+                /* Grow into the free block in front, and the one behind if
+                 * needed, and move the data down. */
+                if( xNextSize > 0 )
+                {
+                    pxBeforeIterator->pxNextFreeBlock = pxNextBlock->pxNextFreeBlock;
+                }
+                else
+                {
+                    pxBeforeIterator->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
+                }
+
+                pxLink = pxIterator;
+                pvReturn = ( void * ) ( ( ( uint8_t * ) pxLink ) + xHeapStructSize );
+                ( void ) memmove( pvReturn, pv, *pxCopySize );
+                xCombinedSize = xPreviousSize + xBlockSize + xNextSize;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( pvReturn != NULL )
+            {
+                pxLink->xBlockSize = xCombinedSize;
+
+                /* Return the tail to the list of free blocks if it is large
+                 * enough to be a block. */
+                if( ( xCombinedSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+                {
+                    pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxLink ) + xWantedSize );
+                    configASSERT( ( ( ( size_t ) pxNewBlockLink ) & portBYTE_ALIGNMENT_MASK ) == 0 );
+
+                    pxNewBlockLink->xBlockSize = xCombinedSize - xWantedSize;
+                    pxLink->xBlockSize = xWantedSize;
+
+                    #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
+                    {
+                        ( void ) memset( ( ( uint8_t * ) pxNewBlockLink ) + xHeapStructSize, 0, pxNewBlockLink->xBlockSize - xHeapStructSize );
+                    }
+                    #endif
+
+                    prvInsertBlockIntoFreeList( pxNewBlockLink );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                /* Account for the difference to the old size, which may be
+                 * positive or negative. */
+                xFreeBytesRemaining = ( xFreeBytesRemaining + xBlockSize ) - pxLink->xBlockSize;
+
+                if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+                {
+                    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                #if ( portUSE_HEAP_REGIONS == 1 )
+                {
+                    /* Neighbours are always in the same region. */
+                    HeapRegionRecord_t * pxRegion = prvGetRegion( pxLink );
+
+                    if( pxRegion != NULL )
+                    {
+                        pxRegion->xFreeBytes = ( pxRegion->xFreeBytes + xBlockSize ) - pxLink->xBlockSize;
+
+                        if( pxRegion->xFreeBytes < pxRegion->xMinimumEverFreeBytes )
+                        {
+                            pxRegion->xMinimumEverFreeBytes = pxRegion->xFreeBytes;
+                        }
+                    }
+                }
+                #endif /* portUSE_HEAP_REGIONS */
+
+                traceFREE( pv, xBlockSize );
+                traceMALLOC( pvReturn, pxLink->xBlockSize );
+
+                heapALLOCATE_BLOCK( pxLink );
+                pxLink->pxNextFreeBlock = NULL;
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortAddHeapRegion( void * pvRegion,
+                         size_t xRegionSize ) /* PRIVILEGED_FUNCTION */
+{
+    vTaskSuspendAll();
+    {
+        if( pxEnd == NULL )
+        {
+            prvHeapInit();
+        }
+
+        prvAddHeapRegion( pvRegion, xRegionSize );
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+#if ( portUSE_HEAP_REGIONS == 1 )
+
+    void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions ) /* PRIVILEGED_FUNCTION */
+    {
+        const HeapRegion_t * pxHeapRegion;
+
+        /* Unlike heap_5.c the table adds to ucHeap, and can be given at any
+         * time and in any order. */
+        for( pxHeapRegion = pxHeapRegions; pxHeapRegion->xSizeInBytes > 0; pxHeapRegion++ )
+        {
+            vPortAddHeapRegion( pxHeapRegion->pucStartAddress, pxHeapRegion->xSizeInBytes );
+        }
+    }
+
+#endif /* portUSE_HEAP_REGIONS */
+/*-----------------------------------------------------------*/
+
+static void prvAddHeapRegion( void * pvRegion,
+                              size_t xRegionSize ) /* PRIVILEGED_FUNCTION */
+{
+    BlockLink_t * pxFirstFreeBlock;
+    BlockLink_t * pxNewEnd;
+    BlockLink_t * pxIterator;
+    portPOINTER_SIZE_TYPE uxStartAddress, uxEndAddress;
+
+    /* Ensure the region starts on a correctly aligned boundary. */
+    uxStartAddress = ( portPOINTER_SIZE_TYPE ) pvRegion;
+    uxEndAddress = uxStartAddress + ( portPOINTER_SIZE_TYPE ) xRegionSize;
+
+    if( ( uxStartAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+    {
+        uxStartAddress += ( portBYTE_ALIGNMENT - 1 );
+        uxStartAddress &= ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK );
+    }
+
+    /* The new end marker is placed at the end of the region. */
+    uxEndAddress -= ( portPOINTER_SIZE_TYPE ) xHeapStructSize;
+    uxEndAddress &= ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK );
+
+    if( ( uxEndAddress > uxStartAddress ) &&
+        ( ( size_t ) ( uxEndAddress - uxStartAddress ) >= heapMINIMUM_BLOCK_SIZE ) )
+    {
+        pxNewEnd = ( BlockLink_t * ) uxEndAddress;
+        pxNewEnd->xBlockSize = 0;
+
+        pxFirstFreeBlock = ( BlockLink_t * ) uxStartAddress;
+        pxFirstFreeBlock->xBlockSize = ( size_t ) ( uxEndAddress - uxStartAddress );
+        pxFirstFreeBlock->pxNextFreeBlock = heapPROTECT_BLOCK_POINTER( pxNewEnd );
+
+        if( uxStartAddress > ( portPOINTER_SIZE_TYPE ) pxEnd )
+        {
+            /* The old end marker stays in the list as a zero sized block that
+             * links the previous region to the new one, as done by heap_5. */
+            pxNewEnd->pxNextFreeBlock = heapPROTECT_BLOCK_POINTER( NULL );
+            pxEnd->pxNextFreeBlock = heapPROTECT_BLOCK_POINTER( pxFirstFreeBlock );
+            pxEnd = pxNewEnd;
+        }
+        else
+        {
+            /* The region lies in front of the end of the heap, so it is linked
+             * in at its address, e.g. the stack of main() in front of external
+             * memory.  The end marker then links to the region behind it. */
+            for( pxIterator = &xStart; heapPROTECT_BLOCK_POINTER( pxIterator->pxNextFreeBlock ) < pxFirstFreeBlock; pxIterator = heapPROTECT_BLOCK_POINTER( pxIterator->pxNextFreeBlock ) )
+            {
+                /* Nothing to do here, just iterate to the right position. */
+            }
+
+            /* The region must not overlap the heap. */
+            configASSERT( heapPROTECT_BLOCK_POINTER( pxIterator->pxNextFreeBlock ) > pxNewEnd );
+
+            pxNewEnd->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
+            pxIterator->pxNextFreeBlock = heapPROTECT_BLOCK_POINTER( pxFirstFreeBlock );
+
+            if( ( uint8_t * ) pxFirstFreeBlock < pucHeapStart )
+            {
+                pucHeapStart = ( uint8_t * ) pxFirstFreeBlock;
+            }
+        }
+
+        xFreeBytesRemaining += pxFirstFreeBlock->xBlockSize;
+        xMinimumEverFreeBytesRemaining += pxFirstFreeBlock->xBlockSize;
+
+        #if ( portUSE_HEAP_REGIONS == 1 )
+        {
+            configASSERT( uxRegions < portHEAP_MAX_REGIONS );
+
+            if( uxRegions < portHEAP_MAX_REGIONS )
+            {
+                xRegions[ uxRegions ].pucStart = ( uint8_t * ) pxFirstFreeBlock;
+                xRegions[ uxRegions ].pucEnd = ( uint8_t * ) pxNewEnd;
+                xRegions[ uxRegions ].xFreeBytes = pxFirstFreeBlock->xBlockSize;
+                xRegions[ uxRegions ].xMinimumEverFreeBytes = pxFirstFreeBlock->xBlockSize;
+                xRegions[ uxRegions ].xAllocations = 0;
+                xRegions[ uxRegions ].xFrees = 0;
+                uxRegions++;
+            }
+        }
+        #endif /* portUSE_HEAP_REGIONS */
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void ) /* PRIVILEGED_FUNCTION */
+{
+    BlockLink_t * pxFirstFreeBlock;
+    portPOINTER_SIZE_TYPE uxStartAddress, uxEndAddress;
+    size_t xTotalHeapSize = configTOTAL_HEAP_SIZE;
+
+    /* Ensure the heap starts on a correctly aligned boundary. */
+    uxStartAddress = ( portPOINTER_SIZE_TYPE ) ucHeap;
+
+    if( ( uxStartAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+    {
+        uxStartAddress += ( portBYTE_ALIGNMENT - 1 );
+        uxStartAddress &= ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK );
+        xTotalHeapSize -= ( size_t ) ( uxStartAddress - ( portPOINTER_SIZE_TYPE ) ucHeap );
+    }
+
+    pucHeapStart = ( uint8_t * ) uxStartAddress;
+
+    #if ( portUSE_HEAP_SLABS == 1 )
+    {
+        /* The pools are taken from the start of the heap, the free blocks
+         * follow them. */
+        portPOINTER_SIZE_TYPE uxSlabsEnd = prvSlabInit( uxStartAddress );
+
+        configASSERT( ( size_t ) ( uxSlabsEnd - uxStartAddress ) < xTotalHeapSize );
+        xTotalHeapSize -= ( size_t ) ( uxSlabsEnd - uxStartAddress );
+        uxStartAddress = uxSlabsEnd;
+    }
+    #endif /* portUSE_HEAP_SLABS */
 
     #if ( configENABLE_HEAP_PROTECTOR == 1 )
     {
@@ -486,6 +1417,27 @@ static void prvHeapInit( void ) /* PRIVILEGED_FUNCTION */
     /* Only one block exists - and it covers the entire usable heap space. */
     xMinimumEverFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
     xFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+
+    #if ( portUSE_HEAP_REGIONS == 1 )
+    {
+        static const HeapRegion_t xHeapRegions[] = portHEAP_REGIONS;
+        const HeapRegion_t * pxHeapRegion;
+
+        /* ucHeap is the first region, followed by those of portHEAP_REGIONS. */
+        xRegions[ 0 ].pucStart = ( uint8_t * ) pxFirstFreeBlock;
+        xRegions[ 0 ].pucEnd = ( uint8_t * ) pxEnd;
+        xRegions[ 0 ].xFreeBytes = pxFirstFreeBlock->xBlockSize;
+        xRegions[ 0 ].xMinimumEverFreeBytes = pxFirstFreeBlock->xBlockSize;
+        xRegions[ 0 ].xAllocations = 0;
+        xRegions[ 0 ].xFrees = 0;
+        uxRegions = 1;
+
+        for( pxHeapRegion = xHeapRegions; pxHeapRegion->xSizeInBytes > 0; pxHeapRegion++ )
+        {
+            prvAddHeapRegion( pxHeapRegion->pucStartAddress, pxHeapRegion->xSizeInBytes );
+        }
+    }
+    #endif /* portUSE_HEAP_REGIONS */
 }
 /*-----------------------------------------------------------*/
 
@@ -557,6 +1509,365 @@ static void prvInsertBlockIntoFreeList( BlockLink_t * pxBlockToInsert ) /* PRIVI
 }
 /*-----------------------------------------------------------*/
 
+#if ( portUSE_HEAP_SLABS == 1 )
+
+    static portPOINTER_SIZE_TYPE prvSlabInit( portPOINTER_SIZE_TYPE uxStartAddress ) /* PRIVILEGED_FUNCTION */
+    {
+        HeapSlab_t * pxSlab;
+        uint8_t * pucObject;
+        size_t xClass, xPool, xObjectSize, xObject;
+
+        configASSERT( ( sizeof( xSlabCounts ) / sizeof( xSlabCounts[ 0 ] ) ) == heapSLAB_CLASSES );
+
+        /* One pool per object size. Classes of the same size, such as
+         * StaticQueue_t and StaticTask_t on some ports, share a pool, as
+         * prvSlabMalloc() would only ever use the first one. */
+        xSlabClasses = 0;
+
+        for( xClass = 0; xClass < heapSLAB_CLASSES; xClass++ )
+        {
+            /* Each object must be able to hold the link while it is free, and
+             * keep the next object aligned. */
+            xObjectSize = ( xSlabSizes[ xClass ] < sizeof( void * ) ) ? sizeof( void * ) : xSlabSizes[ xClass ];
+            xObjectSize = ( xObjectSize + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+            for( xPool = 0; xPool < xSlabClasses; xPool++ )
+            {
+                if( xSlabs[ xPool ].xObjectSize == xObjectSize )
+                {
+                    break;
+                }
+            }
+
+            pxSlab = &( xSlabs[ xPool ] );
+
+            if( xPool == xSlabClasses )
+            {
+                pxSlab->xObjectSize = xObjectSize;
+                pxSlab->xObjects = 0;
+                xSlabClasses++;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            pxSlab->xObjects += xSlabCounts[ xClass ];
+        }
+
+        pucSlabsStart = ( uint8_t * ) uxStartAddress;
+        pucObject = pucSlabsStart;
+
+        for( xPool = 0; xPool < xSlabClasses; xPool++ )
+        {
+            pxSlab = &( xSlabs[ xPool ] );
+
+            pxSlab->xFreeObjects = pxSlab->xObjects;
+            pxSlab->xMinimumEverFreeObjects = pxSlab->xObjects;
+            pxSlab->xAllocations = 0;
+            pxSlab->xFallbacks = 0;
+            pxSlab->pucStart = pucObject;
+            pxSlab->pvFreeObject = NULL;
+
+            /* Link the objects back to front, so the first one is taken
+             * first. */
+            pucObject += pxSlab->xObjects * pxSlab->xObjectSize;
+            pxSlab->pucEnd = pucObject;
+
+            for( xObject = pxSlab->xObjects; xObject > 0; xObject-- )
+            {
+                void ** ppvObject = ( void ** ) ( pxSlab->pucStart + ( ( xObject - 1 ) * pxSlab->xObjectSize ) );
+
+                *ppvObject = pxSlab->pvFreeObject;
+                pxSlab->pvFreeObject = ( void * ) ppvObject;
+            }
+        }
+
+        pucSlabsEnd = pucObject;
+
+        return ( portPOINTER_SIZE_TYPE ) pucSlabsEnd;
+    }
+/*-----------------------------------------------------------*/
+
+    static void * prvSlabMalloc( size_t xWantedSize ) /* PRIVILEGED_FUNCTION */
+    {
+        HeapSlab_t * pxSlab = NULL;
+        void * pvReturn = NULL;
+        size_t xClass;
+
+        if( xWantedSize > 0 )
+        {
+            vTaskSuspendAll();
+            {
+                if( pxEnd == NULL )
+                {
+                    prvHeapInit();
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                /* The classes are few, so the best fit is searched instead of
+                 * requiring them to be sorted. */
+                for( xClass = 0; xClass < xSlabClasses; xClass++ )
+                {
+                    if( ( xSlabs[ xClass ].xObjectSize >= xWantedSize ) &&
+                        ( ( pxSlab == NULL ) || ( xSlabs[ xClass ].xObjectSize < pxSlab->xObjectSize ) ) )
+                    {
+                        pxSlab = &( xSlabs[ xClass ] );
+                    }
+                }
+
+                if( pxSlab != NULL )
+                {
+                    if( pxSlab->pvFreeObject != NULL )
+                    {
+                        pvReturn = pxSlab->pvFreeObject;
+                        pxSlab->pvFreeObject = *( ( void ** ) pvReturn );
+                        pxSlab->xFreeObjects--;
+                        pxSlab->xAllocations++;
+
+                        if( pxSlab->xFreeObjects < pxSlab->xMinimumEverFreeObjects )
+                        {
+                            pxSlab->xMinimumEverFreeObjects = pxSlab->xFreeObjects;
+                        }
+
+                        xNumberOfSuccessfulAllocations++;
+                        traceMALLOC( pvReturn, pxSlab->xObjectSize );
+                    }
+                    else
+                    {
+                        pxSlab->xFallbacks++;
+                    }
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            ( void ) xTaskResumeAll();
+        }
+
+        return pvReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static size_t prvSlabObjectSize( const void * pv ) /* PRIVILEGED_FUNCTION */
+    {
+        const uint8_t * puc = ( const uint8_t * ) pv;
+        size_t xClass;
+        size_t xReturn = 0;
+
+        if( ( puc >= pucSlabsStart ) && ( puc < pucSlabsEnd ) )
+        {
+            for( xClass = 0; xClass < xSlabClasses; xClass++ )
+            {
+                if( puc < xSlabs[ xClass ].pucEnd )
+                {
+                    xReturn = xSlabs[ xClass ].xObjectSize;
+                    break;
+                }
+            }
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvSlabFree( void * pv ) /* PRIVILEGED_FUNCTION */
+    {
+        uint8_t * puc = ( uint8_t * ) pv;
+        HeapSlab_t * pxSlab = NULL;
+        size_t xClass;
+
+        /* A single range check tells the objects of the pools from the blocks
+         * of the heap. */
+        if( ( puc < pucSlabsStart ) || ( puc >= pucSlabsEnd ) )
+        {
+            return pdFALSE;
+        }
+
+        for( xClass = 0; xClass < xSlabClasses; xClass++ )
+        {
+            if( puc < xSlabs[ xClass ].pucEnd )
+            {
+                pxSlab = &( xSlabs[ xClass ] );
+                break;
+            }
+        }
+
+        configASSERT( pxSlab != NULL );
+        configASSERT( ( ( size_t ) ( puc - pxSlab->pucStart ) % pxSlab->xObjectSize ) == 0 );
+
+        #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
+        {
+            ( void ) memset( pv, 0, pxSlab->xObjectSize );
+        }
+        #endif
+
+        vTaskSuspendAll();
+        {
+            *( ( void ** ) pv ) = pxSlab->pvFreeObject;
+            pxSlab->pvFreeObject = pv;
+            pxSlab->xFreeObjects++;
+            traceFREE( pv, pxSlab->xObjectSize );
+            xNumberOfSuccessfulFrees++;
+        }
+        ( void ) xTaskResumeAll();
+
+        return pdTRUE;
+    }
+/*-----------------------------------------------------------*/
+
+    UBaseType_t uxPortGetSlabStats( SlabStats_t * pxSlabStats,
+                                    UBaseType_t uxMaxClasses )
+    {
+        UBaseType_t uxClass;
+
+        vTaskSuspendAll();
+        {
+            if( pxEnd == NULL )
+            {
+                prvHeapInit();
+            }
+
+            for( uxClass = 0; ( uxClass < uxMaxClasses ) && ( uxClass < ( UBaseType_t ) xSlabClasses ); uxClass++ )
+            {
+                pxSlabStats[ uxClass ].xObjectSize = xSlabs[ uxClass ].xObjectSize;
+                pxSlabStats[ uxClass ].xNumberOfObjects = xSlabs[ uxClass ].xObjects;
+                pxSlabStats[ uxClass ].xNumberOfFreeObjects = xSlabs[ uxClass ].xFreeObjects;
+                pxSlabStats[ uxClass ].xMinimumEverFreeObjects = xSlabs[ uxClass ].xMinimumEverFreeObjects;
+                pxSlabStats[ uxClass ].xNumberOfSuccessfulAllocations = xSlabs[ uxClass ].xAllocations;
+                pxSlabStats[ uxClass ].xNumberOfFallbacks = xSlabs[ uxClass ].xFallbacks;
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        return uxClass;
+    }
+
+#endif /* portUSE_HEAP_SLABS */
+/*-----------------------------------------------------------*/
+
+#if ( portUSE_HEAP_REGIONS == 1 )
+
+    static BlockLink_t * prvFindFreeBlock( size_t xWantedSize,
+                                           BaseType_t xExternal,
+                                           BlockLink_t ** ppxPreviousBlock ) /* PRIVILEGED_FUNCTION */
+    {
+        BlockLink_t * pxPreviousBlock = &xStart;
+        BlockLink_t * pxBlock = heapPROTECT_BLOCK_POINTER( xStart.pxNextFreeBlock );
+
+        heapVALIDATE_BLOCK_POINTER( pxBlock );
+
+        while( pxBlock != pxEnd )
+        {
+            if( heapIS_EXTERNAL( pxBlock ) == xExternal )
+            {
+                if( pxBlock->xBlockSize >= xWantedSize )
+                {
+                    break;
+                }
+            }
+            else if( xExternal == pdFALSE )
+            {
+                /* The list is sorted by address, so no internal block
+                 * follows the first external one. */
+                pxBlock = pxEnd;
+                break;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            pxPreviousBlock = pxBlock;
+            pxBlock = heapPROTECT_BLOCK_POINTER( pxBlock->pxNextFreeBlock );
+            heapVALIDATE_BLOCK_POINTER( pxBlock );
+        }
+
+        *ppxPreviousBlock = pxPreviousBlock;
+
+        return pxBlock;
+    }
+/*-----------------------------------------------------------*/
+
+    static HeapRegionRecord_t * prvGetRegion( const void * pv ) /* PRIVILEGED_FUNCTION */
+    {
+        HeapRegionRecord_t * pxRegion = NULL;
+        UBaseType_t x;
+
+        for( x = 0; x < uxRegions; x++ )
+        {
+            if( ( ( const uint8_t * ) pv >= xRegions[ x ].pucStart ) && ( ( const uint8_t * ) pv < xRegions[ x ].pucEnd ) )
+            {
+                pxRegion = &( xRegions[ x ] );
+                break;
+            }
+        }
+
+        return pxRegion;
+    }
+/*-----------------------------------------------------------*/
+
+    UBaseType_t uxPortGetHeapRegionStats( HeapRegionStats_t * pxRegionStats,
+                                          UBaseType_t uxMaxRegions )
+    {
+        BlockLink_t * pxBlock;
+        HeapRegionStats_t * pxStats;
+        UBaseType_t uxCount, x;
+
+        vTaskSuspendAll();
+        {
+            uxCount = ( uxRegions < uxMaxRegions ) ? uxRegions : uxMaxRegions;
+
+            for( x = 0; x < uxCount; x++ )
+            {
+                pxStats = &( pxRegionStats[ x ] );
+                pxStats->pucStartAddress = xRegions[ x ].pucStart;
+                pxStats->xSizeInBytes = ( size_t ) ( xRegions[ x ].pucEnd - xRegions[ x ].pucStart );
+                pxStats->xExternal = heapIS_EXTERNAL( xRegions[ x ].pucStart );
+                pxStats->xAvailableHeapSpaceInBytes = xRegions[ x ].xFreeBytes;
+                pxStats->xSizeOfLargestFreeBlockInBytes = 0;
+                pxStats->xNumberOfFreeBlocks = 0;
+                pxStats->xMinimumEverFreeBytesRemaining = xRegions[ x ].xMinimumEverFreeBytes;
+                pxStats->xNumberOfSuccessfulAllocations = xRegions[ x ].xAllocations;
+                pxStats->xNumberOfSuccessfulFrees = xRegions[ x ].xFrees;
+            }
+
+            /* Each free block counts for the region it lies in, the zero sized
+             * end markers for none. */
+            pxBlock = heapPROTECT_BLOCK_POINTER( xStart.pxNextFreeBlock );
+
+            while( ( pxBlock != NULL ) && ( pxBlock != pxEnd ) )
+            {
+                for( x = 0; ( x < uxCount ) && ( pxBlock->xBlockSize != 0 ); x++ )
+                {
+                    if( ( ( uint8_t * ) pxBlock >= xRegions[ x ].pucStart ) && ( ( uint8_t * ) pxBlock < xRegions[ x ].pucEnd ) )
+                    {
+                        pxRegionStats[ x ].xNumberOfFreeBlocks++;
+
+                        if( pxBlock->xBlockSize > pxRegionStats[ x ].xSizeOfLargestFreeBlockInBytes )
+                        {
+                            pxRegionStats[ x ].xSizeOfLargestFreeBlockInBytes = pxBlock->xBlockSize;
+                        }
+
+                        break;
+                    }
+                }
+
+                pxBlock = heapPROTECT_BLOCK_POINTER( pxBlock->pxNextFreeBlock );
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        return uxCount;
+    }
+
+#endif /* portUSE_HEAP_REGIONS */
+/*-----------------------------------------------------------*/
+
 void vPortGetHeapStats( HeapStats_t * pxHeapStats )
 {
     BlockLink_t * pxBlock;
@@ -581,7 +1892,9 @@ void vPortGetHeapStats( HeapStats_t * pxHeapStats )
                     xMaxSize = pxBlock->xBlockSize;
                 }
 
-                if( pxBlock->xBlockSize < xMinSize )
+                /* End markers of regions added by vPortAddHeapRegion() are
+                 * zero sized and only link to the next region. */
+                if( ( pxBlock->xBlockSize != 0 ) && ( pxBlock->xBlockSize < xMinSize ) )
                 {
                     xMinSize = pxBlock->xBlockSize;
                 }
@@ -617,6 +1930,31 @@ void vPortGetHeapStats( HeapStats_t * pxHeapStats )
 void vPortHeapResetState( void )
 {
     pxEnd = NULL;
+    pucHeapStart = NULL;
+
+    #if ( portUSE_HEAP_REGIONS == 1 )
+    {
+        uxRegions = 0;
+    }
+    #endif
+
+    #if ( portUSE_HEAP_ISR == 1 )
+    {
+        pucIsrPoolStart = NULL;
+        pucIsrPoolEnd = NULL;
+        pvIsrFreeBlock = NULL;
+        uxIsrFreeBlocks = portHEAP_ISR_BLOCKS;
+        uxIsrMinimumEverFreeBlocks = portHEAP_ISR_BLOCKS;
+        pvPendingFrees = NULL;
+    }
+    #endif
+
+    #if ( portUSE_HEAP_SLABS == 1 )
+    {
+        pucSlabsStart = NULL;
+        pucSlabsEnd = NULL;
+    }
+    #endif
 
     xFreeBytesRemaining = ( size_t ) 0U;
     xMinimumEverFreeBytesRemaining = ( size_t ) 0U;
@@ -624,3 +1962,5 @@ void vPortHeapResetState( void )
     xNumberOfSuccessfulFrees = ( size_t ) 0U;
 }
 /*-----------------------------------------------------------*/
+
+#endif /* portUSE_HEAP_TLSF */
@@ -0,0 +1,921 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        heap_tlsf.c
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Two level segregated fit (TLSF) implementation of
+ *              pvPortMalloc() and vPortFree(), used instead of heap_4.c when
+ *              portUSE_HEAP_TLSF is set to 1.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * heap_4.c keeps one list of free blocks sorted by address, which is walked to
+ * find a block on each allocation and again to insert a block on each free, so
+ * both take a time proportional to the number of free blocks.
+ *
+ * Here the free blocks are kept in one list per size range instead. The first
+ * level splits the sizes in powers of two, the second level splits each power
+ * of two in 2^portHEAP_TLSF_SL_LOG2 equal parts, and a bitmap per level marks
+ * the lists that are not empty. An allocation rounds the size up to the next
+ * range, so the first block of any list found for it is large enough, and
+ * finds that list with two find-first-set operations. Each block records its
+ * physical neighbour in front, so a freed block is merged with both neighbours
+ * without any search. Allocation and free therefore take a bounded time,
+ * independent of the number of blocks, at the cost of up to 1/2^SL_LOG2 of the
+ * block lost to the rounding and of the list heads (FL x SL pointers).
+ *
+ * The blocks have a header of a pointer and a size, like the BlockLink_t of
+ * heap_4.c. Regions can be added with vPortAddHeapRegion() in any order.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+ * all the API functions to use the MPU wrappers.  That should only be done when
+ * task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#ifndef portUSE_HEAP_TLSF
+    #define portUSE_HEAP_TLSF    0
+#endif
+
+#if ( portUSE_HEAP_TLSF == 1 )
+
+/*-----------------------------------------------------------*/
+
+#if ( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+    #error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+#if ( portUSE_HEAP_SLABS == 1 )
+    #error portUSE_HEAP_SLABS is only supported by heap_4.c.
+#endif
+
+#if ( configENABLE_HEAP_PROTECTOR == 1 )
+    #error configENABLE_HEAP_PROTECTOR is only supported by heap_4.c.
+#endif
+
+#if ( portUSE_HEAP_REGIONS == 1 )
+    #error portUSE_HEAP_REGIONS is only supported by heap_4.c.
+#endif
+
+#if ( portUSE_HEAP_ISR == 1 )
+    #error portUSE_HEAP_ISR is only supported by heap_4.c.
+#endif
+
+#ifndef configHEAP_CLEAR_MEMORY_ON_FREE
+    #define configHEAP_CLEAR_MEMORY_ON_FREE    0
+#endif
+
+#ifndef portHEAP_TLSF_SL_LOG2
+    #define portHEAP_TLSF_SL_LOG2    2
+#endif
+
+#ifndef portHEAP_TLSF_FL_MAX
+    #define portHEAP_TLSF_FL_MAX     16
+#endif
+
+#if ( portHEAP_TLSF_SL_LOG2 < 1 ) || ( portHEAP_TLSF_SL_LOG2 > 3 )
+    #error portHEAP_TLSF_SL_LOG2 must be between 1 and 3.
+#endif
+
+/* Block sizes are multiples of the granule, which keeps bit 0 of the size free
+ * for the free flag. */
+#if ( portBYTE_ALIGNMENT >= 16 )
+    #define tlsfGRANULE_LOG2    4
+#elif ( portBYTE_ALIGNMENT == 8 )
+    #define tlsfGRANULE_LOG2    3
+#elif ( portBYTE_ALIGNMENT == 4 )
+    #define tlsfGRANULE_LOG2    2
+#else
+    #define tlsfGRANULE_LOG2    1
+#endif
+
+#define tlsfGRANULE             ( ( size_t ) 1 << tlsfGRANULE_LOG2 )
+#define tlsfGRANULE_MASK        ( tlsfGRANULE - 1U )
+
+/* Sizes below tlsfSMALL_BLOCK are all in the first list of the first level,
+ * split in granules. Above, each power of two has its own first level list. */
+#define tlsfSL_COUNT            ( 1U << portHEAP_TLSF_SL_LOG2 )
+#define tlsfFL_SHIFT            ( portHEAP_TLSF_SL_LOG2 + tlsfGRANULE_LOG2 )
+#define tlsfSMALL_BLOCK         ( ( size_t ) 1 << tlsfFL_SHIFT )
+#define tlsfFL_COUNT            ( portHEAP_TLSF_FL_MAX - tlsfFL_SHIFT + 1 )
+
+/* Blocks must stay below 2^portHEAP_TLSF_FL_MAX bytes. */
+#define tlsfMAX_BLOCK           ( ( ( size_t ) 1 << ( portHEAP_TLSF_FL_MAX - 1 ) ) + ( ( ( size_t ) 1 << ( portHEAP_TLSF_FL_MAX - 1 ) ) - tlsfGRANULE ) )
+
+#if ( tlsfFL_COUNT < 2 ) || ( tlsfFL_COUNT > 32 )
+    #error portHEAP_TLSF_FL_MAX does not fit portHEAP_TLSF_SL_LOG2 and portBYTE_ALIGNMENT.
+#endif
+
+/* Bit 0 of the size is set while the block is free. */
+#define tlsfBLOCK_FREE          ( ( size_t ) 1 )
+#define tlsfBLOCK_SIZE( pxBlock )        ( ( pxBlock )->xSize & ~tlsfBLOCK_FREE )
+#define tlsfBLOCK_IS_FREE( pxBlock )     ( ( ( pxBlock )->xSize & tlsfBLOCK_FREE ) != 0 )
+
+/* Max value that fits in a size_t type. */
+#define tlsfSIZE_MAX            ( ~( ( size_t ) 0 ) )
+
+/* Check if multiplying a and b will result in overflow. */
+#define tlsfMULTIPLY_WILL_OVERFLOW( a, b )    ( ( ( a ) > 0 ) && ( ( b ) > ( tlsfSIZE_MAX / ( a ) ) ) )
+
+/*-----------------------------------------------------------*/
+
+/* Allocate the memory for the heap. */
+#if ( configAPPLICATION_ALLOCATED_HEAP == 1 ) && defined( portHEAP_START )
+
+/* The port places the heap at run time, in which case configTOTAL_HEAP_SIZE
+ * is not a constant either. */
+    #define ucHeap    ( portHEAP_START )
+#elif ( configAPPLICATION_ALLOCATED_HEAP == 1 )
+
+/* The application writer has already defined the array used for the RTOS
+* heap - probably so it can be placed in a special segment or address. */
+    extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+    PRIVILEGED_DATA static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#endif /* configAPPLICATION_ALLOCATED_HEAP */
+
+/* The header of a block.  The links to the other free blocks are only valid
+ * while the block is free, they lie in the memory given to the application
+ * while it is allocated. */
+typedef struct TLSF_BLOCK
+{
+    struct TLSF_BLOCK * pxPrevPhysBlock; /**< The block in front of this one in memory, NULL for the first block of a region. */
+    size_t xSize;                        /**< Size of the block including the header, bit 0 set while the block is free. */
+    struct TLSF_BLOCK * pxNextFree;      /**< The next block of the same free list. */
+    struct TLSF_BLOCK * pxPrevFree;      /**< The previous block of the same free list, NULL for the first one. */
+} TlsfBlock_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Returns the index of the most significant bit set in xValue, which must not
+ * be 0.
+ */
+static UBaseType_t prvMostSignificantBit( size_t xValue );
+
+/*
+ * Computes the lists of the size range xSize belongs to.
+ */
+static void prvMapping( size_t xSize,
+                        UBaseType_t * puxFL,
+                        UBaseType_t * puxSL );
+
+/*
+ * Adds a free block to the head of the list of its size.
+ */
+static void prvInsertFreeBlock( TlsfBlock_t * pxBlock ) PRIVILEGED_FUNCTION;
+
+/*
+ * Removes a free block from the list of its size.
+ */
+static void prvRemoveFreeBlock( TlsfBlock_t * pxBlock ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns a free block of at least xSize bytes, removed from its list, or NULL.
+ */
+static TlsfBlock_t * prvFindFreeBlock( size_t xSize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Makes the memory of a region one free block, followed by a zero sized block
+ * that is never free and ends the region.
+ */
+static void prvAddRegion( void * pvRegion,
+                          size_t xRegionSize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Called automatically to setup the required heap structures the first time
+ * pvPortMalloc() is called.
+ */
+static void prvHeapInit( void ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+/* The size of the header of an allocated block, the links to the other free
+ * blocks are not needed then. */
+static const size_t xHeaderSize = ( offsetof( TlsfBlock_t, pxNextFree ) + tlsfGRANULE_MASK ) & ~tlsfGRANULE_MASK;
+
+/* Free blocks must be able to hold the links. */
+static const size_t xMinimumBlockSize = ( sizeof( TlsfBlock_t ) + tlsfGRANULE_MASK ) & ~tlsfGRANULE_MASK;
+
+/* The heads of the free lists and the bitmaps of the lists that are not
+ * empty. */
+PRIVILEGED_DATA static TlsfBlock_t * pxFreeLists[ tlsfFL_COUNT ][ tlsfSL_COUNT ];
+PRIVILEGED_DATA static uint32_t ulFLBitmap = 0U;
+PRIVILEGED_DATA static uint8_t ucSLBitmaps[ tlsfFL_COUNT ];
+
+PRIVILEGED_DATA static BaseType_t xHeapInitialised = pdFALSE;
+
+/* Keeps track of the number of calls to allocate and free memory as well as the
+ * number of free bytes remaining, but says nothing about fragmentation. */
+PRIVILEGED_DATA static size_t xFreeBytesRemaining = ( size_t ) 0U;
+PRIVILEGED_DATA static size_t xMinimumEverFreeBytesRemaining = ( size_t ) 0U;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulAllocations = ( size_t ) 0U;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulFrees = ( size_t ) 0U;
+
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvMostSignificantBit( size_t xValue )
+{
+    #if ( defined( __GNUC__ ) )
+    {
+        return ( UBaseType_t ) ( ( sizeof( unsigned long ) * 8U ) - 1U - ( size_t ) __builtin_clzl( ( unsigned long ) xValue ) );
+    }
+    #else
+    {
+        UBaseType_t uxBit = 0;
+
+        while( ( xValue >>= 1 ) != 0U )
+        {
+            uxBit++;
+        }
+
+        return uxBit;
+    }
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvLeastSignificantBit( uint32_t ulValue )
+{
+    #if ( defined( __GNUC__ ) )
+    {
+        return ( UBaseType_t ) __builtin_ctzl( ( unsigned long ) ulValue );
+    }
+    #else
+    {
+        UBaseType_t uxBit = 0;
+
+        while( ( ulValue & 1U ) == 0U )
+        {
+            ulValue >>= 1;
+            uxBit++;
+        }
+
+        return uxBit;
+    }
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvMapping( size_t xSize,
+                        UBaseType_t * puxFL,
+                        UBaseType_t * puxSL )
+{
+    UBaseType_t uxBit;
+
+    if( xSize < tlsfSMALL_BLOCK )
+    {
+        *puxFL = 0;
+        *puxSL = ( UBaseType_t ) ( xSize >> tlsfGRANULE_LOG2 );
+    }
+    else
+    {
+        uxBit = prvMostSignificantBit( xSize );
+        *puxFL = ( UBaseType_t ) ( uxBit - tlsfFL_SHIFT + 1U );
+        *puxSL = ( UBaseType_t ) ( ( xSize >> ( uxBit - portHEAP_TLSF_SL_LOG2 ) ) & ( tlsfSL_COUNT - 1U ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( TlsfBlock_t * pxBlock )
+{
+    UBaseType_t uxFL, uxSL;
+
+    prvMapping( tlsfBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+
+    pxBlock->xSize |= tlsfBLOCK_FREE;
+    pxBlock->pxPrevFree = NULL;
+    pxBlock->pxNextFree = pxFreeLists[ uxFL ][ uxSL ];
+
+    if( pxBlock->pxNextFree != NULL )
+    {
+        pxBlock->pxNextFree->pxPrevFree = pxBlock;
+    }
+
+    pxFreeLists[ uxFL ][ uxSL ] = pxBlock;
+    ulFLBitmap |= ( uint32_t ) 1U << uxFL;
+    ucSLBitmaps[ uxFL ] |= ( uint8_t ) ( 1U << uxSL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( TlsfBlock_t * pxBlock )
+{
+    UBaseType_t uxFL, uxSL;
+
+    prvMapping( tlsfBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+
+    if( pxBlock->pxNextFree != NULL )
+    {
+        pxBlock->pxNextFree->pxPrevFree = pxBlock->pxPrevFree;
+    }
+
+    if( pxBlock->pxPrevFree != NULL )
+    {
+        pxBlock->pxPrevFree->pxNextFree = pxBlock->pxNextFree;
+    }
+    else
+    {
+        pxFreeLists[ uxFL ][ uxSL ] = pxBlock->pxNextFree;
+
+        if( pxBlock->pxNextFree == NULL )
+        {
+            ucSLBitmaps[ uxFL ] &= ( uint8_t ) ~( 1U << uxSL );
+
+            if( ucSLBitmaps[ uxFL ] == 0U )
+            {
+                ulFLBitmap &= ~( ( uint32_t ) 1U << uxFL );
+            }
+        }
+    }
+
+    pxBlock->xSize &= ~tlsfBLOCK_FREE;
+}
+/*-----------------------------------------------------------*/
+
+static TlsfBlock_t * prvFindFreeBlock( size_t xSize )
+{
+    TlsfBlock_t * pxBlock = NULL;
+    UBaseType_t uxFL, uxSL;
+    uint32_t ulSLMap, ulFLMap;
+
+    /* Round the size up to the start of the next range, so any block of the
+     * list found is large enough.  Small sizes have a list per size. */
+    if( xSize >= tlsfSMALL_BLOCK )
+    {
+        xSize += ( ( size_t ) 1 << ( prvMostSignificantBit( xSize ) - portHEAP_TLSF_SL_LOG2 ) ) - 1U;
+    }
+
+    if( xSize <= tlsfMAX_BLOCK )
+    {
+        prvMapping( xSize, &uxFL, &uxSL );
+
+        /* A list of the same power of two with larger blocks, else the
+         * smallest larger power of two with any list. */
+        ulSLMap = ( uint32_t ) ucSLBitmaps[ uxFL ] & ( ~( uint32_t ) 0U << uxSL );
+
+        if( ulSLMap == 0U )
+        {
+            ulFLMap = ( uxFL + 1U < 32U ) ? ( ulFLBitmap & ( ~( uint32_t ) 0U << ( uxFL + 1U ) ) ) : 0U;
+
+            if( ulFLMap != 0U )
+            {
+                uxFL = prvLeastSignificantBit( ulFLMap );
+                ulSLMap = ucSLBitmaps[ uxFL ];
+            }
+        }
+
+        if( ulSLMap != 0U )
+        {
+            uxSL = prvLeastSignificantBit( ulSLMap );
+            pxBlock = pxFreeLists[ uxFL ][ uxSL ];
+            prvRemoveFreeBlock( pxBlock );
+        }
+    }
+
+    return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    TlsfBlock_t * pxBlock;
+    TlsfBlock_t * pxRemainder;
+    TlsfBlock_t * pxNextBlock;
+    void * pvReturn = NULL;
+    size_t xBlockSize = 0;
+
+    /* The wanted size is increased so it can contain the header, and rounded
+     * up to the granule, which can not overflow as long as the result stays
+     * below tlsfMAX_BLOCK. */
+    if( ( xWantedSize > 0 ) && ( xWantedSize <= ( tlsfMAX_BLOCK - xHeaderSize ) ) )
+    {
+        xBlockSize = ( xWantedSize + xHeaderSize + tlsfGRANULE_MASK ) & ~tlsfGRANULE_MASK;
+
+        if( xBlockSize < xMinimumBlockSize )
+        {
+            xBlockSize = xMinimumBlockSize;
+        }
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    vTaskSuspendAll();
+    {
+        /* If this is the first call to malloc then the heap will require
+         * initialisation to setup the lists of free blocks. */
+        if( xHeapInitialised == pdFALSE )
+        {
+            prvHeapInit();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if( ( xBlockSize > 0 ) && ( xBlockSize <= xFreeBytesRemaining ) )
+        {
+            pxBlock = prvFindFreeBlock( xBlockSize );
+
+            if( pxBlock != NULL )
+            {
+                /* If the block is larger than required it is split into two,
+                 * and the rest goes back to the free lists. */
+                if( ( tlsfBLOCK_SIZE( pxBlock ) - xBlockSize ) >= xMinimumBlockSize )
+                {
+                    pxRemainder = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + xBlockSize );
+                    pxRemainder->xSize = tlsfBLOCK_SIZE( pxBlock ) - xBlockSize;
+                    pxRemainder->pxPrevPhysBlock = pxBlock;
+
+                    pxNextBlock = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxRemainder ) + pxRemainder->xSize );
+                    pxNextBlock->pxPrevPhysBlock = pxRemainder;
+
+                    pxBlock->xSize = xBlockSize;
+                    prvInsertFreeBlock( pxRemainder );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                xFreeBytesRemaining -= tlsfBLOCK_SIZE( pxBlock );
+
+                if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+                {
+                    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeaderSize );
+                xNumberOfSuccessfulAllocations++;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        traceMALLOC( pvReturn, xBlockSize );
+    }
+    ( void ) xTaskResumeAll();
+
+    #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    {
+        if( pvReturn == NULL )
+        {
+            vApplicationMallocFailedHook();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    #endif /* if ( configUSE_MALLOC_FAILED_HOOK == 1 ) */
+
+    configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void * pv )
+{
+    TlsfBlock_t * pxBlock;
+    TlsfBlock_t * pxNeighbour;
+
+    if( pv != NULL )
+    {
+        /* The memory being freed has the header immediately before it. */
+        pxBlock = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pv ) - xHeaderSize );
+
+        configASSERT( tlsfBLOCK_IS_FREE( pxBlock ) == 0 );
+        configASSERT( tlsfBLOCK_SIZE( pxBlock ) >= xMinimumBlockSize );
+
+        if( tlsfBLOCK_IS_FREE( pxBlock ) == 0 )
+        {
+            #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
+            {
+                ( void ) memset( pv, 0, tlsfBLOCK_SIZE( pxBlock ) - xHeaderSize );
+            }
+            #endif
+
+            vTaskSuspendAll();
+            {
+                xFreeBytesRemaining += tlsfBLOCK_SIZE( pxBlock );
+                traceFREE( pv, tlsfBLOCK_SIZE( pxBlock ) );
+
+                /* Merge with the block behind, if it is free. */
+                pxNeighbour = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + pxBlock->xSize );
+
+                if( tlsfBLOCK_IS_FREE( pxNeighbour ) != 0 )
+                {
+                    prvRemoveFreeBlock( pxNeighbour );
+                    pxBlock->xSize += pxNeighbour->xSize;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                /* Merge with the block in front, if it is free. */
+                pxNeighbour = pxBlock->pxPrevPhysBlock;
+
+                if( ( pxNeighbour != NULL ) && ( tlsfBLOCK_IS_FREE( pxNeighbour ) != 0 ) )
+                {
+                    prvRemoveFreeBlock( pxNeighbour );
+                    pxNeighbour->xSize += pxBlock->xSize;
+                    pxBlock = pxNeighbour;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                /* The block behind the merged block must point to it. */
+                pxNeighbour = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + pxBlock->xSize );
+                pxNeighbour->pxPrevPhysBlock = pxBlock;
+
+                prvInsertFreeBlock( pxBlock );
+                xNumberOfSuccessfulFrees++;
+            }
+            ( void ) xTaskResumeAll();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+    /* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortCalloc( size_t xNum,
+                     size_t xSize )
+{
+    void * pv = NULL;
+
+    if( tlsfMULTIPLY_WILL_OVERFLOW( xNum, xSize ) == 0 )
+    {
+        pv = pvPortMalloc( xNum * xSize );
+
+        if( pv != NULL )
+        {
+            ( void ) memset( pv, 0, xNum * xSize );
+        }
+    }
+
+    return pv;
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortRealloc( void * pv,
+                      size_t xWantedSize )
+{
+    TlsfBlock_t * pxBlock;
+    TlsfBlock_t * pxPrevBlock;
+    TlsfBlock_t * pxNextBlock;
+    TlsfBlock_t * pxRemainder;
+    void * pvReturn = NULL;
+    size_t xBlockSize = 0;
+    size_t xOldSize;
+    size_t xPrevSize = 0;
+    size_t xNextSize = 0;
+    size_t xCopySize;
+
+    if( pv == NULL )
+    {
+        pvReturn = pvPortMalloc( xWantedSize );
+    }
+    else if( xWantedSize == 0 )
+    {
+        vPortFree( pv );
+    }
+    else
+    {
+        /* Rounded up like in pvPortMalloc(). */
+        if( xWantedSize <= ( tlsfMAX_BLOCK - xHeaderSize ) )
+        {
+            xBlockSize = ( xWantedSize + xHeaderSize + tlsfGRANULE_MASK ) & ~tlsfGRANULE_MASK;
+
+            if( xBlockSize < xMinimumBlockSize )
+            {
+                xBlockSize = xMinimumBlockSize;
+            }
+        }
+
+        pxBlock = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pv ) - xHeaderSize );
+
+        configASSERT( tlsfBLOCK_IS_FREE( pxBlock ) == 0 );
+        configASSERT( tlsfBLOCK_SIZE( pxBlock ) >= xMinimumBlockSize );
+
+        vTaskSuspendAll();
+        {
+            xOldSize = tlsfBLOCK_SIZE( pxBlock );
+            xCopySize = xOldSize - xHeaderSize;
+
+            if( xBlockSize > 0 )
+            {
+                /* The physical neighbours, the end block of a region is never
+                 * free. */
+                pxNextBlock = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + xOldSize );
+                pxPrevBlock = pxBlock->pxPrevPhysBlock;
+
+                if( tlsfBLOCK_IS_FREE( pxNextBlock ) != 0 )
+                {
+                    xNextSize = tlsfBLOCK_SIZE( pxNextBlock );
+                }
+
+                if( ( pxPrevBlock != NULL ) && ( tlsfBLOCK_IS_FREE( pxPrevBlock ) != 0 ) )
+                {
+                    xPrevSize = tlsfBLOCK_SIZE( pxPrevBlock );
+                }
+
+                if( xBlockSize <= xOldSize )
+                {
+                    /* Shrink, the tail is split off below. */
+                    pvReturn = pv;
+                }
+                else if( ( xBlockSize - xOldSize ) <= xNextSize )
+                {
+                    /* Grow into the free block behind. */
+                    prvRemoveFreeBlock( pxNextBlock );
+                    pxBlock->xSize = xOldSize + xNextSize;
+                    pvReturn = pv;
+                }
+                else if( ( xPrevSize > 0 ) && ( ( xBlockSize - xOldSize ) <= ( xPrevSize + xNextSize ) ) )
+                {
+                    /* Grow into the free block in front, and the one behind if
+                     * needed, and move the data down. */
+                    prvRemoveFreeBlock( pxPrevBlock );
+
+                    if( xNextSize > 0 )
+                    {
+                        prvRemoveFreeBlock( pxNextBlock );
+                    }
+
+                    pxPrevBlock->xSize = xPrevSize + xOldSize + xNextSize;
+                    pxBlock = pxPrevBlock;
+                    pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeaderSize );
+                    ( void ) memmove( pvReturn, pv, xCopySize );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                if( pvReturn != NULL )
+                {
+                    /* The block behind must point to the resized block. */
+                    pxNextBlock = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + pxBlock->xSize );
+                    pxNextBlock->pxPrevPhysBlock = pxBlock;
+
+                    /* Return the tail to the free lists, merged with the block
+                     * behind if that is free, as no two free blocks may be
+                     * neighbours. */
+                    if( ( pxBlock->xSize - xBlockSize ) >= xMinimumBlockSize )
+                    {
+                        pxRemainder = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + xBlockSize );
+                        pxRemainder->xSize = pxBlock->xSize - xBlockSize;
+                        pxRemainder->pxPrevPhysBlock = pxBlock;
+                        pxBlock->xSize = xBlockSize;
+
+                        if( tlsfBLOCK_IS_FREE( pxNextBlock ) != 0 )
+                        {
+                            prvRemoveFreeBlock( pxNextBlock );
+                            pxRemainder->xSize += pxNextBlock->xSize;
+                            pxNextBlock = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxRemainder ) + pxRemainder->xSize );
+                        }
+
+                        pxNextBlock->pxPrevPhysBlock = pxRemainder;
+
+                        #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
+                        {
+                            ( void ) memset( ( ( uint8_t * ) pxRemainder ) + xHeaderSize, 0, pxRemainder->xSize - xHeaderSize );
+                        }
+                        #endif
+
+                        prvInsertFreeBlock( pxRemainder );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    /* Account for the difference to the old size, which may be
+                     * positive or negative. */
+                    xFreeBytesRemaining = ( xFreeBytesRemaining + xOldSize ) - pxBlock->xSize;
+
+                    if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+                    {
+                        xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    traceFREE( pv, xOldSize );
+                    traceMALLOC( pvReturn, pxBlock->xSize );
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        if( pvReturn == NULL )
+        {
+            /* There is no room next to the block, so it has to be moved. */
+            pvReturn = pvPortMalloc( xWantedSize );
+
+            if( pvReturn != NULL )
+            {
+                ( void ) memcpy( pvReturn, pv, ( xCopySize < xWantedSize ) ? xCopySize : xWantedSize );
+                vPortFree( pv );
+            }
+        }
+    }
+
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAddRegion( void * pvRegion,
+                          size_t xRegionSize )
+{
+    TlsfBlock_t * pxBlock;
+    TlsfBlock_t * pxEndBlock;
+    portPOINTER_SIZE_TYPE uxStartAddress, uxEndAddress;
+
+    /* Ensure the region starts and ends on a granule. */
+    uxStartAddress = ( portPOINTER_SIZE_TYPE ) pvRegion;
+    uxEndAddress = uxStartAddress + ( portPOINTER_SIZE_TYPE ) xRegionSize;
+
+    uxStartAddress += tlsfGRANULE_MASK;
+    uxStartAddress &= ~( ( portPOINTER_SIZE_TYPE ) tlsfGRANULE_MASK );
+    uxEndAddress &= ~( ( portPOINTER_SIZE_TYPE ) tlsfGRANULE_MASK );
+
+    /* The end block takes a header. */
+    if( ( uxEndAddress > uxStartAddress ) &&
+        ( ( size_t ) ( uxEndAddress - uxStartAddress ) >= ( xMinimumBlockSize + xHeaderSize ) ) )
+    {
+        /* The rest of a region larger than the largest block is not used. */
+        if( ( size_t ) ( uxEndAddress - uxStartAddress - xHeaderSize ) > tlsfMAX_BLOCK )
+        {
+            uxEndAddress = uxStartAddress + tlsfMAX_BLOCK + xHeaderSize;
+        }
+
+        pxBlock = ( TlsfBlock_t * ) uxStartAddress;
+        pxBlock->pxPrevPhysBlock = NULL;
+        pxBlock->xSize = ( size_t ) ( uxEndAddress - uxStartAddress - xHeaderSize );
+
+        pxEndBlock = ( TlsfBlock_t * ) ( uxEndAddress - xHeaderSize );
+        pxEndBlock->pxPrevPhysBlock = pxBlock;
+        pxEndBlock->xSize = 0;
+
+        prvInsertFreeBlock( pxBlock );
+
+        xFreeBytesRemaining += tlsfBLOCK_SIZE( pxBlock );
+        xMinimumEverFreeBytesRemaining += tlsfBLOCK_SIZE( pxBlock );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortAddHeapRegion( void * pvRegion,
+                         size_t xRegionSize ) /* PRIVILEGED_FUNCTION */
+{
+    vTaskSuspendAll();
+    {
+        if( xHeapInitialised == pdFALSE )
+        {
+            prvHeapInit();
+        }
+
+        /* Unlike heap_4.c the regions can lie anywhere. */
+        prvAddRegion( pvRegion, xRegionSize );
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void ) /* PRIVILEGED_FUNCTION */
+{
+    xHeapInitialised = pdTRUE;
+
+    prvAddRegion( ( void * ) ucHeap, ( size_t ) configTOTAL_HEAP_SIZE );
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t * pxHeapStats )
+{
+    TlsfBlock_t * pxBlock;
+    size_t xBlocks = 0, xMaxSize = 0, xMinSize = portMAX_DELAY; /* portMAX_DELAY used as a portable way of getting the maximum value. */
+    UBaseType_t uxFL, uxSL;
+
+    vTaskSuspendAll();
+    {
+        for( uxFL = 0; uxFL < tlsfFL_COUNT; uxFL++ )
+        {
+            for( uxSL = 0; uxSL < tlsfSL_COUNT; uxSL++ )
+            {
+                for( pxBlock = pxFreeLists[ uxFL ][ uxSL ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFree )
+                {
+                    xBlocks++;
+
+                    if( tlsfBLOCK_SIZE( pxBlock ) > xMaxSize )
+                    {
+                        xMaxSize = tlsfBLOCK_SIZE( pxBlock );
+                    }
+
+                    if( tlsfBLOCK_SIZE( pxBlock ) < xMinSize )
+                    {
+                        xMinSize = tlsfBLOCK_SIZE( pxBlock );
+                    }
+                }
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+    pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+
+    taskENTER_CRITICAL();
+    {
+        pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Reset the state in this file. This state is normally initialized at start up.
+ * This function must be called by the application before restarting the
+ * scheduler.
+ */
+void vPortHeapResetState( void )
+{
+    xHeapInitialised = pdFALSE;
+
+    ( void ) memset( pxFreeLists, 0, sizeof( pxFreeLists ) );
+    ( void ) memset( ucSLBitmaps, 0, sizeof( ucSLBitmaps ) );
+    ulFLBitmap = 0U;
+
+    xFreeBytesRemaining = ( size_t ) 0U;
+    xMinimumEverFreeBytesRemaining = ( size_t ) 0U;
+    xNumberOfSuccessfulAllocations = ( size_t ) 0U;
+    xNumberOfSuccessfulFrees = ( size_t ) 0U;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* portUSE_HEAP_TLSF */
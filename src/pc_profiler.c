@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        pc_profiler.c
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Sampling profiler of the code address interrupted by the tick,
+ *              see pc_profiler.h.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if ( portUSE_PC_PROFILER == 1 )
+
+/*-----------------------------------------------------------*/
+
+/* The profiler must not take a critical section of the kernel. On the AVR
+ * portSET_INTERRUPT_MASK_FROM_ISR() is not defined, SREG is saved instead. */
+#if defined( __AVR__ )
+    #define profENTER()     const uint8_t ucSavedSREG = SREG; portDISABLE_INTERRUPTS()
+    #define profEXIT()      SREG = ucSavedSREG
+#else
+    #define profENTER()     UBaseType_t uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR()
+    #define profEXIT()      portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus )
+#endif
+
+/* Entries tried from the hash of a sample on, before it is dropped. Bounds
+ * the time spent in the tick interrupt once the table fills up. */
+#define profPROBES          ( 8U )
+
+#define profSLOT_MASK       ( ( UBaseType_t ) portPC_PROFILER_SLOTS - 1U )
+
+#if ( portPC_PROFILER_SLOTS < 2 ) || ( ( portPC_PROFILER_SLOTS & ( portPC_PROFILER_SLOTS - 1 ) ) != 0 )
+    #error "portPC_PROFILER_SLOTS must be a power of two."
+#endif
+
+#if ( configUSE_PREEMPTION == 0 ) && defined( __AVR__ )
+    #error "portUSE_PC_PROFILER needs configUSE_PREEMPTION on the AVR ports."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Unused entries have a ulCount of 0. */
+static PcProfileBucket_t xBuckets[ portPC_PROFILER_SLOTS ];
+
+static uint32_t ulDropped = 0;
+
+/*-----------------------------------------------------------*/
+
+void vPcProfileSample( uint32_t ulAddress,
+                       void * pvTask )
+{
+    const uint32_t ulBucket = ulAddress & ~( ( ( uint32_t ) 1U << portPC_PROFILER_SHIFT ) - 1U );
+    UBaseType_t uxSlot;
+
+    /* Cheap enough for the tick interrupt of an AVR: neighbouring buckets of
+     * one task go to neighbouring entries. */
+    uxSlot = ( UBaseType_t ) ( ( ulBucket >> portPC_PROFILER_SHIFT ) ^
+                               ( ( uint32_t ) ( uintptr_t ) pvTask >> 3 ) );
+
+    for( UBaseType_t x = 0; x < profPROBES; x++ )
+    {
+        PcProfileBucket_t * const pxEntry = &( xBuckets[ ( uxSlot + x ) & profSLOT_MASK ] );
+
+        if( pxEntry->ulCount == 0 )
+        {
+            pxEntry->ulAddress = ulBucket;
+            pxEntry->pvTask = pvTask;
+            pxEntry->ulCount = 1;
+            return;
+        }
+        else if( ( pxEntry->ulAddress == ulBucket ) && ( pxEntry->pvTask == pvTask ) )
+        {
+            pxEntry->ulCount++;
+            return;
+        }
+    }
+
+    ulDropped++;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPcProfileRead( PcProfileBucket_t * pxBuckets,
+                       size_t xMaxBuckets,
+                       int xReset )
+{
+    size_t xCount = 0;
+
+    /* The entries are read one at a time, to keep the interrupts masked
+     * short. */
+    for( UBaseType_t x = 0; ( x < portPC_PROFILER_SLOTS ) && ( xCount < xMaxBuckets ); x++ )
+    {
+        profENTER();
+        {
+            pxBuckets[ xCount ] = xBuckets[ x ];
+        }
+        profEXIT();
+
+        if( pxBuckets[ xCount ].ulCount != 0 )
+        {
+            xCount++;
+        }
+    }
+
+    if( xReset != 0 )
+    {
+        profENTER();
+        {
+            ( void ) memset( xBuckets, 0x00, sizeof( xBuckets ) );
+            ulDropped = 0;
+        }
+        profEXIT();
+    }
+
+    return xCount;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPcProfileGetDropped( void )
+{
+    uint32_t ulReturn;
+
+    profENTER();
+    {
+        ulReturn = ulDropped;
+    }
+    profEXIT();
+
+    return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPcProfileGetBucketSize( void )
+{
+    return ( uint32_t ) 1U << portPC_PROFILER_SHIFT;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* portUSE_PC_PROFILER */
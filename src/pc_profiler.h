@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        pc_profiler.h
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Sampling profiler of the code address interrupted by the tick.
+ *              Enabled with portUSE_PC_PROFILER in FreeRTOSConfig.h, which
+ *              then includes this file.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __PC_PROFILER_H__
+#define __PC_PROFILER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * On every tick the port takes the return address of the interrupted code
+ * from the saved context:
+ *
+ *   ATmega, Mega0    the PC pushed by the tick interrupt, behind the frame
+ *                    saved by vPortYieldFromTick(). Only the preemptive
+ *                    scheduler has a frame of known layout, so the profiler
+ *                    needs configUSE_PREEMPTION.
+ *   Renesas (FSP)    the PC in the exception frame on the process stack, if
+ *                    SysTick_Handler() interrupted a task. Ticks that
+ *                    interrupted another interrupt are counted with the
+ *                    address 0.
+ *   Host (POSIX)     the PC in the signal context of SIGALRM, as an offset
+ *                    from the start of the executable (the addresses of a PIE
+ *                    executable in nm). The virtual clock has no interrupted
+ *                    code, its ticks are counted with the address 0.
+ *
+ * The address is divided into buckets of 2^portPC_PROFILER_SHIFT bytes, and
+ * the samples are counted per bucket and running task in a hash table of
+ * portPC_PROFILER_SLOTS entries. A sample that finds no entry within
+ * profPROBES probes of its hash is counted as dropped, so the table should
+ * have some room to spare. A longer profile of one task needs fewer entries
+ * than one of the whole application, and a larger shift fewer than a smaller
+ * one.
+ *
+ * xPcProfileRead() copies the entries out, e.g. to be printed as
+ *
+ *   pc shift=4 dropped=0
+ *   pc task=Blink addr=0x1a20 count=532
+ *
+ * which extras/profiler/pcprof.py maps to the symbols of the ELF file.
+ */
+
+/*-----------------------------------------------------------*/
+
+typedef struct PcProfileBucket
+{
+    uint32_t ulAddress; /* First byte address of the bucket. */
+    void * pvTask;      /* Handle of the task that was interrupted. */
+    uint32_t ulCount;   /* Number of samples. */
+} PcProfileBucket_t;
+
+/*
+ * Copies up to xMaxBuckets used entries into pxBuckets, in table order, and
+ * clears the table and the dropped count if xReset is not 0. Returns the
+ * number of entries copied.
+ */
+size_t xPcProfileRead( PcProfileBucket_t * pxBuckets, size_t xMaxBuckets, int xReset );
+
+/*
+ * Returns the number of samples that found no free entry.
+ */
+uint32_t ulPcProfileGetDropped( void );
+
+/*
+ * Returns the bucket size in bytes.
+ */
+uint32_t ulPcProfileGetBucketSize( void );
+
+/* Called by the tick interrupt of the ports with interrupts masked, with the
+ * byte address of the interrupted code and the handle of the running task. */
+void vPcProfileSample( uint32_t ulAddress, void * pvTask );
+
+/*-----------------------------------------------------------*/
+
+#endif /* __PC_PROFILER_H__ */
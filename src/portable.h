@@ -156,6 +156,40 @@ typedef struct xHeapStats
     size_t xNumberOfSuccessfulFrees;        /* The number of calls to vPortFree() that has successfully freed a block of memory. */
 } HeapStats_t;
 
+/* Used to pass information about a pool of the slab layer of heap_4.c out of
+ * uxPortGetSlabStats(). */
+typedef struct xSlabStats
+{
+    size_t xObjectSize;                    /* The size of the objects of the pool, in bytes. */
+    size_t xNumberOfObjects;               /* The number of objects in the pool. */
+    size_t xNumberOfFreeObjects;           /* The number of objects currently free. */
+    size_t xMinimumEverFreeObjects;        /* The minimum number of free objects there has been since the system booted. */
+    size_t xNumberOfSuccessfulAllocations; /* The number of calls to pvPortMalloc() served by the pool. */
+    size_t xNumberOfFallbacks;             /* The number of calls to pvPortMalloc() that fitted the pool but went to the heap as it was exhausted. */
+} SlabStats_t;
+
+/* Used to pass information about a region of the heap of heap_4.c out of
+ * uxPortGetHeapRegionStats(). */
+typedef struct xHeapRegionStats
+{
+    uint8_t * pucStartAddress;              /* The start of the region, behind anything taken from it like the slab pools. */
+    size_t xSizeInBytes;                    /* The size of the region that is used for blocks. */
+    BaseType_t xExternal;                   /* pdTRUE if the region lies in external memory. */
+    size_t xAvailableHeapSpaceInBytes;      /* The sum of the free blocks of the region. */
+    size_t xSizeOfLargestFreeBlockInBytes;  /* The largest free block of the region at the time uxPortGetHeapRegionStats() is called. */
+    size_t xNumberOfFreeBlocks;             /* The number of free blocks of the region at the time uxPortGetHeapRegionStats() is called. */
+    size_t xMinimumEverFreeBytesRemaining;  /* The minimum sum of the free blocks of the region there has been since it was added. */
+    size_t xNumberOfSuccessfulAllocations;  /* The number of blocks allocated from the region. */
+    size_t xNumberOfSuccessfulFrees;        /* The number of blocks of the region freed. */
+} HeapRegionStats_t;
+
+/* Where pvPortMallocPlaced() takes a block from: internal or external memory
+ * first and then the other one, or only from one of them. */
+#define portHEAP_PLACE_INTERNAL_FIRST    ( ( UBaseType_t ) 0 )
+#define portHEAP_PLACE_EXTERNAL_FIRST    ( ( UBaseType_t ) 1 )
+#define portHEAP_PLACE_INTERNAL          ( ( UBaseType_t ) 2 )
+#define portHEAP_PLACE_EXTERNAL          ( ( UBaseType_t ) 3 )
+
 /*
  * Used to define multiple heap regions for use by heap_5.c.  This function
  * must be called before any calls to pvPortMalloc() - not creating a task,
@@ -166,15 +200,72 @@ typedef struct xHeapStats
  * defines a region of memory that can be used as the heap.  The array is
  * terminated by a HeapRegions_t structure that has a size of 0.  The region
  * with the lowest start address must appear first in the array.
+ *
+ * heap_4.c implements it as well if portUSE_HEAP_REGIONS is 1, where the
+ * regions are added to ucHeap at any time and in any order.
  */
 void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions ) PRIVILEGED_FUNCTION;
 
+/*
+ * Used to add a further region of memory to the heap of heap_4.c or
+ * heap_tlsf.c.  Unlike vPortDefineHeapRegions() of heap_5.c it can also be
+ * called while the scheduler is running.  The region can lie anywhere outside
+ * of the heap.
+ */
+void vPortAddHeapRegion( void * pvRegion,
+                         size_t xRegionSize ) PRIVILEGED_FUNCTION;
+
 /*
  * Returns a HeapStats_t structure filled with information about the current
  * heap state.
  */
 void vPortGetHeapStats( HeapStats_t * pxHeapStats );
 
+/*
+ * Fills pxSlabStats with up to uxMaxClasses entries, one per pool of the slab
+ * layer of heap_4.c (portUSE_HEAP_SLABS), in the order of portHEAP_SLAB_SIZES.
+ * Sizes that are equal once aligned share one pool. Returns the number of
+ * entries filled.
+ */
+#if ( portUSE_HEAP_SLABS == 1 )
+    UBaseType_t uxPortGetSlabStats( SlabStats_t * pxSlabStats,
+                                    UBaseType_t uxMaxClasses );
+#endif
+
+/*
+ * With portUSE_HEAP_REGIONS, allocates a block from internal or external
+ * memory as told by uxPlacement, one of the portHEAP_PLACE_* values.
+ * pvPortMalloc() places blocks of portHEAP_EXTERNAL_THRESHOLD bytes or more
+ * externally first, smaller ones internally first, and task stacks and TCBs
+ * are placed as set by portHEAP_TASK_PLACEMENT.
+ *
+ * uxPortGetHeapRegionStats() fills pxRegionStats with up to uxMaxRegions
+ * entries, ucHeap first and the other regions in the order they were added.
+ * Returns the number of entries filled.
+ */
+#if ( portUSE_HEAP_REGIONS == 1 )
+    void * pvPortMallocPlaced( size_t xWantedSize,
+                               UBaseType_t uxPlacement ) PRIVILEGED_FUNCTION;
+    UBaseType_t uxPortGetHeapRegionStats( HeapRegionStats_t * pxRegionStats,
+                                          UBaseType_t uxMaxRegions );
+#endif
+
+/*
+ * With portUSE_HEAP_ISR, pvPortMallocFromISR() takes a block of up to
+ * portHEAP_ISR_BLOCK_SIZE bytes from a reserve of portHEAP_ISR_BLOCKS blocks,
+ * and returns NULL if the reserve is used up.  vPortFreeFromISR() frees any
+ * block from an ISR: blocks of the reserve go straight back, other blocks are
+ * returned to the heap by the next pvPortMalloc() or vPortFree() of a task.
+ * Both can be called from tasks too, and blocks of the reserve can also be
+ * freed with vPortFree().
+ */
+#if ( portUSE_HEAP_ISR == 1 )
+    void * pvPortMallocFromISR( size_t xWantedSize ) PRIVILEGED_FUNCTION;
+    void vPortFreeFromISR( void * pv ) PRIVILEGED_FUNCTION;
+    UBaseType_t uxPortGetIsrPoolFreeBlocks( void );
+    UBaseType_t uxPortGetIsrPoolMinimumEverFreeBlocks( void );
+#endif
+
 /*
  * Map to the memory management routines required for the port.
  */
@@ -182,18 +273,42 @@ void * pvPortMalloc( size_t xWantedSize ) PRIVILEGED_FUNCTION;
 void * pvPortCalloc( size_t xNum,
                      size_t xSize ) PRIVILEGED_FUNCTION;
 void vPortFree( void * pv ) PRIVILEGED_FUNCTION;
+
+/*
+ * Changes the size of a block of heap_4.c or heap_tlsf.c.  The block shrinks
+ * in place, and grows in place into the free blocks next to it, moving the
+ * data down if the free block in front is used.  Only if they are too small a
+ * new block is allocated and the data copied.  Returns NULL and leaves the
+ * block as it is if there is not enough memory.
+ */
+void * pvPortRealloc( void * pv,
+                      size_t xWantedSize ) PRIVILEGED_FUNCTION;
 void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 
+#if ( portUSE_HEAP_REGIONS == 1 ) && !defined( portHEAP_TASK_PLACEMENT )
+    #define portHEAP_TASK_PLACEMENT    portHEAP_PLACE_INTERNAL
+#endif
+
 #if ( configSTACK_ALLOCATION_FROM_SEPARATE_HEAP == 1 )
     void * pvPortMallocStack( size_t xSize ) PRIVILEGED_FUNCTION;
     void vPortFreeStack( void * pv ) PRIVILEGED_FUNCTION;
+#elif ( portUSE_HEAP_REGIONS == 1 )
+    #define pvPortMallocStack( xSize )    pvPortMallocPlaced( ( xSize ), portHEAP_TASK_PLACEMENT )
+    #define vPortFreeStack                vPortFree
 #else
     #define pvPortMallocStack    pvPortMalloc
     #define vPortFreeStack       vPortFree
 #endif
 
+/* The TCBs are placed like the task stacks. */
+#if ( portUSE_HEAP_REGIONS == 1 )
+    #define pvPortMallocTCB( xSize )    pvPortMallocPlaced( ( xSize ), portHEAP_TASK_PLACEMENT )
+#else
+    #define pvPortMallocTCB             pvPortMalloc
+#endif
+
 /*
  * This function resets the internal state of the heap module. It must be called
  * by the application before restarting the scheduler.
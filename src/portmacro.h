@@ -39,6 +39,12 @@
 
     #include "AVR_Mega0/portmacro.h"
 
+#elif defined( FREERTOS_HOST_POSIX )
+
+    /* INFO: Runs the kernel and the sketch as a process on a Linux host, e.g.
+    for profiling and tests without a board. See the Makefile in extras/posix. */
+    #include "POSIX/portmacro.h"
+
 #else
 
     #error "The currently selected board is not supported by this port of FreeRTOS"
@@ -175,6 +175,15 @@ typedef struct xTASK_STATUS
     #if ( ( configUSE_CORE_AFFINITY == 1 ) && ( configNUMBER_OF_CORES > 1 ) )
         UBaseType_t uxCoreAffinityMask;           /* The core affinity mask for the task */
     #endif
+    #if ( configUSE_TASK_SWITCH_STATS == 1 )
+        uint32_t ulBlockCount;                       /* Number of times the task stopped running to block, to be suspended or to be deleted. */
+        uint32_t ulPreemptCount;                     /* Number of times the task stopped running because a higher or equal priority task became ready, while the task itself stayed ready. */
+        uint32_t ulYieldCount;                       /* Number of times the task stopped running by taskYIELD() or vTaskDelay( 0 ). */
+        uint32_t ulISRWakeCount;                     /* Number of times the task was made ready by an interrupt (a ...FromISR() function). */
+        uint32_t ulTickWakeCount;                    /* Number of times the task was made ready by the tick, at the end of a delay or a block time. */
+        uint32_t ulTaskWakeCount;                    /* Number of times the task was made ready by another task (a queue, semaphore, notification, event group, vTaskResume() or xTaskAbortDelay()). */
+        configRUN_TIME_COUNTER_TYPE ulReadyWaitTime; /* The total time the task was ready but not running, as defined by the run time stats clock.  Only valid when configGENERATE_RUN_TIME_STATS is defined as 1 in FreeRTOSConfig.h. */
+    #endif
 } TaskStatus_t;
 
 /* Possible return values for eTaskConfirmSleepModeStatus(). */
@@ -188,6 +197,32 @@ typedef enum
     #endif /* INCLUDE_vTaskSuspend */
 } eSleepModeStatus;
 
+/* Histograms recorded when configUSE_LATENCY_HISTOGRAMS is set to 1, see
+ * vTaskGetLatencyHistogram(). */
+typedef enum
+{
+    eLatencyISRWake = 0,  /* From a ...FromISR() function making a task ready until the task runs. */
+    eLatencyTickWake,     /* From the tick making a delayed task ready until the task runs. */
+    eLatencyTickISR,      /* Duration of the tick interrupt. */
+    eLatencySwitchContext /* Duration of vTaskSwitchContext(). */
+} eLatencyHistogram;
+
+#define tskLATENCY_HISTOGRAMS    ( 4 )
+
+/* Used with vTaskGetLatencyHistogram(). The samples are counted in log2
+ * buckets of portGET_LATENCY_TIMESTAMP() counts: usBuckets[ 0 ] holds the
+ * samples of 0 counts and usBuckets[ n ] the ones of 2^(n-1) up to 2^n - 1
+ * counts, the last bucket also all longer ones. When a bucket would pass
+ * 0xFFFF all buckets are halved, so they keep the shape of the distribution
+ * rather than the number of samples, which is in ulSamples. */
+typedef struct xLATENCY_HISTOGRAM
+{
+    uint32_t ulSamples;                                  /* Number of samples. */
+    uint32_t ulMax;                                      /* Longest sample in counts. */
+    uint32_t ulCountNs;                                  /* Length of one count in nanoseconds. */
+    uint16_t usBuckets[ configLATENCY_HISTOGRAM_BUCKETS ];
+} LatencyHistogram_t;
+
 /**
  * Defines the priority used by the idle task.  This must not be modified.
  *
@@ -210,7 +245,11 @@ typedef enum
  * \defgroup taskYIELD taskYIELD
  * \ingroup SchedulerControl
  */
-#define taskYIELD()                          portYIELD()
+#if ( configUSE_TASK_SWITCH_STATS == 1 )
+    #define taskYIELD()                      do { vTaskCountYield(); portYIELD(); } while( 0 )
+#else
+    #define taskYIELD()                      portYIELD()
+#endif
 
 /**
  * task. h
@@ -1818,6 +1857,12 @@ char * pcTaskGetName( TaskHandle_t xTaskToQuery ) PRIVILEGED_FUNCTION;
  * overflowing on 8-bit types without breaking backward compatibility for
  * applications that expect an 8-bit return type.
  *
+ * The stack is scanned on each call, which takes a time proportional to its
+ * free part.  With configUSE_IDLE_STACK_SCAN set to 1 the idle task keeps the
+ * mark of each task up to date in steps of configIDLE_STACK_SCAN_BYTES, and
+ * the call only returns it, but the mark can then lag behind by one round of
+ * the idle task over all stacks.
+ *
  * @param xTask Handle of the task associated with the stack to be checked.
  * Set xTask to NULL to check the stack of the calling task.
  *
@@ -1945,6 +1990,32 @@ char * pcTaskGetName( TaskHandle_t xTaskToQuery ) PRIVILEGED_FUNCTION;
 
 #endif
 
+#if ( configUSE_IDLE_STACK_SCAN == 1 ) && ( configSTACK_HEADROOM_THRESHOLD > 0 )
+
+/**
+ * task.h
+ * @code{c}
+ * void vApplicationStackHeadroomHook( TaskHandle_t xTask, char *pcTaskName, configSTACK_DEPTH_TYPE uxHighWaterMark );
+ * @endcode
+ *
+ * Called by the idle task each time it finds that the stack high water mark of
+ * a task dropped, if the new mark is below configSTACK_HEADROOM_THRESHOLD
+ * words.  A task that starts below the threshold is reported when its mark
+ * drops the next time.
+ *
+ * NOTE: The hook is called with the scheduler suspended, so it MUST NOT CALL A
+ * FUNCTION THAT MIGHT BLOCK.
+ *
+ * @param xTask The task that came close to overflowing its stack.
+ * @param pcTaskName The name of the task.
+ * @param uxHighWaterMark The new high water mark of the task, in words.
+ */
+    void vApplicationStackHeadroomHook( TaskHandle_t xTask,
+                                        char * pcTaskName,
+                                        configSTACK_DEPTH_TYPE uxHighWaterMark );
+
+#endif
+
 #if ( configUSE_IDLE_HOOK == 1 )
 
 /**
@@ -2495,6 +2566,37 @@ char * pcTaskGetName( TaskHandle_t xTaskToQuery ) PRIVILEGED_FUNCTION;
     configRUN_TIME_COUNTER_TYPE ulTaskGetIdleRunTimePercent( void ) PRIVILEGED_FUNCTION;
 #endif
 
+/**
+ * task. h
+ * @code{c}
+ * void vTaskGetLatencyHistogram( eLatencyHistogram eHistogram, LatencyHistogram_t * pxHistogram, BaseType_t xReset );
+ * uint32_t ulTaskGetLatencyPercentile( const LatencyHistogram_t * pxHistogram, uint8_t ucPercent );
+ * @endcode
+ *
+ * configUSE_LATENCY_HISTOGRAMS must be defined as 1 for these functions to be
+ * available.  The kernel then reads portGET_LATENCY_TIMESTAMP() when a task is
+ * made ready from an ISR or from the tick, when the task is switched in, at
+ * the start and the end of vTaskSwitchContext() and in the tick interrupt of
+ * the port, and counts each duration in a log2 histogram.
+ *
+ * vTaskGetLatencyHistogram() copies the histogram eHistogram into pxHistogram
+ * and clears it if xReset is pdTRUE.
+ *
+ * ulTaskGetLatencyPercentile() returns the upper bound in counts of the bucket
+ * that holds the given percentile (0 to 100) of the samples, or ulMax if that
+ * is lower. Multiply by ulCountNs for nanoseconds.
+ *
+ * \defgroup vTaskGetLatencyHistogram vTaskGetLatencyHistogram
+ * \ingroup TaskUtils
+ */
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+    void vTaskGetLatencyHistogram( eLatencyHistogram eHistogram,
+                                   LatencyHistogram_t * pxHistogram,
+                                   BaseType_t xReset ) PRIVILEGED_FUNCTION;
+    uint32_t ulTaskGetLatencyPercentile( const LatencyHistogram_t * pxHistogram,
+                                         uint8_t ucPercent ) PRIVILEGED_FUNCTION;
+#endif
+
 /**
  * task. h
  * @code{c}
@@ -3561,6 +3663,44 @@ BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList ) PRIVILEG
 void vTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem,
                                         const TickType_t xItemValue ) PRIVILEGED_FUNCTION;
 
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * xTaskRemoveFromEventList() for the ...FromISR() functions, so a task made
+ * ready by it is counted as woken by an ISR in the eLatencyISRWake histogram
+ * and in the switch statistics.
+ */
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 ) || ( configUSE_TASK_SWITCH_STATS == 1 )
+    BaseType_t xTaskRemoveFromEventListFromISR( const List_t * const pxEventList ) PRIVILEGED_FUNCTION;
+#else
+    #define xTaskRemoveFromEventListFromISR( pxEventList )    xTaskRemoveFromEventList( pxEventList )
+#endif
+
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * Called by taskYIELD(), so the next switch away from the calling task is
+ * counted as a yield and not as a preemption.
+ */
+#if ( configUSE_TASK_SWITCH_STATS == 1 )
+    void vTaskCountYield( void ) PRIVILEGED_FUNCTION;
+#endif
+
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS ONLY
+ * INTENDED FOR USE WHEN IMPLEMENTING A PORT OF THE SCHEDULER.
+ *
+ * Counts the time since ulStartTime, a value of portGET_LATENCY_TIMESTAMP(),
+ * in a latency histogram. Used by the tick interrupt of the port for the
+ * eLatencyTickISR histogram.
+ */
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+    void vTaskRecordLatency( eLatencyHistogram eHistogram,
+                             uint32_t ulStartTime ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS ONLY
  * INTENDED FOR USE WHEN IMPLEMENTING A PORT OF THE SCHEDULER AND IS
@@ -127,12 +127,21 @@
 /* If any of the following are set then task stacks are filled with a known
  * value so the high water mark can be determined.  If none of the following are
  * set then don't fill the stack so there is no unnecessary dependency on memset. */
-#if ( ( configCHECK_FOR_STACK_OVERFLOW > 1 ) || ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) )
+#if ( ( configCHECK_FOR_STACK_OVERFLOW > 1 ) || ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) || ( configUSE_IDLE_STACK_SCAN == 1 ) )
     #define tskSET_NEW_STACKS_TO_KNOWN_VALUE    1
 #else
     #define tskSET_NEW_STACKS_TO_KNOWN_VALUE    0
 #endif
 
+/*
+ * The byte of the stack of a task that the high water mark is counted from.
+ */
+#if ( portSTACK_GROWTH < 0 )
+    #define tskSTACK_LIMIT_BYTE( pxTCB )    ( ( const uint8_t * ) ( pxTCB )->pxStack )
+#else
+    #define tskSTACK_LIMIT_BYTE( pxTCB )    ( ( const uint8_t * ) ( pxTCB )->pxEndOfStack )
+#endif
+
 /*
  * Macros used by vListTask to indicate which state a task is in.
  */
@@ -156,6 +165,13 @@
     #define configIDLE_TASK_NAME    "IDLE"
 #endif
 
+/* uxTopReadyPriority is used as a bit map of the ready priorities when port
+ * optimised task selection is used. A port can make it wider than UBaseType_t
+ * to support more priorities than UBaseType_t has bits. */
+#ifndef portTOP_READY_PRIORITY_TYPE
+    #define portTOP_READY_PRIORITY_TYPE    UBaseType_t
+#endif
+
 #if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 0 )
 
 /* If configUSE_PORT_OPTIMISED_TASK_SELECTION is 0 then task selection is
@@ -274,6 +290,74 @@
     } while( 0 )
 /*-----------------------------------------------------------*/
 
+/* What made a task ready, for prvTASK_WOKEN(). The first two are the
+ * eLatencyISRWake and eLatencyTickWake histograms. */
+#define tskWOKEN_BY_ISR     ( ( UBaseType_t ) 0U )
+#define tskWOKEN_BY_TICK    ( ( UBaseType_t ) 1U )
+#define tskWOKEN_BY_TASK    ( ( UBaseType_t ) 2U )
+#define tskWOKEN_SOURCES    ( 3U )
+
+/* Why the task switched out by vTaskSwitchContext() stopped running, for the
+ * switch statistics. */
+#define tskSWITCHED_OUT_BLOCKED      ( 0U )
+#define tskSWITCHED_OUT_PREEMPTED    ( 1U )
+#define tskSWITCHED_OUT_YIELDED      ( 2U )
+#define tskSWITCHED_OUT_REASONS      ( 3U )
+
+/*
+ * Records the time a task is made ready by an ISR or by the tick, so the time
+ * until it runs is counted in the latency histogram of uxSource when it is
+ * switched in.
+ */
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+    #define prvLATENCY_WOKEN( pxTCB, uxSource )                                    \
+        do {                                                                       \
+            if( ( uxSource ) != tskWOKEN_BY_TASK )                                 \
+            {                                                                      \
+                ( pxTCB )->ulLatencyReadyTime = portGET_LATENCY_TIMESTAMP();       \
+                ( pxTCB )->ucLatencyHistogram = ( uint8_t ) ( ( uxSource ) + 1U ); \
+            }                                                                      \
+        } while( 0 )
+#else
+    #define prvLATENCY_WOKEN( pxTCB, uxSource )
+#endif
+
+/*
+ * Counts the wake-up of a task for the switch statistics, and records the
+ * time from which it waits to run.
+ */
+#if ( configUSE_TASK_SWITCH_STATS == 1 )
+    #if ( configGENERATE_RUN_TIME_STATS == 1 )
+        #ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+            #define prvSET_READY_SINCE( pxTCB )    portALT_GET_RUN_TIME_COUNTER_VALUE( ( pxTCB )->ulReadySince )
+        #else
+            #define prvSET_READY_SINCE( pxTCB )    ( pxTCB )->ulReadySince = portGET_RUN_TIME_COUNTER_VALUE()
+        #endif
+    #else
+        #define prvSET_READY_SINCE( pxTCB )
+    #endif
+
+    #define prvSWITCH_STATS_WOKEN( pxTCB, uxSource )    \
+        do {                                            \
+            ( pxTCB )->ulWakeCounts[ uxSource ]++;      \
+            prvSET_READY_SINCE( pxTCB );                \
+        } while( 0 )
+#else
+    #define prvSET_READY_SINCE( pxTCB )
+    #define prvSWITCH_STATS_WOKEN( pxTCB, uxSource )
+#endif
+
+/*
+ * Called where a blocked or suspended task is made ready, by an ISR, the tick
+ * or a task (uxSource is one of the tskWOKEN_BY_... values).
+ */
+#define prvTASK_WOKEN( pxTCB, uxSource )                      \
+    do {                                                      \
+        prvLATENCY_WOKEN( ( pxTCB ), ( uxSource ) );          \
+        prvSWITCH_STATS_WOKEN( ( pxTCB ), ( uxSource ) );     \
+    } while( 0 )
+/*-----------------------------------------------------------*/
+
 /*
  * Several functions take a TaskHandle_t parameter that can optionally be NULL,
  * where NULL is used to indicate that the handle of the currently executing
@@ -411,6 +495,26 @@ typedef struct tskTaskControlBlock       /* The old naming convention is used to
         configRUN_TIME_COUNTER_TYPE ulRunTimeCounter; /**< Stores the amount of time the task has spent in the Running state. */
     #endif
 
+    #if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+        uint32_t ulLatencyReadyTime; /**< Time the task was made ready by an ISR or the tick, see prvLATENCY_WOKEN(). */
+        uint8_t ucLatencyHistogram;  /**< The eLatencyHistogram plus 1 to count the time until the task runs in, 0 for none. */
+    #endif
+
+    #if ( configUSE_TASK_SWITCH_STATS == 1 )
+        uint32_t ulSwitchCounts[ tskSWITCHED_OUT_REASONS ]; /**< Times the task was switched out, per tskSWITCHED_OUT_... reason. */
+        uint32_t ulWakeCounts[ tskWOKEN_SOURCES ];          /**< Times the task was made ready, per tskWOKEN_BY_... source. */
+        #if ( configGENERATE_RUN_TIME_STATS == 1 )
+            configRUN_TIME_COUNTER_TYPE ulReadySince;       /**< Run time counter when the task last became ready without running. */
+            configRUN_TIME_COUNTER_TYPE ulReadyWaitTime;    /**< Time the task has spent ready but not running. */
+        #endif
+        uint8_t ucYieldRequested;                           /**< Set by taskYIELD() and vTaskDelay( 0 ) until the next switch. */
+    #endif
+
+    #if ( configUSE_IDLE_STACK_SCAN == 1 )
+        struct tskTaskControlBlock * pxNextScanTCB;  /**< Next task in the list of all tasks scanned by the idle task. */
+        configSTACK_DEPTH_TYPE uxStackHighWaterMark; /**< High water mark kept up to date by the idle task, see prvScanStacks(). */
+    #endif
+
     #if ( configUSE_C_RUNTIME_TLS_SUPPORT == 1 )
         configTLS_BLOCK_TYPE xTLSBlock; /**< Memory block used as Thread Local Storage (TLS) Block for the task. */
     #endif
@@ -485,7 +589,7 @@ PRIVILEGED_DATA static List_t xPendingReadyList;                         /**< Ta
 /* Other file private variables. --------------------------------*/
 PRIVILEGED_DATA static volatile UBaseType_t uxCurrentNumberOfTasks = ( UBaseType_t ) 0U;
 PRIVILEGED_DATA static volatile TickType_t xTickCount = ( TickType_t ) configINITIAL_TICK_COUNT;
-PRIVILEGED_DATA static volatile UBaseType_t uxTopReadyPriority = tskIDLE_PRIORITY;
+PRIVILEGED_DATA static volatile portTOP_READY_PRIORITY_TYPE uxTopReadyPriority = tskIDLE_PRIORITY;
 PRIVILEGED_DATA static volatile BaseType_t xSchedulerRunning = pdFALSE;
 PRIVILEGED_DATA static volatile TickType_t xPendedTicks = ( TickType_t ) 0U;
 PRIVILEGED_DATA static volatile BaseType_t xYieldPendings[ configNUMBER_OF_CORES ] = { pdFALSE };
@@ -522,6 +626,32 @@ PRIVILEGED_DATA static volatile configRUN_TIME_COUNTER_TYPE ulTotalRunTime[ conf
 
 #endif
 
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+
+/* The histograms of vTaskGetLatencyHistogram(), ulCountNs is only set in the
+ * copies. */
+PRIVILEGED_DATA static LatencyHistogram_t xLatencyHistograms[ tskLATENCY_HISTOGRAMS ];
+
+#endif
+
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 ) || ( configUSE_TASK_SWITCH_STATS == 1 )
+
+/* What makes the tasks ready in xTaskRemoveFromEventList(), tskWOKEN_BY_ISR
+ * while it is called by xTaskRemoveFromEventListFromISR(). */
+PRIVILEGED_DATA static UBaseType_t uxEventListWokenBy = tskWOKEN_BY_TASK;
+
+#endif
+
+#if ( configUSE_IDLE_STACK_SCAN == 1 )
+
+/* All tasks that are not yet freed, the task the idle task scans and the
+ * number of bytes of its stack already scanned. */
+PRIVILEGED_DATA static FreeRTOS_TCB_t * pxScanList = NULL;
+PRIVILEGED_DATA static FreeRTOS_TCB_t * pxScanTCB = NULL;
+PRIVILEGED_DATA static size_t xScanOffset = 0U;
+
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* File private functions. --------------------------------*/
@@ -615,6 +745,17 @@ static portTASK_FUNCTION_PROTO( prvIdleTask, pvParameters ) PRIVILEGED_FUNCTION;
  */
 static void prvCheckTasksWaitingTermination( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * Used only by the idle task.  Checks up to configIDLE_STACK_SCAN_BYTES bytes
+ * of the stack of one task and lowers its cached high water mark if the stack
+ * grew, continuing where the previous call stopped.
+ */
+#if ( configUSE_IDLE_STACK_SCAN == 1 )
+
+    static void prvScanStacks( void ) PRIVILEGED_FUNCTION;
+
+#endif
+
 /*
  * The currently executing task is entering the Blocked state.  Add the task to
  * either the current or the overflow delayed task list.
@@ -654,7 +795,7 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait,
  * This function determines the 'high water mark' of the task stack by
  * determining how much of the stack remains at the original preset value.
  */
-#if ( ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) )
+#if ( ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) || ( configUSE_IDLE_STACK_SCAN == 1 ) )
 
     static configSTACK_DEPTH_TYPE prvTaskCheckFreeStackSpace( const uint8_t * pucStackByte ) PRIVILEGED_FUNCTION;
 
@@ -711,6 +852,15 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
  */
 static void prvAddNewTaskToReadyList( FreeRTOS_TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
 
+/*
+ * Counts a duration of portGET_LATENCY_TIMESTAMP() counts in the latency
+ * histogram uxHistogram. Called with interrupts disabled.
+ */
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+    static void prvRecordLatency( UBaseType_t uxHistogram,
+                                  uint32_t ulDuration ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * Create a task with static buffer for both TCB and stack. Returns a handle to
  * the task if it is created successfully. Otherwise, returns NULL.
@@ -1510,7 +1660,7 @@ static void prvAddNewTaskToReadyList( FreeRTOS_TCB_t * pxNewTCB ) PRIVILEGED_FUN
             /* MISRA Ref 11.5.1 [Malloc memory assignment] */
             /* More details at: https://github.com/FreeRTOS/FreeRTOS-Kernel/blob/main/MISRA.md#rule-115 */
             /* coverity[misra_c_2012_rule_11_5_violation] */
-            pxNewTCB = ( FreeRTOS_TCB_t * ) pvPortMalloc( sizeof( FreeRTOS_TCB_t ) );
+            pxNewTCB = ( FreeRTOS_TCB_t * ) pvPortMallocTCB( sizeof( FreeRTOS_TCB_t ) );
 
             if( pxNewTCB != NULL )
             {
@@ -1637,7 +1787,7 @@ static void prvAddNewTaskToReadyList( FreeRTOS_TCB_t * pxNewTCB ) PRIVILEGED_FUN
             /* MISRA Ref 11.5.1 [Malloc memory assignment] */
             /* More details at: https://github.com/FreeRTOS/FreeRTOS-Kernel/blob/main/MISRA.md#rule-115 */
             /* coverity[misra_c_2012_rule_11_5_violation] */
-            pxNewTCB = ( FreeRTOS_TCB_t * ) pvPortMalloc( sizeof( FreeRTOS_TCB_t ) );
+            pxNewTCB = ( FreeRTOS_TCB_t * ) pvPortMallocTCB( sizeof( FreeRTOS_TCB_t ) );
 
             if( pxNewTCB != NULL )
             {
@@ -1675,7 +1825,7 @@ static void prvAddNewTaskToReadyList( FreeRTOS_TCB_t * pxNewTCB ) PRIVILEGED_FUN
                 /* MISRA Ref 11.5.1 [Malloc memory assignment] */
                 /* More details at: https://github.com/FreeRTOS/FreeRTOS-Kernel/blob/main/MISRA.md#rule-115 */
                 /* coverity[misra_c_2012_rule_11_5_violation] */
-                pxNewTCB = ( FreeRTOS_TCB_t * ) pvPortMalloc( sizeof( FreeRTOS_TCB_t ) );
+                pxNewTCB = ( FreeRTOS_TCB_t * ) pvPortMallocTCB( sizeof( FreeRTOS_TCB_t ) );
 
                 if( pxNewTCB != NULL )
                 {
@@ -2001,6 +2151,14 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
     }
     #endif /* #if ( configNUMBER_OF_CORES > 1 ) */
 
+    #if ( configUSE_IDLE_STACK_SCAN == 1 )
+    {
+        /* Scanned once here, which costs about as much as filling the stack,
+         * so the mark is valid before the idle task gets to the task. */
+        pxNewTCB->uxStackHighWaterMark = prvTaskCheckFreeStackSpace( tskSTACK_LIMIT_BYTE( pxNewTCB ) );
+    }
+    #endif
+
     if( pxCreatedTask != NULL )
     {
         /* Pass the handle out in an anonymous way.  The handle can be used to
@@ -2074,6 +2232,14 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
             #endif /* configUSE_TRACE_FACILITY */
             traceTASK_CREATE( pxNewTCB );
 
+            #if ( configUSE_IDLE_STACK_SCAN == 1 )
+            {
+                pxNewTCB->pxNextScanTCB = pxScanList;
+                pxScanList = pxNewTCB;
+            }
+            #endif
+
+            prvSET_READY_SINCE( pxNewTCB );
             prvAddTaskToReadyList( pxNewTCB );
 
             portSETUP_TCB( pxNewTCB );
@@ -2460,7 +2626,16 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
         }
         else
         {
-            mtCOVERAGE_TEST_MARKER();
+            /* Counted as a yield by the switch statistics. */
+            #if ( configUSE_TASK_SWITCH_STATS == 1 )
+            {
+                pxCurrentTCB->ucYieldRequested = ( uint8_t ) pdTRUE;
+            }
+            #else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+            #endif
         }
 
         /* Force a reschedule if xTaskResumeAll has not already done so, we may
@@ -3383,6 +3558,7 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
                     /* The ready list can be accessed even if the scheduler is
                      * suspended because this is inside a critical section. */
                     ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                    prvTASK_WOKEN( pxTCB, tskWOKEN_BY_TASK );
                     prvAddTaskToReadyList( pxTCB );
 
                     /* This yield may not cause the task just resumed to run,
@@ -3448,6 +3624,8 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
             {
                 traceTASK_RESUME_FROM_ISR( pxTCB );
 
+                prvTASK_WOKEN( pxTCB, tskWOKEN_BY_ISR );
+
                 /* Check the ready lists can be accessed. */
                 if( uxSchedulerSuspended == ( UBaseType_t ) 0U )
                 {
@@ -4594,6 +4772,7 @@ BaseType_t xTaskCatchUpTicks( TickType_t xTicksToCatchUp )
                  * interrupt won't touch the xStateListItem because the
                  * scheduler is suspended. */
                 ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                prvTASK_WOKEN( pxTCB, tskWOKEN_BY_TASK );
 
                 /* Is the task waiting on an event also?  If so remove it from
                  * the event list too.  Interrupts can touch the event list item,
@@ -4769,6 +4948,7 @@ BaseType_t xTaskIncrementTick( void )
                     /* Place the unblocked task into the appropriate ready
                      * list. */
                     prvAddTaskToReadyList( pxTCB );
+                    prvTASK_WOKEN( pxTCB, tskWOKEN_BY_TICK );
 
                     /* A task being unblocked cannot cause an immediate
                      * context switch if preemption is turned off. */
@@ -5055,6 +5235,14 @@ BaseType_t xTaskIncrementTick( void )
 #if ( configNUMBER_OF_CORES == 1 )
     void vTaskSwitchContext( void )
     {
+        #if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+            const uint32_t ulSwitchStart = portGET_LATENCY_TIMESTAMP();
+        #endif
+
+        #if ( configUSE_TASK_SWITCH_STATS == 1 )
+            FreeRTOS_TCB_t * const pxPreviousTCB = pxCurrentTCB;
+        #endif
+
         traceENTER_vTaskSwitchContext();
 
         if( uxSchedulerSuspended != ( UBaseType_t ) 0U )
@@ -5133,6 +5321,70 @@ BaseType_t xTaskIncrementTick( void )
                 configSET_TLS_BLOCK( pxCurrentTCB->xTLSBlock );
             }
             #endif
+
+            #if ( configUSE_TASK_SWITCH_STATS == 1 )
+            {
+                if( pxCurrentTCB != pxPreviousTCB )
+                {
+                    /* A task still in its ready list was preempted, or gave
+                     * way by a yield. Any other task left the ready list to
+                     * block, to be suspended or to be deleted. */
+                    if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxPreviousTCB->uxPriority ] ),
+                                                 &( pxPreviousTCB->xStateListItem ) ) != pdFALSE )
+                    {
+                        if( pxPreviousTCB->ucYieldRequested != ( uint8_t ) pdFALSE )
+                        {
+                            pxPreviousTCB->ulSwitchCounts[ tskSWITCHED_OUT_YIELDED ]++;
+                        }
+                        else
+                        {
+                            pxPreviousTCB->ulSwitchCounts[ tskSWITCHED_OUT_PREEMPTED ]++;
+                        }
+
+                        #if ( configGENERATE_RUN_TIME_STATS == 1 )
+                        {
+                            pxPreviousTCB->ulReadySince = ulTotalRunTime[ 0 ];
+                        }
+                        #endif
+                    }
+                    else
+                    {
+                        pxPreviousTCB->ulSwitchCounts[ tskSWITCHED_OUT_BLOCKED ]++;
+                    }
+
+                    #if ( configGENERATE_RUN_TIME_STATS == 1 )
+                    {
+                        pxCurrentTCB->ulReadyWaitTime += ( ulTotalRunTime[ 0 ] - pxCurrentTCB->ulReadySince );
+                    }
+                    #endif
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                /* A yield that did not switch to another task is not counted
+                 * for a later switch. */
+                pxPreviousTCB->ucYieldRequested = ( uint8_t ) pdFALSE;
+            }
+            #endif /* configUSE_TASK_SWITCH_STATS */
+
+            #if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+            {
+                const uint32_t ulSwitchEnd = portGET_LATENCY_TIMESTAMP();
+
+                /* Count the time since the task was made ready by an ISR or
+                 * the tick, if it was. */
+                if( pxCurrentTCB->ucLatencyHistogram != 0U )
+                {
+                    prvRecordLatency( ( UBaseType_t ) pxCurrentTCB->ucLatencyHistogram - 1U,
+                                      ulSwitchEnd - pxCurrentTCB->ulLatencyReadyTime );
+                    pxCurrentTCB->ucLatencyHistogram = 0U;
+                }
+
+                prvRecordLatency( ( UBaseType_t ) eLatencySwitchContext, ulSwitchEnd - ulSwitchStart );
+            }
+            #endif
         }
 
         traceRETURN_vTaskSwitchContext();
@@ -5364,6 +5616,7 @@ BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList )
     pxUnblockedTCB = listGET_OWNER_OF_HEAD_ENTRY( pxEventList );
     configASSERT( pxUnblockedTCB );
     listREMOVE_ITEM( &( pxUnblockedTCB->xEventListItem ) );
+    prvTASK_WOKEN( pxUnblockedTCB, uxEventListWokenBy );
 
     if( uxSchedulerSuspended == ( UBaseType_t ) 0U )
     {
@@ -5431,6 +5684,36 @@ BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 ) || ( configUSE_TASK_SWITCH_STATS == 1 )
+
+    BaseType_t xTaskRemoveFromEventListFromISR( const List_t * const pxEventList )
+    {
+        BaseType_t xReturn;
+
+        /* Called with interrupts masked, so no other call can see the
+         * source. */
+        uxEventListWokenBy = tskWOKEN_BY_ISR;
+        xReturn = xTaskRemoveFromEventList( pxEventList );
+        uxEventListWokenBy = tskWOKEN_BY_TASK;
+
+        return xReturn;
+    }
+
+#endif /* if ( configUSE_LATENCY_HISTOGRAMS == 1 ) || ( configUSE_TASK_SWITCH_STATS == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TASK_SWITCH_STATS == 1 )
+
+    void vTaskCountYield( void )
+    {
+        /* Only the running task writes its own flag, cleared again by the
+         * next vTaskSwitchContext(). */
+        pxCurrentTCB->ucYieldRequested = ( uint8_t ) pdTRUE;
+    }
+
+#endif /* configUSE_TASK_SWITCH_STATS */
+/*-----------------------------------------------------------*/
+
 void vTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem,
                                         const TickType_t xItemValue )
 {
@@ -5453,6 +5736,7 @@ void vTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem,
     pxUnblockedTCB = listGET_LIST_ITEM_OWNER( pxEventListItem );
     configASSERT( pxUnblockedTCB );
     listREMOVE_ITEM( pxEventListItem );
+    prvTASK_WOKEN( pxUnblockedTCB, tskWOKEN_BY_TASK );
 
     #if ( configUSE_TICKLESS_IDLE != 0 )
     {
@@ -5758,6 +6042,10 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
      * any. */
     portALLOCATE_SECURE_CONTEXT( configMINIMAL_SECURE_STACK_SIZE );
 
+    /* Port specific work once the scheduler is running, e.g. reclaiming the
+     * stack of main(). */
+    portIDLE_TASK_STARTUP();
+
     #if ( configNUMBER_OF_CORES > 1 )
     {
         /* SMP all cores start up in the idle task. This initial yield gets the application
@@ -5772,6 +6060,12 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
          * is responsible for freeing the deleted task's TCB and stack. */
         prvCheckTasksWaitingTermination();
 
+        #if ( configUSE_IDLE_STACK_SCAN == 1 )
+        {
+            prvScanStacks();
+        }
+        #endif
+
         #if ( configUSE_PREEMPTION == 0 )
         {
             /* If we are not using preemption we keep forcing a task switch to
@@ -6166,6 +6460,27 @@ static void prvCheckTasksWaitingTermination( void )
         }
         #endif
 
+        #if ( configUSE_TASK_SWITCH_STATS == 1 )
+        {
+            pxTaskStatus->ulBlockCount = pxTCB->ulSwitchCounts[ tskSWITCHED_OUT_BLOCKED ];
+            pxTaskStatus->ulPreemptCount = pxTCB->ulSwitchCounts[ tskSWITCHED_OUT_PREEMPTED ];
+            pxTaskStatus->ulYieldCount = pxTCB->ulSwitchCounts[ tskSWITCHED_OUT_YIELDED ];
+            pxTaskStatus->ulISRWakeCount = pxTCB->ulWakeCounts[ tskWOKEN_BY_ISR ];
+            pxTaskStatus->ulTickWakeCount = pxTCB->ulWakeCounts[ tskWOKEN_BY_TICK ];
+            pxTaskStatus->ulTaskWakeCount = pxTCB->ulWakeCounts[ tskWOKEN_BY_TASK ];
+
+            #if ( configGENERATE_RUN_TIME_STATS == 1 )
+            {
+                pxTaskStatus->ulReadyWaitTime = pxTCB->ulReadyWaitTime;
+            }
+            #else
+            {
+                pxTaskStatus->ulReadyWaitTime = ( configRUN_TIME_COUNTER_TYPE ) 0;
+            }
+            #endif
+        }
+        #endif /* configUSE_TASK_SWITCH_STATS */
+
         /* Obtaining the task state is a little fiddly, so is only done if the
          * value of eState passed into this function is eInvalid - otherwise the
          * state is just set to whatever is passed in. */
@@ -6242,7 +6557,11 @@ static void prvCheckTasksWaitingTermination( void )
          * parameter is provided to allow it to be skipped. */
         if( xGetFreeStackSpace != pdFALSE )
         {
-            #if ( portSTACK_GROWTH > 0 )
+            #if ( configUSE_IDLE_STACK_SCAN == 1 )
+            {
+                pxTaskStatus->usStackHighWaterMark = pxTCB->uxStackHighWaterMark;
+            }
+            #elif ( portSTACK_GROWTH > 0 )
             {
                 pxTaskStatus->usStackHighWaterMark = prvTaskCheckFreeStackSpace( ( uint8_t * ) pxTCB->pxEndOfStack );
             }
@@ -6302,7 +6621,7 @@ static void prvCheckTasksWaitingTermination( void )
 #endif /* configUSE_TRACE_FACILITY */
 /*-----------------------------------------------------------*/
 
-#if ( ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) )
+#if ( ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) || ( configUSE_IDLE_STACK_SCAN == 1 ) )
 
     static configSTACK_DEPTH_TYPE prvTaskCheckFreeStackSpace( const uint8_t * pucStackByte )
     {
@@ -6319,7 +6638,80 @@ static void prvCheckTasksWaitingTermination( void )
         return uxCount;
     }
 
-#endif /* ( ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) ) */
+#endif /* ( ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) || ( configUSE_IDLE_STACK_SCAN == 1 ) ) */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_IDLE_STACK_SCAN == 1 )
+
+    static void prvScanStacks( void )
+    {
+        /** THIS FUNCTION IS CALLED FROM THE RTOS IDLE TASK **/
+
+        const uint8_t * pucStackByte;
+        size_t xLimit;
+        size_t xBytes = ( size_t ) configIDLE_STACK_SCAN_BYTES;
+
+        /* The stack is only read, but the scheduler is suspended so the task
+         * cannot be deleted meanwhile.  The high water mark is the number of
+         * bytes from the end of the stack that still hold the fill byte, which
+         * can only get smaller, so only the bytes below the cached mark have to
+         * be checked again.  A pass that gets to the cached mark without
+         * finding a written byte leaves the mark as it is. */
+        vTaskSuspendAll();
+        {
+            if( pxScanTCB == NULL )
+            {
+                pxScanTCB = pxScanList;
+                xScanOffset = 0U;
+            }
+
+            if( pxScanTCB != NULL )
+            {
+                xLimit = ( size_t ) pxScanTCB->uxStackHighWaterMark * sizeof( StackType_t );
+                #if ( portSTACK_GROWTH < 0 )
+                {
+                    pucStackByte = tskSTACK_LIMIT_BYTE( pxScanTCB ) + xScanOffset;
+                }
+                #else
+                {
+                    pucStackByte = tskSTACK_LIMIT_BYTE( pxScanTCB ) - xScanOffset;
+                }
+                #endif
+
+                while( ( xBytes > 0U ) && ( xScanOffset < xLimit ) && ( *pucStackByte == ( uint8_t ) tskSTACK_FILL_BYTE ) )
+                {
+                    pucStackByte -= portSTACK_GROWTH;
+                    xScanOffset++;
+                    xBytes--;
+                }
+
+                if( xBytes > 0U )
+                {
+                    /* Either the cached mark or a written byte was reached, so
+                     * the task is done. */
+                    if( xScanOffset < xLimit )
+                    {
+                        pxScanTCB->uxStackHighWaterMark = ( configSTACK_DEPTH_TYPE ) ( xScanOffset / sizeof( StackType_t ) );
+
+                        #if ( configSTACK_HEADROOM_THRESHOLD > 0 )
+                        {
+                            if( pxScanTCB->uxStackHighWaterMark < ( configSTACK_DEPTH_TYPE ) configSTACK_HEADROOM_THRESHOLD )
+                            {
+                                vApplicationStackHeadroomHook( ( TaskHandle_t ) pxScanTCB, pxScanTCB->pcTaskName, pxScanTCB->uxStackHighWaterMark );
+                            }
+                        }
+                        #endif
+                    }
+
+                    pxScanTCB = pxScanTCB->pxNextScanTCB;
+                    xScanOffset = 0U;
+                }
+            }
+        }
+        ( void ) xTaskResumeAll();
+    }
+
+#endif /* configUSE_IDLE_STACK_SCAN */
 /*-----------------------------------------------------------*/
 
 #if ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 )
@@ -6356,7 +6748,16 @@ static void prvCheckTasksWaitingTermination( void )
         }
         #endif
 
-        uxReturn = prvTaskCheckFreeStackSpace( pucEndOfStack );
+        #if ( configUSE_IDLE_STACK_SCAN == 1 )
+        {
+            ( void ) pucEndOfStack;
+            uxReturn = pxTCB->uxStackHighWaterMark;
+        }
+        #else
+        {
+            uxReturn = prvTaskCheckFreeStackSpace( pucEndOfStack );
+        }
+        #endif
 
         traceRETURN_uxTaskGetStackHighWaterMark2( uxReturn );
 
@@ -6388,7 +6789,16 @@ static void prvCheckTasksWaitingTermination( void )
         }
         #endif
 
-        uxReturn = ( UBaseType_t ) prvTaskCheckFreeStackSpace( pucEndOfStack );
+        #if ( configUSE_IDLE_STACK_SCAN == 1 )
+        {
+            ( void ) pucEndOfStack;
+            uxReturn = ( UBaseType_t ) pxTCB->uxStackHighWaterMark;
+        }
+        #else
+        {
+            uxReturn = ( UBaseType_t ) prvTaskCheckFreeStackSpace( pucEndOfStack );
+        }
+        #endif
 
         traceRETURN_uxTaskGetStackHighWaterMark( uxReturn );
 
@@ -6407,6 +6817,31 @@ static void prvCheckTasksWaitingTermination( void )
          * want to allocate and clean RAM statically. */
         portCLEAN_UP_TCB( pxTCB );
 
+        #if ( configUSE_IDLE_STACK_SCAN == 1 )
+        {
+            FreeRTOS_TCB_t ** ppxLink = &pxScanList;
+
+            /* The idle task scans with the scheduler suspended, so the task
+             * is not removed while its stack is read. */
+            taskENTER_CRITICAL();
+            {
+                while( *ppxLink != pxTCB )
+                {
+                    ppxLink = &( ( *ppxLink )->pxNextScanTCB );
+                }
+
+                *ppxLink = pxTCB->pxNextScanTCB;
+
+                if( pxScanTCB == pxTCB )
+                {
+                    pxScanTCB = pxTCB->pxNextScanTCB;
+                    xScanOffset = 0U;
+                }
+            }
+            taskEXIT_CRITICAL();
+        }
+        #endif /* configUSE_IDLE_STACK_SCAN */
+
         #if ( configUSE_C_RUNTIME_TLS_SUPPORT == 1 )
         {
             /* Free up the memory allocated for the task's TLS Block. */
@@ -7907,6 +8342,7 @@ TickType_t uxTaskResetEventItemValue( void )
             if( ucOriginalNotifyState == taskWAITING_NOTIFICATION )
             {
                 listREMOVE_ITEM( &( pxTCB->xStateListItem ) );
+                prvTASK_WOKEN( pxTCB, tskWOKEN_BY_TASK );
                 prvAddTaskToReadyList( pxTCB );
 
                 /* The task should not have been on an event list. */
@@ -8051,6 +8487,8 @@ TickType_t uxTaskResetEventItemValue( void )
                 /* The task should not have been on an event list. */
                 configASSERT( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) == NULL );
 
+                prvTASK_WOKEN( pxTCB, tskWOKEN_BY_ISR );
+
                 if( uxSchedulerSuspended == ( UBaseType_t ) 0U )
                 {
                     listREMOVE_ITEM( &( pxTCB->xStateListItem ) );
@@ -8169,6 +8607,8 @@ TickType_t uxTaskResetEventItemValue( void )
                 /* The task should not have been on an event list. */
                 configASSERT( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) == NULL );
 
+                prvTASK_WOKEN( pxTCB, tskWOKEN_BY_ISR );
+
                 if( uxSchedulerSuspended == ( UBaseType_t ) 0U )
                 {
                     listREMOVE_ITEM( &( pxTCB->xStateListItem ) );
@@ -8412,6 +8852,130 @@ TickType_t uxTaskResetEventItemValue( void )
 #endif /* if ( ( configGENERATE_RUN_TIME_STATS == 1 ) && ( INCLUDE_xTaskGetIdleTaskHandle == 1 ) ) */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_LATENCY_HISTOGRAMS == 1 )
+
+    static void prvRecordLatency( UBaseType_t uxHistogram,
+                                  uint32_t ulDuration )
+    {
+        LatencyHistogram_t * const pxHistogram = &( xLatencyHistograms[ uxHistogram ] );
+        UBaseType_t uxBucket = 0;
+        UBaseType_t x;
+        uint32_t ulRemaining = ulDuration;
+
+        /* The bucket is the number of significant bits of the duration. */
+        while( ( ulRemaining != 0U ) && ( uxBucket < ( UBaseType_t ) ( configLATENCY_HISTOGRAM_BUCKETS - 1 ) ) )
+        {
+            ulRemaining >>= 1;
+            uxBucket++;
+        }
+
+        /* Halve all buckets before one overflows, so the ratios between them
+         * stay right.  Rounded up, so no bucket with samples becomes empty. */
+        if( pxHistogram->usBuckets[ uxBucket ] == UINT16_MAX )
+        {
+            for( x = 0; x < ( UBaseType_t ) configLATENCY_HISTOGRAM_BUCKETS; x++ )
+            {
+                pxHistogram->usBuckets[ x ] = ( uint16_t ) ( ( pxHistogram->usBuckets[ x ] + 1U ) >> 1 );
+            }
+        }
+
+        pxHistogram->usBuckets[ uxBucket ]++;
+
+        if( ulDuration > pxHistogram->ulMax )
+        {
+            pxHistogram->ulMax = ulDuration;
+        }
+
+        pxHistogram->ulSamples++;
+    }
+/*-----------------------------------------------------------*/
+
+    void vTaskRecordLatency( eLatencyHistogram eHistogram,
+                             uint32_t ulStartTime )
+    {
+        UBaseType_t uxSavedInterruptStatus;
+
+        uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+        {
+            prvRecordLatency( ( UBaseType_t ) eHistogram, portGET_LATENCY_TIMESTAMP() - ulStartTime );
+        }
+        portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+    }
+/*-----------------------------------------------------------*/
+
+    void vTaskGetLatencyHistogram( eLatencyHistogram eHistogram,
+                                   LatencyHistogram_t * pxHistogram,
+                                   BaseType_t xReset )
+    {
+        configASSERT( ( UBaseType_t ) eHistogram < ( UBaseType_t ) tskLATENCY_HISTOGRAMS );
+        configASSERT( pxHistogram );
+
+        taskENTER_CRITICAL();
+        {
+            *pxHistogram = xLatencyHistograms[ eHistogram ];
+
+            if( xReset != pdFALSE )
+            {
+                ( void ) memset( &( xLatencyHistograms[ eHistogram ] ), 0x00, sizeof( LatencyHistogram_t ) );
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        pxHistogram->ulCountNs = ( uint32_t ) portLATENCY_COUNT_NS;
+    }
+/*-----------------------------------------------------------*/
+
+    uint32_t ulTaskGetLatencyPercentile( const LatencyHistogram_t * pxHistogram,
+                                         uint8_t ucPercent )
+    {
+        uint32_t ulTarget;
+        uint32_t ulCount = 0;
+        uint32_t ulBound;
+        UBaseType_t uxBucket;
+
+        configASSERT( pxHistogram );
+
+        /* The buckets are halved when one fills, so the total is taken from
+         * them rather than from ulSamples. */
+        for( uxBucket = 0; uxBucket < ( UBaseType_t ) configLATENCY_HISTOGRAM_BUCKETS; uxBucket++ )
+        {
+            ulCount += pxHistogram->usBuckets[ uxBucket ];
+        }
+
+        if( ulCount == 0U )
+        {
+            return 0U;
+        }
+
+        /* Rounded up, so the 50th percentile of 3 samples is the second. */
+        ulTarget = ( ( ulCount * ( uint32_t ) ucPercent ) + 99U ) / 100U;
+
+        if( ulTarget == 0U )
+        {
+            ulTarget = 1U;
+        }
+
+        ulCount = 0;
+
+        for( uxBucket = 0; uxBucket < ( UBaseType_t ) ( configLATENCY_HISTOGRAM_BUCKETS - 1 ); uxBucket++ )
+        {
+            ulCount += pxHistogram->usBuckets[ uxBucket ];
+
+            if( ulCount >= ulTarget )
+            {
+                ulBound = ( uxBucket == 0U ) ? 0U : ( ( ( uint32_t ) 1U << uxBucket ) - 1U );
+
+                return ( ulBound < pxHistogram->ulMax ) ? ulBound : pxHistogram->ulMax;
+            }
+        }
+
+        /* In the last bucket, which has no upper bound. */
+        return pxHistogram->ulMax;
+    }
+
+#endif /* configUSE_LATENCY_HISTOGRAMS */
+/*-----------------------------------------------------------*/
+
 static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait,
                                             const BaseType_t xCanBlockIndefinitely )
 {
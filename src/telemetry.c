@@ -0,0 +1,316 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        telemetry.c
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Binary snapshots of the tasks, the heap and the queues, sent
+ *              periodically by a low priority task, see telemetry.h.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#if ( portUSE_TELEMETRY == 1 )
+
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TRACE_FACILITY != 1 )
+    #error "portUSE_TELEMETRY needs configUSE_TRACE_FACILITY set to 1."
+#endif
+
+#if ( configSUPPORT_DYNAMIC_ALLOCATION != 1 )
+    #error "portUSE_TELEMETRY needs configSUPPORT_DYNAMIC_ALLOCATION set to 1."
+#endif
+
+#ifndef portTELEMETRY_PRIORITY
+    #define portTELEMETRY_PRIORITY      ( tskIDLE_PRIORITY + 1 )
+#endif
+
+#ifndef portTELEMETRY_STACK_SIZE
+    #define portTELEMETRY_STACK_SIZE    ( configMINIMAL_STACK_SIZE + 64 )
+#endif
+
+/* Bytes collected before they are passed to the write function. */
+#define tlmBUFFER_SIZE          ( 32U )
+
+/* Size of the parts of the payload without the names. */
+#define tlmSYSTEM_SIZE          ( 4U + 2U + 4U + 4U + 4U + 1U + 1U )
+#define tlmTASK_SIZE            ( 2U + 1U + 1U + 1U + 4U + 4U + 1U )
+#define tlmQUEUE_SIZE           ( 2U + 2U + 1U )
+
+/*-----------------------------------------------------------*/
+
+typedef struct TelemetryQueue
+{
+    QueueHandle_t xQueue;
+    const char * pcName;
+} TelemetryQueue_t;
+
+static TelemetryWrite_t pxWriteFunction = NULL;
+
+static TelemetryQueue_t xQueues[ portTELEMETRY_MAX_QUEUES ];
+static UBaseType_t uxQueueCount = 0;
+
+/* Kept static, as it is too large for the stack of the task on the AVR. */
+static TaskStatus_t xTaskStatus[ portTELEMETRY_MAX_TASKS ];
+
+static uint8_t ucBuffer[ tlmBUFFER_SIZE ];
+static size_t xBuffered = 0;
+
+/* Fletcher-16 sums of the payload. */
+static uint16_t usSum1 = 0;
+static uint16_t usSum2 = 0;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Sends a frame every portTELEMETRY_PERIOD_MS.
+ */
+static void prvTelemetryTask( void * pvParameters );
+
+/*
+ * Sends one frame.
+ */
+static void prvSendFrame( void );
+
+/*
+ * Appends bytes of the frame to the buffer, passing it to the write function
+ * when it is full. xChecksum selects whether they count for the checksum.
+ */
+static void prvPut( const uint8_t * pucData,
+                    size_t xLength,
+                    BaseType_t xChecksum );
+
+/*
+ * Appends a value of ucSize bytes, little endian, and counts it for the
+ * checksum.
+ */
+static void prvPutValue( uint32_t ulValue,
+                         uint8_t ucSize );
+
+/*
+ * Appends the length and the characters of a name, and counts them for the
+ * checksum.
+ */
+static void prvPutName( const char * pcName );
+
+/*
+ * Returns the length a name is sent with.
+ */
+static uint8_t prvNameLength( const char * pcName );
+
+/*-----------------------------------------------------------*/
+
+static void prvPut( const uint8_t * pucData,
+                    size_t xLength,
+                    BaseType_t xChecksum )
+{
+    for( size_t x = 0; x < xLength; x++ )
+    {
+        if( xChecksum != pdFALSE )
+        {
+            usSum1 = ( uint16_t ) ( ( usSum1 + pucData[ x ] ) % 255U );
+            usSum2 = ( uint16_t ) ( ( usSum2 + usSum1 ) % 255U );
+        }
+
+        ucBuffer[ xBuffered++ ] = pucData[ x ];
+
+        if( xBuffered == tlmBUFFER_SIZE )
+        {
+            pxWriteFunction( ucBuffer, xBuffered );
+            xBuffered = 0;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutValue( uint32_t ulValue,
+                         uint8_t ucSize )
+{
+    uint8_t ucBytes[ 4 ];
+
+    for( uint8_t x = 0; x < ucSize; x++ )
+    {
+        ucBytes[ x ] = ( uint8_t ) ( ulValue >> ( 8U * x ) );
+    }
+
+    prvPut( ucBytes, ucSize, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvNameLength( const char * pcName )
+{
+    uint8_t ucLength = 0;
+
+    if( pcName != NULL )
+    {
+        while( ( ucLength < configMAX_TASK_NAME_LEN ) && ( pcName[ ucLength ] != '\0' ) )
+        {
+            ucLength++;
+        }
+    }
+
+    return ucLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutName( const char * pcName )
+{
+    const uint8_t ucLength = prvNameLength( pcName );
+
+    prvPutValue( ucLength, 1 );
+    prvPut( ( const uint8_t * ) pcName, ucLength, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendFrame( void )
+{
+    static const uint8_t ucMagic[ 5 ] = { 'F', 'R', 'T', 'M', tlmFORMAT_VERSION };
+    configRUN_TIME_COUNTER_TYPE ulTotalRunTime = 0;
+    UBaseType_t uxTasks;
+    UBaseType_t uxQueues;
+    uint16_t usLength;
+
+    /* Returns 0 if there are more than portTELEMETRY_MAX_TASKS tasks, the
+     * frame then has no tasks. */
+    uxTasks = uxTaskGetSystemState( xTaskStatus, portTELEMETRY_MAX_TASKS, &ulTotalRunTime );
+
+    /* Queues added by other tasks in the meantime are left for the next
+     * frame. */
+    uxQueues = uxQueueCount;
+
+    usLength = tlmSYSTEM_SIZE;
+
+    for( UBaseType_t x = 0; x < uxTasks; x++ )
+    {
+        usLength += tlmTASK_SIZE + prvNameLength( xTaskStatus[ x ].pcTaskName );
+    }
+
+    for( UBaseType_t x = 0; x < uxQueues; x++ )
+    {
+        usLength += tlmQUEUE_SIZE + prvNameLength( xQueues[ x ].pcName );
+    }
+
+    prvPut( ucMagic, sizeof( ucMagic ), pdFALSE );
+    {
+        const uint8_t ucLength[ 2 ] = { ( uint8_t ) usLength, ( uint8_t ) ( usLength >> 8 ) };
+
+        prvPut( ucLength, sizeof( ucLength ), pdFALSE );
+    }
+
+    usSum1 = 0;
+    usSum2 = 0;
+
+    prvPutValue( xTaskGetTickCount(), 4 );
+    prvPutValue( configTICK_RATE_HZ, 2 );
+    prvPutValue( ( uint32_t ) ulTotalRunTime, 4 );
+    prvPutValue( ( uint32_t ) xPortGetFreeHeapSize(), 4 );
+    prvPutValue( ( uint32_t ) xPortGetMinimumEverFreeHeapSize(), 4 );
+
+    prvPutValue( uxTasks, 1 );
+
+    for( UBaseType_t x = 0; x < uxTasks; x++ )
+    {
+        const TaskStatus_t * const pxStatus = &( xTaskStatus[ x ] );
+
+        prvPutValue( pxStatus->xTaskNumber, 2 );
+        prvPutValue( pxStatus->eCurrentState, 1 );
+        prvPutValue( pxStatus->uxCurrentPriority, 1 );
+        prvPutValue( pxStatus->uxBasePriority, 1 );
+        prvPutValue( ( uint32_t ) pxStatus->usStackHighWaterMark * sizeof( StackType_t ), 4 );
+        prvPutValue( ( uint32_t ) pxStatus->ulRunTimeCounter, 4 );
+        prvPutName( pxStatus->pcTaskName );
+    }
+
+    prvPutValue( uxQueues, 1 );
+
+    for( UBaseType_t x = 0; x < uxQueues; x++ )
+    {
+        prvPutValue( uxQueueMessagesWaiting( xQueues[ x ].xQueue ), 2 );
+        prvPutValue( uxQueueSpacesAvailable( xQueues[ x ].xQueue ), 2 );
+        prvPutName( xQueues[ x ].pcName );
+    }
+
+    {
+        const uint8_t ucChecksum[ 2 ] = { ( uint8_t ) usSum1, ( uint8_t ) usSum2 };
+
+        prvPut( ucChecksum, sizeof( ucChecksum ), pdFALSE );
+    }
+
+    if( xBuffered != 0 )
+    {
+        pxWriteFunction( ucBuffer, xBuffered );
+        xBuffered = 0;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTelemetryTask( void * pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        prvSendFrame();
+        vTaskDelayUntil( &xLastWakeTime, pdMS_TO_TICKS( portTELEMETRY_PERIOD_MS ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+int xTelemetryStart( TelemetryWrite_t pxWrite )
+{
+    configASSERT( pxWrite != NULL );
+    configASSERT( pxWriteFunction == NULL );
+
+    pxWriteFunction = pxWrite;
+
+    if( xTaskCreate( prvTelemetryTask, "Telemetry", portTELEMETRY_STACK_SIZE, NULL,
+                     portTELEMETRY_PRIORITY, NULL ) != pdPASS )
+    {
+        pxWriteFunction = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+/*-----------------------------------------------------------*/
+
+int xTelemetryAddQueue( void * pvQueue,
+                        const char * pcName )
+{
+    int xReturn = 0;
+
+    configASSERT( pvQueue != NULL );
+
+    taskENTER_CRITICAL();
+    {
+        if( uxQueueCount < portTELEMETRY_MAX_QUEUES )
+        {
+            xQueues[ uxQueueCount ].xQueue = ( QueueHandle_t ) pvQueue;
+            xQueues[ uxQueueCount ].pcName = pcName;
+            uxQueueCount++;
+            xReturn = 1;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* portUSE_TELEMETRY */
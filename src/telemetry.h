@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        telemetry.h
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Binary snapshots of the tasks, the heap and the queues, sent
+ *              periodically by a low priority task. Enabled with
+ *              portUSE_TELEMETRY in FreeRTOSConfig.h, which then includes this
+ *              file.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Every portTELEMETRY_PERIOD_MS the telemetry task sends one frame through
+ * the write function given to xTelemetryStart(), e.g. to Serial. All values
+ * are little endian:
+ *
+ *   char     magic[ 4 ]      "FRTM"
+ *   uint8_t  version         tlmFORMAT_VERSION
+ *   uint16_t length          of the payload
+ *   payload
+ *   uint16_t checksum        Fletcher-16 of the payload
+ *
+ * The payload is the system part, then one part per task and per queue:
+ *
+ *   uint32_t tick count
+ *   uint16_t configTICK_RATE_HZ
+ *   uint32_t total run time     run time counter, 0 without
+ *                               configGENERATE_RUN_TIME_STATS
+ *   uint32_t free heap          bytes, both 0 without dynamic allocation
+ *   uint32_t minimum free heap
+ *   uint8_t  number of tasks
+ *     uint16_t task number      uxTaskNumber, unique per task
+ *     uint8_t  state            eTaskState
+ *     uint8_t  priority
+ *     uint8_t  base priority
+ *     uint32_t stack high water mark in bytes
+ *     uint32_t run time counter of the task
+ *     uint8_t  name length, followed by the name
+ *   uint8_t  number of queues
+ *     uint16_t items waiting
+ *     uint16_t spaces available
+ *     uint8_t  name length, followed by the name
+ *
+ * The CPU share of a task is the difference of its run time counter between
+ * two frames over the one of the total run time. A frame is self-contained,
+ * so a viewer can attach at any time and skips any bytes up to the next magic,
+ * e.g. the text output of the sketch on the same port.
+ *
+ * A frame takes about 20 bytes plus 16 bytes and the name per task, which at
+ * 115200 baud and one frame per second is a small part of the port. The task
+ * list is read with uxTaskGetSystemState(), which suspends the scheduler while
+ * it scans the stacks for the high water marks, so the period should not be
+ * too short. extras/telemetry/frtop.py shows the frames like top.
+ */
+
+/*-----------------------------------------------------------*/
+
+#define tlmFORMAT_VERSION       ( 1 )
+
+/* Called by the telemetry task to send the bytes of a frame. */
+typedef void ( * TelemetryWrite_t )( const uint8_t * pucData, size_t xLength );
+
+/*
+ * Creates the telemetry task, which sends a frame through pxWrite every
+ * portTELEMETRY_PERIOD_MS. Returns 1 if the task was created, else 0.
+ */
+int xTelemetryStart( TelemetryWrite_t pxWrite );
+
+/*
+ * Adds a queue (or semaphore) to the frames, up to portTELEMETRY_MAX_QUEUES.
+ * The queue must not be deleted afterwards. Returns 1 if it was added, else
+ * 0.
+ */
+int xTelemetryAddQueue( void * pvQueue, const char * pcName );
+
+/*-----------------------------------------------------------*/
+
+#endif /* __TELEMETRY_H__ */
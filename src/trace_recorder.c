@@ -0,0 +1,304 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        trace_recorder.c
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Binary trace recorder, see trace_recorder.h.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if ( portUSE_TRACE_RECORDER == 1 )
+
+/*-----------------------------------------------------------*/
+
+#ifndef portTRACE_TIMESTAMP
+    extern unsigned long micros( void );
+
+    #define portTRACE_TIMESTAMP()       ( ( uint32_t ) micros() )
+    #define portTRACE_TIMESTAMP_NS      ( 1000U )
+#endif
+
+#define trcNUM_RECORDS      ( portTRACE_BUFFER_SIZE / trcRECORD_SIZE )
+
+#if ( trcNUM_RECORDS < 8 ) || ( trcNUM_RECORDS > 0x7FFF )
+    #error "portTRACE_BUFFER_SIZE must hold 8 to 32767 records of 4 bytes."
+#endif
+
+/* The records are written from tasks, from inside the critical sections of
+ * the kernel and from ISRs. The critical sections of the AVR ports save SREG,
+ * so they can be used in all of them. */
+#if defined( __AVR__ )
+    #define trcENTER()      portENTER_CRITICAL()
+    #define trcEXIT()       portEXIT_CRITICAL()
+#else
+    #define trcENTER()      UBaseType_t uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR()
+    #define trcEXIT()       portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus )
+#endif
+
+/*-----------------------------------------------------------*/
+
+typedef struct TraceRecord
+{
+    uint8_t ucEvent;
+    uint8_t ucDelta;
+    uint16_t usObject;
+} TraceRecord_t;
+
+/* Ring of records, the oldest one at usTail. */
+static TraceRecord_t xRecords[ trcNUM_RECORDS ];
+static uint16_t usHead = 0;
+static uint16_t usTail = 0;
+static uint16_t usCount = 0;
+
+static volatile uint8_t ucMode = trcMODE_OFF;
+
+/* Mode given to vTraceStart(), for the header. */
+static uint8_t ucStartMode = trcMODE_OFF;
+static uint8_t ucHeaderPending = pdFALSE;
+
+/* Timestamp of the last record, the next delta is taken from it. */
+static uint32_t ulLastTimestamp = 0;
+
+/* Records dropped in stream mode since the last trcEVENT_DROPPED. */
+static uint16_t usDropped = 0;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Appends a record, overwriting the oldest one in snapshot mode. The caller
+ * has checked that there is room in stream mode.
+ */
+static void prvWrite( uint8_t ucEvent,
+                      uint8_t ucDelta,
+                      uint16_t usObject );
+
+/*
+ * Returns whether usNeeded records can be written. Counts the records as
+ * dropped when not.
+ */
+static BaseType_t prvReserve( uint16_t usNeeded );
+
+/*-----------------------------------------------------------*/
+
+static void prvWrite( uint8_t ucEvent,
+                      uint8_t ucDelta,
+                      uint16_t usObject )
+{
+    TraceRecord_t * pxRecord = &( xRecords[ usHead ] );
+
+    pxRecord->ucEvent = ucEvent;
+    pxRecord->ucDelta = ucDelta;
+    pxRecord->usObject = usObject;
+
+    if( ++usHead == trcNUM_RECORDS )
+    {
+        usHead = 0;
+    }
+
+    if( usCount < trcNUM_RECORDS )
+    {
+        usCount++;
+    }
+    else if( ++usTail == trcNUM_RECORDS )
+    {
+        usTail = 0;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReserve( uint16_t usNeeded )
+{
+    if( ucMode == trcMODE_STREAM )
+    {
+        if( usDropped != 0 )
+        {
+            usNeeded++;
+        }
+
+        if( ( uint16_t ) ( trcNUM_RECORDS - usCount ) < usNeeded )
+        {
+            if( usDropped < UINT16_MAX )
+            {
+                usDropped++;
+            }
+
+            return pdFALSE;
+        }
+
+        if( usDropped != 0 )
+        {
+            prvWrite( trcEVENT_DROPPED, 0, usDropped );
+            usDropped = 0;
+        }
+    }
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRecord( uint8_t ucEvent,
+                   uint16_t usObject )
+{
+    uint32_t ulTimestamp;
+    uint32_t ulDelta;
+
+    if( ucMode == trcMODE_OFF )
+    {
+        return;
+    }
+
+    trcENTER();
+    {
+        ulTimestamp = portTRACE_TIMESTAMP();
+        ulDelta = ulTimestamp - ulLastTimestamp;
+
+        if( prvReserve( ( ulDelta > UINT8_MAX ) ? 2 : 1 ) != pdFALSE )
+        {
+            if( ulDelta > UINT8_MAX )
+            {
+                prvWrite( trcEVENT_TIME, ( uint8_t ) ( ulDelta >> 24 ), ( uint16_t ) ( ulDelta >> 8 ) );
+            }
+
+            prvWrite( ucEvent, ( uint8_t ) ulDelta, usObject );
+            ulLastTimestamp = ulTimestamp;
+        }
+    }
+    trcEXIT();
+}
+/*-----------------------------------------------------------*/
+
+void vTraceName( const void * pvObject,
+                 const char * pcName )
+{
+    uint16_t usLength = 0;
+    uint16_t usObject = trcOBJECT_ID( pvObject );
+
+    if( ( ucMode == trcMODE_OFF ) || ( pcName == NULL ) )
+    {
+        return;
+    }
+
+    while( ( usLength < configMAX_TASK_NAME_LEN ) && ( pcName[ usLength ] != '\0' ) )
+    {
+        usLength++;
+    }
+
+    trcENTER();
+    {
+        if( prvReserve( usLength + 1 ) != pdFALSE )
+        {
+            for( uint16_t x = 0; x < usLength; x++ )
+            {
+                prvWrite( trcEVENT_NAME, ( uint8_t ) pcName[ x ], usObject );
+            }
+
+            prvWrite( trcEVENT_NAME, 0, usObject );
+        }
+    }
+    trcEXIT();
+}
+/*-----------------------------------------------------------*/
+
+void vTraceUserEvent( uint8_t ucId,
+                      uint16_t usValue )
+{
+    vTraceRecord( ( uint8_t ) ( trcEVENT_USER | ( ucId & 0x3F ) ), usValue );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceStart( uint8_t ucNewMode )
+{
+    trcENTER();
+    {
+        usHead = 0;
+        usTail = 0;
+        usCount = 0;
+        usDropped = 0;
+        ucHeaderPending = pdTRUE;
+        ulLastTimestamp = portTRACE_TIMESTAMP();
+        ucStartMode = ucNewMode;
+        ucMode = ucNewMode;
+    }
+    trcEXIT();
+}
+/*-----------------------------------------------------------*/
+
+void vTraceStop( void )
+{
+    ucMode = trcMODE_OFF;
+}
+/*-----------------------------------------------------------*/
+
+size_t xTraceRead( uint8_t * pucBuffer,
+                   size_t xLength )
+{
+    size_t xCopied = 0;
+
+    if( ( ucHeaderPending != pdFALSE ) && ( xLength >= trcHEADER_SIZE ) )
+    {
+        pucBuffer[ 0 ] = 'F';
+        pucBuffer[ 1 ] = 'R';
+        pucBuffer[ 2 ] = 'T';
+        pucBuffer[ 3 ] = 'R';
+        pucBuffer[ 4 ] = trcFORMAT_VERSION;
+        pucBuffer[ 5 ] = ucStartMode;
+        pucBuffer[ 6 ] = ( uint8_t ) ( portTRACE_TIMESTAMP_NS & 0xFF );
+        pucBuffer[ 7 ] = ( uint8_t ) ( portTRACE_TIMESTAMP_NS >> 8 );
+
+        ucHeaderPending = pdFALSE;
+        xCopied = trcHEADER_SIZE;
+    }
+
+    /* One record at a time, to keep the interrupts masked only briefly. */
+    while( ( xLength - xCopied ) >= trcRECORD_SIZE )
+    {
+        TraceRecord_t xRecord;
+        BaseType_t xEmpty;
+
+        trcENTER();
+        {
+            xEmpty = ( usCount == 0 ) ? pdTRUE : pdFALSE;
+
+            if( xEmpty == pdFALSE )
+            {
+                xRecord = xRecords[ usTail ];
+
+                if( ++usTail == trcNUM_RECORDS )
+                {
+                    usTail = 0;
+                }
+
+                usCount--;
+            }
+        }
+        trcEXIT();
+
+        if( xEmpty != pdFALSE )
+        {
+            break;
+        }
+
+        pucBuffer[ xCopied++ ] = xRecord.ucEvent;
+        pucBuffer[ xCopied++ ] = xRecord.ucDelta;
+        pucBuffer[ xCopied++ ] = ( uint8_t ) ( xRecord.usObject & 0xFF );
+        pucBuffer[ xCopied++ ] = ( uint8_t ) ( xRecord.usObject >> 8 );
+    }
+
+    return xCopied;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* portUSE_TRACE_RECORDER */
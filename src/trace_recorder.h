@@ -0,0 +1,213 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file        trace_recorder.h
+ *
+ * @author      Martin Legleiter
+ *
+ * @brief       Binary trace recorder built on the kernel trace macros. Enabled
+ *              with portUSE_TRACE_RECORDER in FreeRTOSConfig.h, which then
+ *              includes this file.
+ *
+ * @copyright   (c) 2024 Martin Legleiter
+ *
+ * @license     Use of this source code is governed by an MIT-style
+ *              license that can be found in the LICENSE file or at
+ *              @see https://opensource.org/licenses/MIT.
+ */
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __TRACE_RECORDER_H__
+#define __TRACE_RECORDER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Every event is one record of 4 bytes:
+ *
+ *   uint8_t  ucEvent   one of the trc... event ids below
+ *   uint8_t  ucDelta   time since the previous event, in timestamp counts
+ *   uint16_t usObject  the task, queue or semaphore, see trcOBJECT_ID()
+ *
+ * A time difference that does not fit into ucDelta is preceded by a
+ * trcEVENT_TIME record holding bits 8 to 31 of it (bits 24 to 31 in ucDelta,
+ * bits 8 to 23 in usObject). The name of an object is written as one
+ * trcEVENT_NAME record per character in ucDelta, ending with a 0 character.
+ * Neither of them advances the time.
+ *
+ * The records are kept in a RAM buffer of portTRACE_BUFFER_SIZE bytes, which
+ * works in one of two modes:
+ *
+ *   trcMODE_SNAPSHOT   the buffer is a ring, the oldest records are
+ *                      overwritten. Stop it with vTraceStop() after the event
+ *                      of interest and read out the last records.
+ *   trcMODE_STREAM     new records are dropped while the buffer is full, and a
+ *                      trcEVENT_DROPPED record with their count is written once
+ *                      there is room again. A task (or loop()) reads the records
+ *                      out continuously, e.g. to Serial.
+ *
+ * xTraceRead() returns an 8 byte header after each vTraceStart() first: the
+ * magic "FRTR", the format version, the mode and the length of one timestamp
+ * count in nanoseconds (uint16_t). extras/trace/trace2perfetto.py converts the
+ * byte stream into the Chrome trace JSON format, which is shown by
+ * https://ui.perfetto.dev and chrome://tracing.
+ *
+ * The object id is the low 16 bits of the address of the object, which is
+ * the full address on the AVR. Names of objects created before vTraceStart()
+ * are not known, nor in snapshot mode the names that were overwritten.
+ *
+ * Each record costs a function call, a timestamp and about 60 cycles on the
+ * AVR. The timestamp is micros() of the Arduino core by default (1 us counts,
+ * resolution 4 us at 16 MHz on the ATmega), portTRACE_TIMESTAMP() and
+ * portTRACE_TIMESTAMP_NS can be defined in FreeRTOSConfig.h to use a finer
+ * timer instead.
+ */
+
+/*-----------------------------------------------------------*/
+
+#define trcMODE_OFF                         ( 0 )
+#define trcMODE_SNAPSHOT                    ( 1 )
+#define trcMODE_STREAM                      ( 2 )
+
+#define trcFORMAT_VERSION                   ( 1 )
+#define trcHEADER_SIZE                      ( 8 )
+#define trcRECORD_SIZE                      ( 4 )
+
+/* Records of the recorder itself. */
+#define trcEVENT_TIME                       ( 0x01 )
+#define trcEVENT_DROPPED                    ( 0x02 )
+#define trcEVENT_NAME                       ( 0x03 )
+
+/* Tasks, the object is the task. */
+#define trcEVENT_TASK_SWITCHED_IN           ( 0x10 )
+#define trcEVENT_TASK_READY                 ( 0x11 )
+#define trcEVENT_TASK_CREATE                ( 0x12 )
+#define trcEVENT_TASK_DELETE                ( 0x13 )
+#define trcEVENT_TASK_DELAY                 ( 0x14 )
+#define trcEVENT_TASK_DELAY_UNTIL           ( 0x15 )
+#define trcEVENT_TASK_SUSPEND               ( 0x16 )
+#define trcEVENT_TASK_RESUME                ( 0x17 )
+#define trcEVENT_TASK_RESUME_FROM_ISR       ( 0x18 )
+#define trcEVENT_TASK_PRIORITY_INHERIT      ( 0x19 )
+#define trcEVENT_TASK_PRIORITY_DISINHERIT   ( 0x1A )
+#define trcEVENT_TASK_NOTIFY                ( 0x1B )
+#define trcEVENT_TASK_NOTIFY_FROM_ISR       ( 0x1C )
+#define trcEVENT_TASK_NOTIFY_TAKE_BLOCK     ( 0x1D )
+#define trcEVENT_TASK_NOTIFY_WAIT_BLOCK     ( 0x1E )
+
+/* Queues, semaphores and mutexes, the object is the queue. The create event
+ * is trcEVENT_QUEUE_CREATE plus the queueQUEUE_TYPE_... of queue.h. */
+#define trcEVENT_QUEUE_CREATE               ( 0x20 )
+#define trcEVENT_QUEUE_DELETE               ( 0x28 )
+#define trcEVENT_QUEUE_SEND                 ( 0x29 )
+#define trcEVENT_QUEUE_SEND_FAILED          ( 0x2A )
+#define trcEVENT_QUEUE_RECEIVE              ( 0x2B )
+#define trcEVENT_QUEUE_RECEIVE_FAILED       ( 0x2C )
+#define trcEVENT_QUEUE_PEEK                 ( 0x2D )
+#define trcEVENT_QUEUE_SEND_FROM_ISR        ( 0x2E )
+#define trcEVENT_QUEUE_RECEIVE_FROM_ISR     ( 0x2F )
+#define trcEVENT_BLOCKING_ON_QUEUE_SEND     ( 0x30 )
+#define trcEVENT_BLOCKING_ON_QUEUE_RECEIVE  ( 0x31 )
+#define trcEVENT_BLOCKING_ON_QUEUE_PEEK     ( 0x32 )
+
+/* Stream and message buffers, the object is the stream buffer. */
+#define trcEVENT_BLOCKING_ON_STREAM_SEND    ( 0x38 )
+#define trcEVENT_BLOCKING_ON_STREAM_RECEIVE ( 0x39 )
+
+/* Tickless idle, no object. */
+#define trcEVENT_LOW_POWER_IDLE_BEGIN       ( 0x40 )
+#define trcEVENT_LOW_POWER_IDLE_END         ( 0x41 )
+
+/* Events of the application, trcEVENT_USER plus an id of 0 to 63 given to
+ * vTraceUserEvent(), the object is its value. */
+#define trcEVENT_USER                       ( 0xC0 )
+
+/*-----------------------------------------------------------*/
+
+#define trcOBJECT_ID( pvObject )            ( ( uint16_t ) ( uintptr_t ) ( pvObject ) )
+
+/*
+ * Clears the buffer and starts recording in trcMODE_SNAPSHOT or trcMODE_STREAM.
+ * Call it before the tasks and queues are created to get their names.
+ */
+void vTraceStart( uint8_t ucMode );
+
+/*
+ * Stops recording. The records in the buffer can still be read.
+ */
+void vTraceStop( void );
+
+/*
+ * Copies the header (once after vTraceStart()) and the oldest records into
+ * pucBuffer and removes them from the trace buffer. Only whole records are
+ * copied, so xLength should be at least trcHEADER_SIZE. Returns the number of
+ * bytes copied, 0 once the buffer is empty.
+ */
+size_t xTraceRead( uint8_t * pucBuffer, size_t xLength );
+
+/*
+ * Records an event of the application, e.g. instead of toggling a pin. ucId
+ * is 0 to 63, usValue is shown with the event.
+ */
+void vTraceUserEvent( uint8_t ucId, uint16_t usValue );
+
+/*
+ * Names an object, e.g. a queue or semaphore, for the converter. Tasks and
+ * queues added to the queue registry are named automatically.
+ */
+void vTraceName( const void * pvObject, const char * pcName );
+
+/* Used by the trace macros below. */
+void vTraceRecord( uint8_t ucEvent, uint16_t usObject );
+
+/*-----------------------------------------------------------*/
+
+/* Kernel trace macros. pxCurrentTCB is only used by the macros expanded in
+ * tasks.c. */
+#define traceTASK_SWITCHED_IN()                         vTraceRecord( trcEVENT_TASK_SWITCHED_IN, trcOBJECT_ID( pxCurrentTCB ) )
+#define traceMOVED_TASK_TO_READY_STATE( pxTCB )         vTraceRecord( trcEVENT_TASK_READY, trcOBJECT_ID( pxTCB ) )
+#define traceTASK_CREATE( pxNewTCB )                                        \
+    do {                                                                    \
+        vTraceRecord( trcEVENT_TASK_CREATE, trcOBJECT_ID( pxNewTCB ) );     \
+        vTraceName( ( pxNewTCB ), ( pxNewTCB )->pcTaskName );               \
+    } while( 0 )
+#define traceTASK_DELETE( pxTaskToDelete )              vTraceRecord( trcEVENT_TASK_DELETE, trcOBJECT_ID( pxTaskToDelete ) )
+#define traceTASK_DELAY()                               vTraceRecord( trcEVENT_TASK_DELAY, trcOBJECT_ID( pxCurrentTCB ) )
+#define traceTASK_DELAY_UNTIL( x )                      vTraceRecord( trcEVENT_TASK_DELAY_UNTIL, trcOBJECT_ID( pxCurrentTCB ) )
+#define traceTASK_SUSPEND( pxTaskToSuspend )            vTraceRecord( trcEVENT_TASK_SUSPEND, trcOBJECT_ID( pxTaskToSuspend ) )
+#define traceTASK_RESUME( pxTaskToResume )              vTraceRecord( trcEVENT_TASK_RESUME, trcOBJECT_ID( pxTaskToResume ) )
+#define traceTASK_RESUME_FROM_ISR( pxTaskToResume )     vTraceRecord( trcEVENT_TASK_RESUME_FROM_ISR, trcOBJECT_ID( pxTaskToResume ) )
+#define traceTASK_PRIORITY_INHERIT( pxTCBOfMutexHolder, uxInheritedPriority )  \
+    vTraceRecord( trcEVENT_TASK_PRIORITY_INHERIT, trcOBJECT_ID( pxTCBOfMutexHolder ) )
+#define traceTASK_PRIORITY_DISINHERIT( pxTCBOfMutexHolder, uxOriginalPriority ) \
+    vTraceRecord( trcEVENT_TASK_PRIORITY_DISINHERIT, trcOBJECT_ID( pxTCBOfMutexHolder ) )
+#define traceTASK_NOTIFY( uxIndexToNotify )             vTraceRecord( trcEVENT_TASK_NOTIFY, trcOBJECT_ID( pxTCB ) )
+#define traceTASK_NOTIFY_FROM_ISR( uxIndexToNotify )    vTraceRecord( trcEVENT_TASK_NOTIFY_FROM_ISR, trcOBJECT_ID( pxTCB ) )
+#define traceTASK_NOTIFY_GIVE_FROM_ISR( uxIndexToNotify ) \
+    vTraceRecord( trcEVENT_TASK_NOTIFY_FROM_ISR, trcOBJECT_ID( pxTCB ) )
+#define traceTASK_NOTIFY_TAKE_BLOCK( uxIndexToWait )    vTraceRecord( trcEVENT_TASK_NOTIFY_TAKE_BLOCK, trcOBJECT_ID( pxCurrentTCB ) )
+#define traceTASK_NOTIFY_WAIT_BLOCK( uxIndexToWait )    vTraceRecord( trcEVENT_TASK_NOTIFY_WAIT_BLOCK, trcOBJECT_ID( pxCurrentTCB ) )
+
+#define traceQUEUE_CREATE( pxNewQueue )                 vTraceRecord( ( uint8_t ) ( trcEVENT_QUEUE_CREATE + ucQueueType ), trcOBJECT_ID( pxNewQueue ) )
+#define traceQUEUE_DELETE( pxQueue )                    vTraceRecord( trcEVENT_QUEUE_DELETE, trcOBJECT_ID( pxQueue ) )
+#define traceQUEUE_SEND( pxQueue )                      vTraceRecord( trcEVENT_QUEUE_SEND, trcOBJECT_ID( pxQueue ) )
+#define traceQUEUE_SEND_FAILED( pxQueue )               vTraceRecord( trcEVENT_QUEUE_SEND_FAILED, trcOBJECT_ID( pxQueue ) )
+#define traceQUEUE_RECEIVE( pxQueue )                   vTraceRecord( trcEVENT_QUEUE_RECEIVE, trcOBJECT_ID( pxQueue ) )
+#define traceQUEUE_RECEIVE_FAILED( pxQueue )            vTraceRecord( trcEVENT_QUEUE_RECEIVE_FAILED, trcOBJECT_ID( pxQueue ) )
+#define traceQUEUE_PEEK( pxQueue )                      vTraceRecord( trcEVENT_QUEUE_PEEK, trcOBJECT_ID( pxQueue ) )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue )             vTraceRecord( trcEVENT_QUEUE_SEND_FROM_ISR, trcOBJECT_ID( pxQueue ) )
+#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue )          vTraceRecord( trcEVENT_QUEUE_RECEIVE_FROM_ISR, trcOBJECT_ID( pxQueue ) )
+#define traceBLOCKING_ON_QUEUE_SEND( pxQueue )          vTraceRecord( trcEVENT_BLOCKING_ON_QUEUE_SEND, trcOBJECT_ID( pxQueue ) )
+#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue )       vTraceRecord( trcEVENT_BLOCKING_ON_QUEUE_RECEIVE, trcOBJECT_ID( pxQueue ) )
+#define traceBLOCKING_ON_QUEUE_PEEK( pxQueue )          vTraceRecord( trcEVENT_BLOCKING_ON_QUEUE_PEEK, trcOBJECT_ID( pxQueue ) )
+#define traceQUEUE_REGISTRY_ADD( xQueue, pcQueueName )  vTraceName( ( xQueue ), ( pcQueueName ) )
+
+#define traceBLOCKING_ON_STREAM_BUFFER_SEND( xStreamBuffer )    vTraceRecord( trcEVENT_BLOCKING_ON_STREAM_SEND, trcOBJECT_ID( xStreamBuffer ) )
+#define traceBLOCKING_ON_STREAM_BUFFER_RECEIVE( xStreamBuffer ) vTraceRecord( trcEVENT_BLOCKING_ON_STREAM_RECEIVE, trcOBJECT_ID( xStreamBuffer ) )
+
+#define traceLOW_POWER_IDLE_BEGIN()                     vTraceRecord( trcEVENT_LOW_POWER_IDLE_BEGIN, 0 )
+#define traceLOW_POWER_IDLE_END()                       vTraceRecord( trcEVENT_LOW_POWER_IDLE_END, 0 )
+
+/*-----------------------------------------------------------*/
+
+#endif /* __TRACE_RECORDER_H__ */